@@ -0,0 +1,118 @@
+#include <renderer/Math/Batch.hpp>
+
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+// throughput of the structure of arrays kernels, every path over the same working set
+namespace
+{
+	const int COUNT = 4096;
+	const int PASSES = 2000;
+
+	volatile float sink;
+
+	struct Columns
+	{
+		std::vector<float> x, y, z;
+
+		Columns(std::mt19937& gen, float low, float high)
+		{
+			std::uniform_real_distribution<float> distribution(low, high);
+			for(int i=0;i<COUNT;++i)
+			{
+				x.push_back(distribution(gen));
+				y.push_back(distribution(gen));
+				z.push_back(distribution(gen));
+			}
+		}
+
+		Renderer::Batch::Points points() const { return { x.data(), y.data(), z.data() }; }
+	};
+
+	template<typename F>
+	void run(const char* name, F&& pass)
+	{
+		pass();
+
+		auto start = std::chrono::steady_clock::now();
+		for(int i=0;i<PASSES;++i)
+			pass();
+		double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+		double points = static_cast<double>(COUNT) * PASSES;
+		std::printf("%-30s %8.2f ns/point %10.2f Mpoints/s\n", name, seconds * 1e9 / points, points / seconds * 1e-6);
+	}
+
+	// the same four kernels through one path, Scalar or Avx2
+	#define BATCH_CASES(path) \
+		run(#path " transform", [&]() { \
+			Renderer::Batch::path::transformPoints(viewProjection, positions.points(), out, COUNT); \
+			sink = out.w[COUNT - 1]; \
+		}); \
+		run(#path " view depth", [&]() { \
+			Renderer::Batch::path::viewDepths(view, positions.points(), depth.data(), COUNT); \
+			sink = depth[COUNT - 1]; \
+		}); \
+		run(#path " cull spheres", [&]() { \
+			Renderer::Batch::path::cullSpheres(frustum, positions.points(), radius.data(), visible.data(), COUNT); \
+			sink = visible[COUNT - 1]; \
+		}); \
+		run(#path " cull boxes", [&]() { \
+			Renderer::Batch::path::cullBoxes(frustum, boxMin.points(), boxMax.points(), visible.data(), COUNT); \
+			sink = visible[COUNT - 1]; \
+		});
+}
+
+int main()
+{
+	std::mt19937 gen(1234);
+
+	// the scene camera, about half of the points end up inside the frustum
+	float fov = 3.14159265f / 4.f;
+	float far = 5000.f;
+	float near = 1.f;
+	Renderer::Mat4<float> projection(
+			1.f / (4.f / 3.f * std::tan(fov / 2.f)), 0.f, 0.f, 0.f,
+			0.f, 1.f / std::tan(fov / 2.f), 0.f, 0.f,
+			0.f, 0.f, -(far + near) / (far - near), -2.f * far * near / (far - near),
+			0.f, 0.f, -1.f, 0.f
+	);
+	Renderer::Mat4<float> view(
+			1.f, 0.f, 0.f, 0.f,
+			0.f, 1.f, 0.f, -2.f,
+			0.f, 0.f, 1.f, 0.f,
+			0.f, 0.f, 0.f, 1.f
+	);
+	Renderer::Mat4<float> viewProjection = projection * view;
+	Renderer::Batch::Frustum frustum = Renderer::Batch::Frustum::fromMatrix(viewProjection);
+
+	Columns positions(gen, -200.f, 200.f);
+	Columns boxMin(gen, -200.f, 200.f);
+	Columns boxMax = boxMin;
+	std::vector<float> radius;
+	for(int i=0;i<COUNT;++i)
+	{
+		boxMax.x[i] += 4.f;
+		boxMax.y[i] += 4.f;
+		boxMax.z[i] += 4.f;
+		radius.push_back(4.f);
+	}
+
+	std::vector<float> ox(COUNT), oy(COUNT), oz(COUNT), ow(COUNT), depth(COUNT);
+	std::vector<uint8_t> visible(COUNT);
+	Renderer::Batch::TransformedPoints out{ ox.data(), oy.data(), oz.data(), ow.data() };
+
+	BATCH_CASES(Scalar)
+#if defined(RENDERER_BATCH_AVX2)
+	if(Renderer::Batch::hasAvx2())
+	{
+		BATCH_CASES(Avx2)
+	}
+	else
+		std::printf("no avx2 on this cpu, skipping the wide path\n");
+#endif
+
+	return 0;
+}
@@ -0,0 +1,146 @@
+#include <renderer/Math/Vector.hpp>
+#include <renderer/Math/Matrix.hpp>
+
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+// throughput of the math types over a working set that stays in cache
+namespace
+{
+	const int COUNT = 1024;
+	const int PASSES = 2000;
+
+	// keeps results alive without the optimizer seeing through them
+	volatile float sink;
+
+	float randomFloat(std::mt19937& gen)
+	{
+		return std::uniform_real_distribution<float>(-1.f, 1.f)(gen);
+	}
+
+	Renderer::Mat4<float> randomMatrix(std::mt19937& gen)
+	{
+		// diagonally dominant so every matrix is invertible
+		Renderer::Mat4<float> m;
+		for(int r=0;r<4;++r)
+			for(int c=0;c<4;++c)
+				m.set(r, c, randomFloat(gen) + (r == c ? 4.f : 0.f));
+
+		return m;
+	}
+
+	template<typename F>
+	void run(const char* name, F&& pass)
+	{
+		// one pass untimed to warm the caches
+		pass();
+
+		auto start = std::chrono::steady_clock::now();
+		for(int i=0;i<PASSES;++i)
+			pass();
+		double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+		double ops = static_cast<double>(COUNT) * PASSES;
+		std::printf("%-22s %8.2f ns/op %10.2f Mop/s\n", name, seconds * 1e9 / ops, ops / seconds * 1e-6);
+	}
+}
+
+int main()
+{
+	std::mt19937 gen(1234);
+
+	std::vector<Renderer::Mat4<float>> matrices;
+	std::vector<Renderer::Mat4<float>> results(COUNT);
+	std::vector<Renderer::Vec4<float>> vectors;
+	std::vector<Renderer::Vec4<float>> transformed(COUNT);
+	std::vector<Renderer::Vec3<float>> points;
+	std::vector<Renderer::Vec3<float>> moved(COUNT);
+	for(int i=0;i<COUNT;++i)
+	{
+		matrices.push_back(randomMatrix(gen));
+		vectors.push_back(Renderer::Vec4<float>(randomFloat(gen), randomFloat(gen), randomFloat(gen), 1.f));
+		points.push_back(Renderer::Vec3<float>(randomFloat(gen), randomFloat(gen), randomFloat(gen)));
+	}
+
+	std::printf("sizeof Vec3 %zu, Vec4 %zu, Mat4 %zu\n",
+			sizeof(Renderer::Vec3<float>), sizeof(Renderer::Vec4<float>), sizeof(Renderer::Mat4<float>));
+
+	run("mat4 * mat4", [&]() {
+		for(int i=0;i<COUNT;++i)
+			results[i] = matrices[i] * matrices[(i + 1) % COUNT];
+		sink = (*results[COUNT - 1])[0];
+	});
+
+	run("mat4 * vec4", [&]() {
+		for(int i=0;i<COUNT;++i)
+			transformed[i] = matrices[i] * vectors[i];
+		sink = transformed[COUNT - 1].x;
+	});
+
+	run("mat4 transpose", [&]() {
+		for(int i=0;i<COUNT;++i)
+		{
+			results[i] = matrices[i];
+			results[i].transpose();
+		}
+		sink = (*results[COUNT - 1])[1];
+	});
+
+	run("mat4 inverse", [&]() {
+		for(int i=0;i<COUNT;++i)
+		{
+			results[i] = matrices[i];
+			results[i].inverse();
+		}
+		sink = (*results[COUNT - 1])[0];
+	});
+
+	run("mat4 copy", [&]() {
+		for(int i=0;i<COUNT;++i)
+			results[i] = matrices[(i + 7) % COUNT];
+		sink = (*results[COUNT - 1])[0];
+	});
+
+	run("vec4 madd", [&]() {
+		for(int i=0;i<COUNT;++i)
+			transformed[i] = vectors[i] * vectors[(i + 1) % COUNT] + transformed[i];
+		sink = transformed[COUNT - 1].y;
+	});
+
+	// the camera update in Scene::Update, several terms folded into one vector
+	run("vec3 chain", [&]() {
+		for(int i=0;i<COUNT;++i)
+			moved[i] = points[i] + points[(i + 1) % COUNT] * -0.01f + points[(i + 2) % COUNT] * 0.02f;
+		sink = moved[COUNT - 1].x;
+	});
+
+	run("vec4 chain", [&]() {
+		for(int i=0;i<COUNT;++i)
+			transformed[i] = vectors[i] * 0.5f + transformed[i] - vectors[(i + 1) % COUNT] * vectors[(i + 2) % COUNT];
+		sink = transformed[COUNT - 1].z;
+	});
+
+	run("mat4 chain", [&]() {
+		for(int i=0;i<COUNT;++i)
+			results[i] = matrices[i] + matrices[(i + 1) % COUNT] - matrices[(i + 2) % COUNT];
+		sink = (*results[COUNT - 1])[5];
+	});
+
+	run("vec3 cross + dot", [&]() {
+		float sum = 0.f;
+		for(int i=0;i<COUNT;++i)
+			sum += points[i].cross(points[(i + 1) % COUNT]).dot(points[(i + 2) % COUNT]);
+		sink = sum;
+	});
+
+	run("vec3 checked get", [&]() {
+		float sum = 0.f;
+		for(int i=0;i<COUNT;++i)
+			sum += points[i].get(0) + points[i].get(1) + points[i].get(2);
+		sink = sum;
+	});
+
+	return 0;
+}
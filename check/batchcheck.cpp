@@ -0,0 +1,360 @@
+#include <renderer/Math/Batch.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+
+// the structure of arrays kernels, exits non zero on a mismatch. the scalar path is held to
+// references in double written without the kernels' tricks, every other path has to match the
+// scalar one bit for bit, over counts that leave every tail length and starts that are unaligned
+namespace
+{
+	const int COUNTS[] = { 0, 1, 7, 8, 9, 15, 16, 17, 31, 1000, 4099 };
+	const int MAX_COUNT = 4099;
+
+	int checks = 0;
+	int failures = 0;
+
+	void fail(const char* path, const char* name, int count, int index, double value, double reference)
+	{
+		if(++failures <= 20)
+			std::printf("  %s %s count %d entry %d: %.9g, expected %.9g\n", path, name, count, index, value, reference);
+	}
+
+	// against the sum of the magnitudes of the terms, cancellation leaves only their rounding
+	void expectNear(const char* path, const char* name, int count, int index, float value, double reference, double magnitude)
+	{
+		++checks;
+		if(std::fabs(value - reference) > 1e-6 * std::max(1.0, magnitude))
+			fail(path, name, count, index, value, reference);
+	}
+
+	void expectSame(const char* path, const char* name, int count, const float* value, const float* reference)
+	{
+		for(int i=0;i<count;++i)
+		{
+			++checks;
+			if(std::memcmp(value + i, reference + i, sizeof(float)) != 0)
+				fail(path, name, count, i, value[i], reference[i]);
+		}
+	}
+
+	void expectSame(const char* path, const char* name, int count, const uint8_t* value, const uint8_t* reference)
+	{
+		for(int i=0;i<count;++i)
+		{
+			++checks;
+			if(value[i] != reference[i])
+				fail(path, name, count, i, value[i], reference[i]);
+		}
+	}
+
+	struct Columns
+	{
+		std::vector<float> x, y, z;
+
+		Columns(std::mt19937& gen, float low, float high)
+		{
+			std::uniform_real_distribution<float> distribution(low, high);
+			for(int i=0;i<MAX_COUNT+1;++i)
+			{
+				x.push_back(distribution(gen));
+				y.push_back(distribution(gen));
+				z.push_back(distribution(gen));
+			}
+		}
+
+		Renderer::Batch::Points points(int _offset) const { return { x.data() + _offset, y.data() + _offset, z.data() + _offset }; }
+	};
+
+	// one set of outputs, a guard entry past the end catches writes beyond the count
+	struct Outputs
+	{
+		static constexpr float GUARD = 12345.f;
+
+		std::vector<float> x, y, z, w, depth;
+		std::vector<uint8_t> spheres, boxes;
+
+		Outputs()
+			: x(MAX_COUNT + 1, GUARD), y(MAX_COUNT + 1, GUARD), z(MAX_COUNT + 1, GUARD), w(MAX_COUNT + 1, GUARD),
+			depth(MAX_COUNT + 1, GUARD), spheres(MAX_COUNT + 1, 7), boxes(MAX_COUNT + 1, 7)
+		{ }
+
+		Renderer::Batch::TransformedPoints transformed(bool _withW) { return { x.data(), y.data(), z.data(), _withW ? w.data() : nullptr }; }
+
+		bool guarded(int _count) const
+		{
+			return x[_count] == GUARD && y[_count] == GUARD && z[_count] == GUARD && w[_count] == GUARD &&
+				depth[_count] == GUARD && spheres[_count] == 7 && boxes[_count] == 7;
+		}
+	};
+
+	struct Path
+	{
+		const char* name;
+		void (*transformPoints)(const Renderer::Mat4<float>&, Renderer::Batch::Points, Renderer::Batch::TransformedPoints, int);
+		void (*viewDepths)(const Renderer::Mat4<float>&, Renderer::Batch::Points, float*, int);
+		void (*cullSpheres)(const Renderer::Batch::Frustum&, Renderer::Batch::Points, const float*, uint8_t*, int);
+		void (*cullBoxes)(const Renderer::Batch::Frustum&, Renderer::Batch::Points, Renderer::Batch::Points, uint8_t*, int);
+	};
+
+	struct Scene
+	{
+		Renderer::Mat4<float> view;
+		Renderer::Mat4<float> viewProjection;
+		Renderer::Batch::Frustum frustum;
+		// the frustum planes derived again in double
+		double planes[6][4];
+	};
+
+	void run(const Path& _path, const Scene& _scene, const Columns& _positions, const std::vector<float>& _radius,
+			const Columns& _boxMin, const Columns& _boxMax, int _offset, int _count, bool _withW, Outputs& _out)
+	{
+		_path.transformPoints(_scene.viewProjection, _positions.points(_offset), _out.transformed(_withW), _count);
+		_path.viewDepths(_scene.view, _positions.points(_offset), _out.depth.data(), _count);
+		_path.cullSpheres(_scene.frustum, _positions.points(_offset), _radius.data() + _offset, _out.spheres.data(), _count);
+		_path.cullBoxes(_scene.frustum, _boxMin.points(_offset), _boxMax.points(_offset), _out.boxes.data(), _count);
+	}
+
+	double planeDistance(const double _plane[4], double _x, double _y, double _z)
+	{
+		return _plane[0] * _x + _plane[1] * _y + _plane[2] * _z + _plane[3];
+	}
+
+	// entries this close to a plane may land on either side in float, they are left out
+	const double AMBIGUOUS = 1e-3;
+
+	void checkScalar(const Scene& _scene, const Columns& _positions, const std::vector<float>& _radius,
+			const Columns& _boxMin, const Columns& _boxMax, int _offset, int _count, const Outputs& _out)
+	{
+		const Renderer::Mat4<float>& m = _scene.viewProjection;
+		for(int i=0;i<_count;++i)
+		{
+			int j = i + _offset;
+			double p[4] = { _positions.x[j], _positions.y[j], _positions.z[j], 1.0 };
+			double clip[4];
+			for(int r=0;r<4;++r)
+			{
+				double sum = 0.0, magnitude = 0.0;
+				for(int c=0;c<4;++c)
+				{
+					sum += static_cast<double>(m(r, c)) * p[c];
+					magnitude += std::fabs(static_cast<double>(m(r, c)) * p[c]);
+				}
+				clip[r] = sum;
+
+				const float* outputs[4] = { _out.x.data(), _out.y.data(), _out.z.data(), _out.w.data() };
+				expectNear("scalar", "transform", _count, i, outputs[r][i], sum, magnitude);
+			}
+
+			double depth = 0.0, magnitude = 0.0;
+			for(int c=0;c<4;++c)
+			{
+				depth -= static_cast<double>(_scene.view(2, c)) * p[c];
+				magnitude += std::fabs(static_cast<double>(_scene.view(2, c)) * p[c]);
+			}
+			expectNear("scalar", "view depth", _count, i, _out.depth[i], depth, magnitude);
+
+			// outside when behind any plane by more than the radius
+			bool outside = false, ambiguous = false;
+			for(int q=0;q<6;++q)
+			{
+				double distance = planeDistance(_scene.planes[q], p[0], p[1], p[2]) + _radius[j];
+				outside |= distance < 0.0;
+				ambiguous |= std::fabs(distance) < AMBIGUOUS;
+			}
+			if(!ambiguous)
+			{
+				++checks;
+				if(_out.spheres[i] != !outside)
+					fail("scalar", "cull spheres", _count, i, _out.spheres[i], !outside);
+			}
+
+			// a point is inside the frustum exactly when its clip coordinates are within w
+			if(_radius[j] == 0.f)
+			{
+				bool inside = true;
+				ambiguous = false;
+				for(int r=0;r<3;++r)
+				{
+					inside &= std::fabs(clip[r]) <= clip[3];
+					ambiguous |= std::fabs(std::fabs(clip[r]) - clip[3]) < AMBIGUOUS;
+				}
+				if(!ambiguous)
+				{
+					++checks;
+					if(_out.spheres[i] != inside)
+						fail("scalar", "cull points against clip space", _count, i, _out.spheres[i], inside);
+				}
+			}
+
+			// outside when all eight corners are behind one plane
+			outside = false;
+			ambiguous = false;
+			for(int q=0;q<6;++q)
+			{
+				double furthest = -1e30;
+				for(int corner=0;corner<8;++corner)
+				{
+					double x = corner & 1 ? _boxMax.x[j] : _boxMin.x[j];
+					double y = corner & 2 ? _boxMax.y[j] : _boxMin.y[j];
+					double z = corner & 4 ? _boxMax.z[j] : _boxMin.z[j];
+					furthest = std::max(furthest, planeDistance(_scene.planes[q], x, y, z));
+				}
+				outside |= furthest < 0.0;
+				ambiguous |= std::fabs(furthest) < AMBIGUOUS;
+			}
+			if(!ambiguous)
+			{
+				++checks;
+				if(_out.boxes[i] != !outside)
+					fail("scalar", "cull boxes", _count, i, _out.boxes[i], !outside);
+			}
+		}
+
+		++checks;
+		if(!_out.guarded(_count))
+			fail("scalar", "write past the count", _count, _count, 0, 0);
+	}
+
+	void checkSame(const char* _path, int _count, bool _withW, const Outputs& _out, const Outputs& _scalar)
+	{
+		expectSame(_path, "transform x", _count, _out.x.data(), _scalar.x.data());
+		expectSame(_path, "transform y", _count, _out.y.data(), _scalar.y.data());
+		expectSame(_path, "transform z", _count, _out.z.data(), _scalar.z.data());
+		if(_withW)
+			expectSame(_path, "transform w", _count, _out.w.data(), _scalar.w.data());
+		expectSame(_path, "view depth", _count, _out.depth.data(), _scalar.depth.data());
+		expectSame(_path, "cull spheres", _count, _out.spheres.data(), _scalar.spheres.data());
+		expectSame(_path, "cull boxes", _count, _out.boxes.data(), _scalar.boxes.data());
+
+		++checks;
+		if(!_out.guarded(_count))
+			fail(_path, "write past the count", _count, _count, 0, 0);
+	}
+
+	Scene makeScene(float _yaw)
+	{
+		// the scene camera turned about y and lifted, so every plane has a different normal
+		float fov = 3.14159265f / 4.f;
+		float far = 5000.f;
+		float near = 1.f;
+		Renderer::Mat4<float> projection(
+				1.f / (4.f / 3.f * std::tan(fov / 2.f)), 0.f, 0.f, 0.f,
+				0.f, 1.f / std::tan(fov / 2.f), 0.f, 0.f,
+				0.f, 0.f, -(far + near) / (far - near), -2.f * far * near / (far - near),
+				0.f, 0.f, -1.f, 0.f
+		);
+		float c = std::cos(_yaw), s = std::sin(_yaw);
+
+		Scene scene;
+		scene.view = Renderer::Mat4<float>(
+				c, 0.f, -s, 3.f,
+				0.f, 1.f, 0.f, -2.f,
+				s, 0.f, c, 5.f,
+				0.f, 0.f, 0.f, 1.f
+		);
+		scene.viewProjection = projection * scene.view;
+		scene.frustum = Renderer::Batch::Frustum::fromMatrix(scene.viewProjection);
+
+		// w + x, w - x, w + y, w - y, w + z and w - z
+		for(int q=0;q<6;++q)
+		{
+			double length = 0.0;
+			for(int k=0;k<4;++k)
+			{
+				scene.planes[q][k] = static_cast<double>(scene.viewProjection(3, k)) +
+					(q % 2 ? -1.0 : 1.0) * scene.viewProjection(q / 2, k);
+				if(k < 3)
+					length += scene.planes[q][k] * scene.planes[q][k];
+			}
+			for(int k=0;k<4;++k)
+				scene.planes[q][k] /= std::sqrt(length);
+		}
+
+		return scene;
+	}
+}
+
+int main()
+{
+	std::mt19937 gen(1234);
+
+	Columns positions(gen, -200.f, 200.f);
+	Columns boxMin(gen, -200.f, 200.f);
+	Columns boxMax = boxMin;
+	std::vector<float> radius;
+	std::uniform_real_distribution<float> extent(0.f, 20.f);
+	for(int i=0;i<MAX_COUNT+1;++i)
+	{
+		boxMax.x[i] += extent(gen);
+		boxMax.y[i] += extent(gen);
+		boxMax.z[i] += extent(gen);
+		// every fourth sphere is a point, which the clip space test covers
+		radius.push_back(i % 4 ? extent(gen) : 0.f);
+	}
+
+	const Path scalar = { "scalar", Renderer::Batch::Scalar::transformPoints, Renderer::Batch::Scalar::viewDepths,
+		Renderer::Batch::Scalar::cullSpheres, Renderer::Batch::Scalar::cullBoxes };
+
+	std::vector<Path> paths;
+	paths.push_back({ "dispatch", Renderer::Batch::transformPoints, Renderer::Batch::viewDepths,
+		Renderer::Batch::cullSpheres, Renderer::Batch::cullBoxes });
+#if defined(RENDERER_BATCH_AVX2)
+	if(Renderer::Batch::hasAvx2())
+		paths.push_back({ "avx2", Renderer::Batch::Avx2::transformPoints, Renderer::Batch::Avx2::viewDepths,
+			Renderer::Batch::Avx2::cullSpheres, Renderer::Batch::Avx2::cullBoxes });
+	else
+		std::printf("no avx2 on this cpu, the wide path is not checked\n");
+#endif
+
+	for(float yaw : { 0.f, 0.7f, 2.5f })
+	{
+		Scene scene = makeScene(yaw);
+
+		// every eighth entry is a point or a small box straight ahead, either side of the near and
+		// far planes, which random positions around the camera almost never reach
+		Columns points = positions;
+		Columns pointMin = boxMin;
+		Columns pointMax = boxMax;
+		Renderer::Mat4<float> world = scene.view;
+		world.inverse();
+		const float depths[] = { 0.25f, 0.75f, 1.5f, 4000.f, 4990.f, 5010.f, 6000.f };
+		std::uniform_real_distribution<float> lateral(-0.2f, 0.2f);
+		for(int i=0;i<MAX_COUNT+1;i+=8)
+		{
+			float depth = depths[(i / 8) % 7];
+			Renderer::Vec4<float> p = world * Renderer::Vec4<float>(lateral(gen) * depth, lateral(gen) * depth, -depth, 1.f);
+			points.x[i] = pointMin.x[i] = p.x;
+			points.y[i] = pointMin.y[i] = p.y;
+			points.z[i] = pointMin.z[i] = p.z;
+			pointMax.x[i] = p.x + 0.1f;
+			pointMax.y[i] = p.y + 0.1f;
+			pointMax.z[i] = p.z + 0.1f;
+		}
+
+		for(int count : COUNTS)
+			for(int offset : { 0, 1 })
+				for(bool with_w : { true, false })
+				{
+					Outputs reference;
+					run(scalar, scene, points, radius, pointMin, pointMax, offset, count, with_w, reference);
+					if(with_w)
+						checkScalar(scene, points, radius, pointMin, pointMax, offset, count, reference);
+
+					for(const Path& path : paths)
+					{
+						Outputs out;
+						run(path, scene, points, radius, pointMin, pointMax, offset, count, with_w, out);
+						checkSame(path.name, count, with_w, out, reference);
+					}
+				}
+	}
+
+	std::printf("batchcheck (%s): %d checks, %d failed\n", Renderer::Batch::hasAvx2() ? "scalar and avx2" : "scalar",
+			checks, failures);
+	return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,126 @@
+#include "../src/gl/environmentmap.hpp"
+#include "../src/utils.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <vector>
+
+// the environment prefilter, exits non zero on a mismatch. a constant sky has to come out of every
+// level unchanged, which holds the texel arithmetic of each build to the exact average. the sse2 build
+// then writes its bake of a varied sky and the portable build has to match it within a tolerance
+namespace
+{
+	// make check runs from the root of the tree, the sse2 build before the portable one
+	const char* BAKE_PATH = "./obj/check/envcheck.bake";
+
+	const unsigned int FACE_SIZE = 16;
+	const unsigned int LEVELS = 5;
+	const unsigned int SAMPLES = 64;
+
+	int checks = 0;
+	int failures = 0;
+
+	void expectNear(const char* name, unsigned int level, int face, std::size_t index, float value, float reference,
+			double tolerance)
+	{
+		++checks;
+		if(std::fabs(value - reference) <= tolerance * std::max(1.0, std::fabs(static_cast<double>(reference))))
+			return;
+
+		if(++failures <= 20)
+			std::printf("  %s level %u face %d texel %zu: %.9g, expected %.9g\n", name, level, face, index, value, reference);
+	}
+
+	FloatImage makeSky(bool constant)
+	{
+		FloatImage sky;
+		sky.width = 64;
+		sky.height = 32;
+		sky.texels.resize(static_cast<std::size_t>(sky.width) * sky.height * 4);
+
+		for(unsigned int y=0;y<sky.height;++y)
+			for(unsigned int x=0;x<sky.width;++x)
+			{
+				float* texel = sky.texels.data() + (static_cast<std::size_t>(y) * sky.width + x) * 4;
+				float u = (x + 0.5f) / sky.width;
+				float v = (y + 0.5f) / sky.height;
+
+				// smooth bands with a sun well past 1, the bake keeps hdr values as they are
+				bool sun = x >= 40 && x < 43 && y >= 8 && y < 10;
+				texel[0] = constant ? 0.25f : 0.5f + 0.5f * std::sin(2.f * PI * u) + (sun ? 20.f : 0.f);
+				texel[1] = constant ? 0.5f : v + (sun ? 18.f : 0.f);
+				texel[2] = constant ? 2.f : 0.5f + 0.5f * std::cos(4.f * PI * u) * std::sin(PI * v);
+				texel[3] = 1.f;
+			}
+
+		return sky;
+	}
+
+	void checkConstant(ThreadPool& pool)
+	{
+		const float expected[4] = { 0.25f, 0.5f, 2.f, 1.f };
+		std::vector<CubeLevel> cube = EnvironmentMap::bake(makeSky(true), FACE_SIZE, LEVELS, SAMPLES, pool);
+
+		for(unsigned int level=0;level<cube.size();++level)
+			for(int face=0;face<6;++face)
+				for(std::size_t i=0;i<cube[level].faces[face].size();++i)
+					expectNear("constant sky", level, face, i, cube[level].faces[face][i], expected[i % 4], 1e-5);
+	}
+
+	void checkAgainstSse2(ThreadPool& pool)
+	{
+		std::vector<CubeLevel> cube = EnvironmentMap::bake(makeSky(false), FACE_SIZE, LEVELS, SAMPLES, pool);
+
+#if defined(__SSE2__)
+		std::ofstream file(BAKE_PATH, std::ios::binary);
+		for(const CubeLevel& level : cube)
+			for(const std::vector<float>& face : level.faces)
+				file.write(reinterpret_cast<const char*>(face.data()), static_cast<std::streamsize>(face.size() * sizeof(float)));
+
+		++checks;
+		if(!file && ++failures <= 20)
+			std::printf("  unable to write %s\n", BAKE_PATH);
+#else
+		// without an sse2 build there is nothing to compare against, the constant sky still ran
+		std::ifstream file(BAKE_PATH, std::ios::binary);
+		if(!file)
+			return;
+
+		for(unsigned int level=0;level<cube.size();++level)
+			for(int face=0;face<6;++face)
+			{
+				const std::vector<float>& texels = cube[level].faces[face];
+				std::vector<float> reference(texels.size());
+				file.read(reinterpret_cast<char*>(reference.data()), static_cast<std::streamsize>(reference.size() * sizeof(float)));
+				if(!file)
+				{
+					++checks;
+					++failures;
+					std::printf("  %s is shorter than the bake, rebuild the sse2 check\n", BAKE_PATH);
+					return;
+				}
+
+				for(std::size_t i=0;i<texels.size();++i)
+					expectNear("portable against sse2", level, face, i, texels[i], reference[i], 1e-4);
+			}
+#endif
+	}
+}
+
+int main()
+{
+	ThreadPool pool;
+
+	checkConstant(pool);
+	checkAgainstSse2(pool);
+
+#if defined(__SSE2__)
+	const char* texels = "sse2";
+#else
+	const char* texels = "portable";
+#endif
+	std::printf("envcheck (%s texels): %d checks, %d failed\n", texels, checks, failures);
+	return failures == 0 ? 0 : 1;
+}
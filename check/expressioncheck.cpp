@@ -0,0 +1,172 @@
+#include <renderer/Math/Vector.hpp>
+#include <renderer/Math/Matrix.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <type_traits>
+
+// expression trees against the same arithmetic written out per element in double, exits non zero
+// on a mismatch. the float 4 wide types go through packets, every other type element by element
+namespace
+{
+	const int ROUNDS = 1000;
+
+	int checks = 0;
+	int failures = 0;
+
+	void expectNear(const char* name, const char* type, int index, double value, double reference)
+	{
+		++checks;
+		if(std::fabs(value - reference) <= 1e-5 * std::max(1.0, std::fabs(reference)))
+			return;
+
+		if(++failures <= 20)
+			std::printf("  %s %s element %d: %.9g, expected %.9g\n", type, name, index, value, reference);
+	}
+
+	template<typename E>
+	void expectElements(const char* name, const char* type, const E& value, const double* reference)
+	{
+		for(int i=0;i<E::Elements;++i)
+			expectNear(name, type, i, value.m_data[i], reference[i]);
+	}
+
+	template<typename E>
+	void randomize(E& _value, std::mt19937& gen)
+	{
+		std::uniform_real_distribution<float> distribution(-1.f, 1.f);
+		for(int i=0;i<E::Elements;++i)
+			_value.m_data[i] = distribution(gen);
+	}
+
+	template<typename E>
+	void checkArithmetic(const char* type, std::mt19937& gen)
+	{
+		typedef typename E::Scalar T;
+		constexpr int N = E::Elements;
+		constexpr bool vector = Renderer::isKind<E, Renderer::VectorKind>;
+
+		for(int round=0;round<ROUNDS;++round)
+		{
+			E a(Renderer::NoInit{}), b(Renderer::NoInit{}), c(Renderer::NoInit{});
+			randomize(a, gen);
+			randomize(b, gen);
+			randomize(c, gen);
+			T s = std::uniform_real_distribution<float>(0.5f, 2.f)(gen);
+
+			double reference[N];
+
+			E sum = a + b;
+			for(int i=0;i<N;++i)
+				reference[i] = static_cast<double>(a.m_data[i]) + b.m_data[i];
+			expectElements("a + b", type, sum, reference);
+
+			E difference = a - b;
+			for(int i=0;i<N;++i)
+				reference[i] = static_cast<double>(a.m_data[i]) - b.m_data[i];
+			expectElements("a - b", type, difference, reference);
+
+			E chain = a + b * s - c;
+			for(int i=0;i<N;++i)
+				reference[i] = static_cast<double>(a.m_data[i]) + static_cast<double>(b.m_data[i]) * s - c.m_data[i];
+			expectElements("a + b * s - c", type, chain, reference);
+
+			E scaled = s * a / s - -b;
+			for(int i=0;i<N;++i)
+				reference[i] = static_cast<double>(a.m_data[i]) + b.m_data[i];
+			expectElements("s * a / s - -b", type, scaled, reference);
+
+			// every element only reads its own, so a tree may be stored into one of its operands
+			E aliased = a;
+			aliased = b - aliased * s;
+			for(int i=0;i<N;++i)
+				reference[i] = static_cast<double>(b.m_data[i]) - static_cast<double>(a.m_data[i]) * s;
+			expectElements("a = b - a * s", type, aliased, reference);
+
+			// the inner node is a temporary, the tree holds its own copy of it
+			auto tree = (a + b) * s;
+			E later = tree;
+			for(int i=0;i<N;++i)
+				reference[i] = (static_cast<double>(a.m_data[i]) + b.m_data[i]) * s;
+			expectElements("tree over a temporary", type, later, reference);
+
+			if constexpr(vector)
+			{
+				E product = (a + b) * (c - a);
+				for(int i=0;i<N;++i)
+					reference[i] = (static_cast<double>(a.m_data[i]) + b.m_data[i]) * (static_cast<double>(c.m_data[i]) - a.m_data[i]);
+				expectElements("(a + b) * (c - a)", type, product, reference);
+
+				// members called on a tree evaluate it first
+				double dot = 0.0;
+				double length = 0.0;
+				for(int i=0;i<N;++i)
+				{
+					double element = static_cast<double>(a.m_data[i]) + b.m_data[i];
+					dot += element * c.m_data[i];
+					length += element * element;
+				}
+				expectNear("(a + b).dot(c)", type, 0, (a + b).dot(c), dot);
+				expectNear("(a + b).length()", type, 0, (a + b).length(), std::sqrt(length));
+				expectNear("(a + b).get(0)", type, 0, (a + b).get(0), static_cast<double>(a.m_data[0]) + b.m_data[0]);
+
+				if constexpr(std::is_same<E, Renderer::Vec3<float>>::value)
+				{
+					Renderer::Vec3<float> cross = (a - b).cross(c);
+					double d[3] = { static_cast<double>(a.x) - b.x, static_cast<double>(a.y) - b.y, static_cast<double>(a.z) - b.z };
+					double crossed[3] = { d[1] * c.z - d[2] * c.y, d[2] * c.x - d[0] * c.z, d[0] * c.y - d[1] * c.x };
+					expectElements("(a - b).cross(c)", type, cross, crossed);
+				}
+			}
+		}
+	}
+
+	void checkShapes()
+	{
+		// a tree over the generic base and the sized type evaluates to the sized type
+		Renderer::Vec3<float> a(1.f, 2.f, 3.f);
+		Renderer::Vec<float, 3> base = a;
+		Renderer::Vec3<float> mixed = base + a;
+		static_assert(std::is_same<decltype(base + a)::Result, Renderer::Vec3<float>>::value,
+				"mixed trees evaluate to the more derived type");
+		++checks;
+		if(!(mixed == Renderer::Vec3<float>(2.f, 4.f, 6.f)) && ++failures <= 20)
+			std::printf("  mixed base and sized vector failed\n");
+
+		// trees of different shapes never match each other's operators
+		static_assert(!Renderer::sameShape<Renderer::Vec3<float>, Renderer::Vec4<float>>, "sizes differ");
+		static_assert(!Renderer::sameShape<Renderer::Vec4<float>, Renderer::Vec4<double>>, "scalars differ");
+		static_assert(!Renderer::sameShape<Renderer::Vec4<float>, Renderer::Mat2<float>>, "kinds differ");
+	}
+
+	const char* kernels()
+	{
+#if defined(RENDERER_MATH_SSE)
+		return "sse";
+#elif defined(RENDERER_MATH_NEON)
+		return "neon";
+#else
+		return "portable";
+#endif
+	}
+}
+
+int main()
+{
+	std::mt19937 gen(1234);
+
+	checkArithmetic<Renderer::Vec2<float>>("vec2", gen);
+	checkArithmetic<Renderer::Vec3<float>>("vec3", gen);
+	checkArithmetic<Renderer::Vec4<float>>("vec4", gen);
+	checkArithmetic<Renderer::Vec4<double>>("vec4<double>", gen);
+	checkArithmetic<Renderer::Mat2<float>>("mat2", gen);
+	checkArithmetic<Renderer::Mat3<float>>("mat3", gen);
+	checkArithmetic<Renderer::Mat4<float>>("mat4", gen);
+	checkArithmetic<Renderer::Mat4<double>>("mat4<double>", gen);
+	checkShapes();
+
+	std::printf("expressioncheck (%s kernels): %d checks, %d failed\n", kernels(), checks, failures);
+	return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,166 @@
+#include "../src/gl/vertexformat.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+// the bulk half float conversion, exits non zero on a mismatch. scalar floatToHalf is held to a few
+// values worked out by hand, every path of floatToHalfArray has to match it bit for bit over every
+// exponent, the rounding ties of normal and subnormal results, nan payloads and tails of every length
+namespace
+{
+	int checks = 0;
+	int failures = 0;
+
+	const uint16_t GUARD = 0xDEAD;
+
+	float fromBits(uint32_t bits)
+	{
+		float value;
+		std::memcpy(&value, &bits, sizeof(value));
+		return value;
+	}
+
+	uint32_t toBits(float value)
+	{
+		uint32_t bits;
+		std::memcpy(&bits, &value, sizeof(bits));
+		return bits;
+	}
+
+	void expectHalf(const char* path, const char* name, float value, uint16_t half, uint16_t reference)
+	{
+		++checks;
+		if(half != reference && ++failures <= 20)
+			std::printf("  %s %s: 0x%08x gave 0x%04x, expected 0x%04x\n", path, name,
+					toBits(value), half, reference);
+	}
+
+	void checkScalar()
+	{
+		struct Known
+		{
+			uint32_t bits;
+			uint16_t half;
+		};
+
+		static const Known known[] = {
+			{ 0x00000000, 0x0000 }, { 0x80000000, 0x8000 },
+			{ 0x3F800000, 0x3C00 }, { 0xC0000000, 0xC000 },
+			// 65504 is the largest half, 65520 is the tie between it and infinity and rounds up
+			{ 0x477FE000, 0x7BFF }, { 0x477FEFFF, 0x7BFF }, { 0x477FF000, 0x7C00 }, { 0x7F7FFFFF, 0x7C00 },
+			{ 0x7F800000, 0x7C00 }, { 0xFF800000, 0xFC00 },
+			// nans are quieted and keep the top of their payload
+			{ 0x7FC00000, 0x7E00 }, { 0xFFC00000, 0xFE00 }, { 0x7F800001, 0x7E00 }, { 0x7FFFE000, 0x7FFF },
+			{ 0x7F802000, 0x7E01 },
+			// 1 + 2^-11 ties to the even 1, 1 + 3 * 2^-11 ties up to 1 + 2^-9
+			{ 0x3F801000, 0x3C00 }, { 0x3F803000, 0x3C02 }, { 0x3F801001, 0x3C01 },
+			// 2^-14 is the smallest normal, 2^-24 the smallest subnormal, 2^-25 ties to 0
+			{ 0x38800000, 0x0400 }, { 0x33800000, 0x0001 }, { 0x33000000, 0x0000 }, { 0x33000001, 0x0001 },
+			{ 0x33C00000, 0x0002 }, { 0xB3800000, 0x8001 },
+			// float subnormals are far below the smallest half
+			{ 0x00000001, 0x0000 }, { 0x807FFFFF, 0x8000 }
+		};
+
+		for(const Known& k : known)
+			expectHalf("scalar", "known value", fromBits(k.bits), floatToHalf(fromBits(k.bits)), k.half);
+	}
+
+	// every exponent and top mantissa, with the dropped bits just below, at and just above the
+	// tie. subnormal results drop more bits, so those exponents get their own ties
+	std::vector<float> makeInputs()
+	{
+		std::vector<uint32_t> bits;
+		for(uint32_t sign : { 0u, 0x80000000u })
+		{
+			for(uint32_t exponent=0;exponent<256;++exponent)
+				for(uint32_t top=0;top<1024;++top)
+					for(uint32_t low : { 0x0u, 0x1u, 0xFFFu, 0x1000u, 0x1001u, 0x1FFFu })
+						bits.push_back(sign | (exponent << 23) | (top << 13) | low);
+
+			// half exponents 0 down to -10, the implicit bit is part of what is kept
+			for(uint32_t exponent=112-10;exponent<=112;++exponent)
+			{
+				uint32_t shift = 14 - (static_cast<int32_t>(exponent) - 112);
+				uint32_t halfway = 1u << (shift - 1);
+				for(uint32_t kept=(0x800000u >> shift);kept<(0x1000000u >> shift);++kept)
+					for(uint32_t low : { 0u, 1u, halfway - 1, halfway, halfway + 1, (halfway << 1) - 1 })
+						bits.push_back(sign | (exponent << 23) | (((kept << shift) | low) & 0x7FFFFF));
+			}
+		}
+
+		std::mt19937 gen(1234);
+		for(int i=0;i<1000000;++i)
+			bits.push_back(gen());
+
+		std::vector<float> inputs;
+		for(uint32_t b : bits)
+			inputs.push_back(fromBits(b));
+		return inputs;
+	}
+
+	void checkPath(const char* path, const std::vector<float>& inputs, const std::vector<uint16_t>& reference,
+			bool dispatch, HalfKernel kernel)
+	{
+		std::vector<uint16_t> halves(inputs.size() + 1);
+
+		// an unaligned start, then short runs so every tail length is left over once
+		for(std::size_t offset : { 0, 1 })
+		{
+			std::size_t count = inputs.size() - offset;
+			halves[count] = GUARD;
+			if(dispatch)
+				floatToHalfArray(inputs.data() + offset, halves.data(), count);
+			else
+				floatToHalfArray(inputs.data() + offset, halves.data(), count, kernel);
+
+			for(std::size_t i=0;i<count;++i)
+				expectHalf(path, "bulk", inputs[offset + i], halves[i], reference[offset + i]);
+			expectHalf(path, "guard after the last half", 0.f, halves[count], GUARD);
+		}
+
+		for(std::size_t count=0;count<=17;++count)
+		{
+			halves[count] = GUARD;
+			if(dispatch)
+				floatToHalfArray(inputs.data() + 3, halves.data(), count);
+			else
+				floatToHalfArray(inputs.data() + 3, halves.data(), count, kernel);
+
+			for(std::size_t i=0;i<count;++i)
+				expectHalf(path, "tail", inputs[3 + i], halves[i], reference[3 + i]);
+			expectHalf(path, "guard after the tail", 0.f, halves[count], GUARD);
+		}
+	}
+}
+
+int main()
+{
+	checkScalar();
+
+	std::vector<float> inputs = makeInputs();
+	std::vector<uint16_t> reference(inputs.size());
+	for(std::size_t i=0;i<inputs.size();++i)
+		reference[i] = floatToHalf(inputs[i]);
+
+	const struct
+	{
+		const char* name;
+		HalfKernel kernel;
+	} kernels[] = { { "scalar", HalfKernel::SCALAR }, { "sse2", HalfKernel::SSE2 }, { "f16c", HalfKernel::F16C } };
+
+	std::string paths;
+	for(const auto& kernel : kernels)
+	{
+		if(!halfKernelSupported(kernel.kernel))
+			continue;
+		checkPath(kernel.name, inputs, reference, false, kernel.kernel);
+		paths += paths.empty() ? kernel.name : std::string(", ") + kernel.name;
+	}
+	checkPath("dispatch", inputs, reference, true, HalfKernel::SCALAR);
+
+	std::printf("halfcheck (%s): %d checks, %d failed\n", paths.c_str(), checks, failures);
+	return failures == 0 ? 0 : 1;
+}
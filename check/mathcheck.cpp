@@ -0,0 +1,278 @@
+#include <renderer/Math/Vector.hpp>
+#include <renderer/Math/Matrix.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <random>
+
+// the 4 wide vector and matrix kernels against plain loops in double, exits non zero on a mismatch
+namespace
+{
+	const int ROUNDS = 1000;
+
+	int checks = 0;
+	int failures = 0;
+
+	// relative to the reference, absolute below one
+	void expectNear(const char* name, int round, int index, float value, double reference, double tolerance = 1e-5)
+	{
+		++checks;
+		if(std::fabs(value - reference) <= tolerance * std::max(1.0, std::fabs(reference)))
+			return;
+
+		if(++failures <= 20)
+			std::printf("  %s round %d element %d: %.9g, expected %.9g\n", name, round, index, value, reference);
+	}
+
+	void expect(const char* name, bool passed)
+	{
+		++checks;
+		if(!passed && ++failures <= 20)
+			std::printf("  %s failed\n", name);
+	}
+
+	float randomFloat(std::mt19937& gen)
+	{
+		return std::uniform_real_distribution<float>(-1.f, 1.f)(gen);
+	}
+
+	// diagonally dominant so every matrix is invertible and well conditioned
+	Renderer::Mat4<float> randomMatrix(std::mt19937& gen)
+	{
+		Renderer::Mat4<float> m;
+		for(int r=0;r<4;++r)
+			for(int c=0;c<4;++c)
+				m.set(r, c, randomFloat(gen) + (r == c ? 4.f : 0.f));
+
+		return m;
+	}
+
+	Renderer::Vec4<float> randomVector(std::mt19937& gen)
+	{
+		return Renderer::Vec4<float>(randomFloat(gen), randomFloat(gen), randomFloat(gen), randomFloat(gen));
+	}
+
+	// the references only read the column major arrays, none of the code under test
+	double element(const Renderer::Mat4<float>& _m, int _r, int _c)
+	{
+		return (*_m)[_c * 4 + _r];
+	}
+
+	void referenceProduct(const Renderer::Mat4<float>& _a, const Renderer::Mat4<float>& _b, double _out[16])
+	{
+		for(int r=0;r<4;++r)
+			for(int c=0;c<4;++c)
+			{
+				double sum = 0.0;
+				for(int k=0;k<4;++k)
+					sum += element(_a, r, k) * element(_b, k, c);
+				_out[c * 4 + r] = sum;
+			}
+	}
+
+	void referenceInverse(const Renderer::Mat4<float>& _m, double _out[16])
+	{
+		// gauss jordan with partial pivoting on [m | I]
+		double a[4][8];
+		for(int r=0;r<4;++r)
+			for(int c=0;c<8;++c)
+				a[r][c] = c < 4 ? element(_m, r, c) : (c - 4 == r ? 1.0 : 0.0);
+
+		for(int col=0;col<4;++col)
+		{
+			int pivot = col;
+			for(int r=col+1;r<4;++r)
+				if(std::fabs(a[r][col]) > std::fabs(a[pivot][col]))
+					pivot = r;
+			for(int c=0;c<8;++c)
+				std::swap(a[col][c], a[pivot][c]);
+
+			double scale = 1.0 / a[col][col];
+			for(int c=0;c<8;++c)
+				a[col][c] *= scale;
+
+			for(int r=0;r<4;++r)
+			{
+				if(r == col)
+					continue;
+				double factor = a[r][col];
+				for(int c=0;c<8;++c)
+					a[r][c] -= factor * a[col][c];
+			}
+		}
+
+		for(int r=0;r<4;++r)
+			for(int c=0;c<4;++c)
+				_out[c * 4 + r] = a[r][c + 4];
+	}
+
+	void checkLayout()
+	{
+		// the element constructor takes rows, storage is by column
+		Renderer::Mat4<float> m(
+				0.f, 1.f, 2.f, 3.f,
+				4.f, 5.f, 6.f, 7.f,
+				8.f, 9.f, 10.f, 11.f,
+				12.f, 13.f, 14.f, 15.f
+		);
+		bool rows = true;
+		for(int r=0;r<4;++r)
+			for(int c=0;c<4;++c)
+				rows = rows && m(r, c) == r * 4 + c && (*m)[c * 4 + r] == r * 4 + c;
+		expect("element constructor layout", rows);
+
+		Renderer::Mat4<float> identity;
+		bool diagonal = true;
+		for(int i=0;i<16;++i)
+			diagonal = diagonal && (*identity)[i] == (i % 5 == 0 ? 1.f : 0.f);
+		expect("default matrix is the identity", diagonal);
+
+		Renderer::Vec4<float> zero;
+		expect("default vector is zero", zero.x == 0.f && zero.y == 0.f && zero.z == 0.f && zero.w == 0.f);
+
+		Renderer::Mat3<float> m3(1.f, 2.f, 3.f, 4.f, 5.f, 6.f, 7.f, 8.f, 9.f);
+		expect("mat3 element constructor layout", m3(0, 1) == 2.f && m3(1, 0) == 4.f && m3(2, 2) == 9.f);
+
+		Renderer::Mat2<float> m2(1.f, 2.f, 3.f, 4.f);
+		expect("mat2 element constructor layout", m2(0, 1) == 2.f && m2(1, 0) == 3.f);
+	}
+
+	void checkProducts(std::mt19937& gen)
+	{
+		for(int round=0;round<ROUNDS;++round)
+		{
+			Renderer::Mat4<float> a = randomMatrix(gen);
+			Renderer::Mat4<float> b = randomMatrix(gen);
+			Renderer::Vec4<float> v = randomVector(gen);
+
+			double product[16];
+			referenceProduct(a, b, product);
+
+			Renderer::Mat4<float> ab = a * b;
+			for(int i=0;i<16;++i)
+				expectNear("mat4 * mat4", round, i, (*ab)[i], product[i]);
+
+			// both operands are read before the result is stored
+			Renderer::Mat4<float> aliased = a;
+			aliased = aliased * b;
+			expect("mat4 * mat4 into its left operand", aliased == ab);
+
+			Renderer::Vec4<float> av = a * v;
+			for(int r=0;r<4;++r)
+			{
+				double sum = 0.0;
+				for(int k=0;k<4;++k)
+					sum += element(a, r, k) * v[k];
+				expectNear("mat4 * vec4", round, r, av[r], sum);
+			}
+
+			Renderer::Vec4<float> moved = v;
+			moved = a * moved;
+			expect("mat4 * vec4 into its operand", moved == av);
+
+			Renderer::Vec4<float> u = randomVector(gen);
+			double dot = 0.0;
+			for(int i=0;i<4;++i)
+				dot += static_cast<double>(v[i]) * u[i];
+			expectNear("vec4 dot", round, 0, v.dot(u), dot);
+
+			// the generic loops of the double matrices against the float kernels
+			Renderer::Mat4<double> ad(Renderer::NoInit{}), bd(Renderer::NoInit{});
+			for(int i=0;i<16;++i)
+			{
+				ad(i % 4, i / 4) = (*a)[i];
+				bd(i % 4, i / 4) = (*b)[i];
+			}
+			Renderer::Mat4<double> abd = ad * bd;
+			for(int i=0;i<16;++i)
+				expectNear("mat4<double> * mat4<double>", round, i, static_cast<float>((*abd)[i]), product[i]);
+		}
+	}
+
+	void checkTranspose(std::mt19937& gen)
+	{
+		for(int round=0;round<ROUNDS;++round)
+		{
+			Renderer::Mat4<float> m = randomMatrix(gen);
+			Renderer::Mat4<float> t = m;
+			t.transpose();
+
+			bool swapped = true;
+			for(int r=0;r<4;++r)
+				for(int c=0;c<4;++c)
+					swapped = swapped && t(r, c) == m(c, r);
+			expect("mat4 transpose", swapped);
+		}
+	}
+
+	void checkInverse(std::mt19937& gen)
+	{
+		for(int round=0;round<ROUNDS;++round)
+		{
+			Renderer::Mat4<float> m = randomMatrix(gen);
+
+			double inverse[16];
+			referenceInverse(m, inverse);
+
+			Renderer::Mat4<float> inverted = m;
+			inverted.inverse();
+			for(int i=0;i<16;++i)
+				expectNear("mat4 inverse", round, i, (*inverted)[i], inverse[i], 1e-4);
+
+			// the portable cofactor expansion the other element types use
+			float scalar[16];
+			float det = Renderer::Simd::inverseMat4Scalar(*m, scalar);
+			for(int i=0;i<16;++i)
+				expectNear("mat4 scalar inverse", round, i, scalar[i], inverse[i], 1e-4);
+
+			alignas(16) float packed[16];
+			float packed_det = Renderer::Simd::inverseMat4(*m, packed);
+			expectNear("mat4 inverse determinant", round, 0, packed_det, det, 1e-4);
+			expectNear("mat4 determinant", round, 0, m.determinant(), det, 1e-4);
+		}
+
+		// a singular matrix throws and is left as it was
+		Renderer::Mat4<float> singular(
+				1.f, 2.f, 3.f, 4.f,
+				2.f, 4.f, 6.f, 8.f,
+				0.f, 1.f, 0.f, 1.f,
+				1.f, 0.f, 1.f, 0.f
+		);
+		Renderer::Mat4<float> before = singular;
+		bool threw = false;
+		try
+		{
+			singular.inverse();
+		}
+		catch(const Renderer::InvalidOperationException&)
+		{
+			threw = true;
+		}
+		expect("singular mat4 inverse throws", threw && singular == before);
+	}
+
+	const char* kernels()
+	{
+#if defined(RENDERER_MATH_SSE)
+		return "sse";
+#elif defined(RENDERER_MATH_NEON)
+		return "neon";
+#else
+		return "portable";
+#endif
+	}
+}
+
+int main()
+{
+	std::mt19937 gen(1234);
+
+	checkLayout();
+	checkProducts(gen);
+	checkTranspose(gen);
+	checkInverse(gen);
+
+	std::printf("mathcheck (%s kernels): %d checks, %d failed\n", kernels(), checks, failures);
+	return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,188 @@
+#include "../src/core/threadpool.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+// job graphs on pools of a few sizes, exits non zero when an order, a wait or an error goes wrong.
+// a deadlock would hang instead, so a watchdog gives up after a while
+namespace
+{
+	const int ROUNDS = 500;
+	const int WATCHDOG_SECONDS = 60;
+
+	int checks = 0;
+	int failures = 0;
+
+	void expect(const char* name, unsigned int threads, bool passed)
+	{
+		++checks;
+		if(!passed && ++failures <= 20)
+			std::printf("  %s on %u threads failed\n", name, threads);
+	}
+
+	// a -> b, c -> d. every job records the step it finished at, a dependent has to see a later one.
+	// some rounds hold a or c up, so an idle worker would start a dependent early if it could
+	void checkDiamond(ThreadPool& pool)
+	{
+		for(int round=0;round<ROUNDS;++round)
+		{
+			std::atomic<int> step{ 0 };
+			std::atomic<int> a_step{ -1 }, b_step{ -1 }, c_step{ -1 }, d_step{ -1 };
+			bool b_saw_a = false, c_saw_a = false, d_saw_both = false;
+			std::chrono::microseconds delay(round % 4 == 0 ? 200 : 0);
+
+			ThreadPool::JobHandle a = pool.schedule([&]() {
+				std::this_thread::sleep_for(delay);
+				a_step = step++;
+			});
+			ThreadPool::JobHandle b = pool.schedule([&]() { b_saw_a = a_step >= 0; b_step = step++; }, { a });
+			ThreadPool::JobHandle c = pool.schedule([&]() {
+				c_saw_a = a_step >= 0;
+				std::this_thread::sleep_for(delay);
+				c_step = step++;
+			}, { a });
+			ThreadPool::JobHandle d = pool.schedule([&]() { d_saw_both = b_step >= 0 && c_step >= 0; d_step = step++; }, { b, c });
+
+			pool.wait(d);
+			expect("diamond dependents run after their dependency", pool.getThreadCount(), b_saw_a && c_saw_a);
+			expect("diamond join runs last", pool.getThreadCount(), d_saw_both && d_step == 3);
+
+			// the others finished before d, so waiting on them returns at once
+			pool.wait(a);
+			pool.wait(b);
+			pool.wait(c);
+			expect("diamond jobs are done", pool.getThreadCount(), a->isDone() && b->isDone() && c->isDone() && d->isDone());
+		}
+
+		// a dependency that already finished holds nothing back, a wide fan in waits on all of it
+		ThreadPool::JobHandle finished = pool.schedule([]() {});
+		pool.wait(finished);
+		std::atomic<int> ran{ 0 };
+		std::vector<ThreadPool::JobHandle> fan;
+		for(int i=0;i<100;++i)
+			fan.push_back(pool.schedule([&ran]() { ++ran; }, { finished }));
+		bool all_ran = false;
+		pool.wait(pool.schedule([&]() { all_ran = ran == 100; }, fan));
+		expect("fan in after a finished dependency", pool.getThreadCount(), all_ran);
+	}
+
+	// sums 1..n by splitting the range and waiting on both halves from inside the task, which
+	// deadlocks a pool that blocks its workers in wait once the tree is deeper than the pool
+	long long splitSum(ThreadPool& pool, long long begin, long long end)
+	{
+		if(end - begin <= 4)
+		{
+			long long sum = 0;
+			for(long long i=begin;i<end;++i)
+				sum += i;
+			return sum;
+		}
+
+		long long middle = (begin + end) / 2;
+		long long left = 0, right = 0;
+		ThreadPool::JobHandle low = pool.schedule([&]() { left = splitSum(pool, begin, middle); });
+		ThreadPool::JobHandle high = pool.schedule([&]() { right = splitSum(pool, middle, end); });
+		pool.wait(low);
+		pool.wait(high);
+		return left + right;
+	}
+
+	void checkNestedWait(ThreadPool& pool)
+	{
+		for(int round=0;round<ROUNDS/10;++round)
+		{
+			long long sum = 0;
+			pool.wait(pool.schedule([&]() { sum = splitSum(pool, 0, 1000); }));
+			expect("wait inside a task", pool.getThreadCount(), sum == 999 * 1000 / 2);
+		}
+
+		// a task waiting on a job whose dependency is queued behind it on the same worker
+		int value = 0;
+		pool.wait(pool.schedule([&]() {
+			ThreadPool::JobHandle first = pool.schedule([&]() { value = 1; });
+			ThreadPool::JobHandle second = pool.schedule([&]() { value *= 2; }, { first });
+			pool.wait(second);
+		}));
+		expect("wait inside a task on a dependent job", pool.getThreadCount(), value == 2);
+	}
+
+	template<typename Work>
+	bool throwsRuntimeError(Work work, const char* message)
+	{
+		try
+		{
+			work();
+		}
+		catch(const std::runtime_error& e)
+		{
+			return std::string(e.what()) == message;
+		}
+		return false;
+	}
+
+	void checkErrors(ThreadPool& pool)
+	{
+		// wait rethrows on every call, not just the first
+		ThreadPool::JobHandle failing = pool.schedule([]() { throw std::runtime_error("failed"); });
+		expect("wait rethrows the job's error", pool.getThreadCount(),
+				throwsRuntimeError([&]() { pool.wait(failing); }, "failed"));
+		expect("wait rethrows again", pool.getThreadCount(),
+				throwsRuntimeError([&]() { pool.wait(failing); }, "failed"));
+
+		// a dependency that threw still counts as finished, its dependents run and do not inherit the error
+		bool dependent_ran = false;
+		ThreadPool::JobHandle dependent = pool.schedule([&]() { dependent_ran = true; }, { failing });
+		bool dependent_clean = true;
+		try
+		{
+			pool.wait(dependent);
+		}
+		catch(...)
+		{
+			dependent_clean = false;
+		}
+		expect("dependents of a failed job run", pool.getThreadCount(), dependent_ran && dependent_clean);
+
+		// an error rethrown by a wait inside a task becomes that task's error
+		ThreadPool::JobHandle outer = pool.schedule([&]() {
+			ThreadPool::JobHandle inner = pool.schedule([]() { throw std::runtime_error("inner"); });
+			pool.wait(inner);
+		});
+		expect("errors pass through nested waits", pool.getThreadCount(),
+				throwsRuntimeError([&]() { pool.wait(outer); }, "inner"));
+
+		// the pool keeps working afterwards
+		bool ran = false;
+		pool.wait(pool.schedule([&]() { ran = true; }));
+		expect("pool runs after errors", pool.getThreadCount(), ran);
+	}
+}
+
+int main()
+{
+	std::thread watchdog([]() {
+		std::this_thread::sleep_for(std::chrono::seconds(WATCHDOG_SECONDS));
+		std::printf("poolcheck: no progress after %d seconds, a wait is stuck\n", WATCHDOG_SECONDS);
+		std::fflush(stdout);
+		std::_Exit(1);
+	});
+	watchdog.detach();
+
+	// one worker is where a blocking wait deadlocks first
+	for(unsigned int threads : { 1u, 2u, 4u, 0u })
+	{
+		ThreadPool pool(threads);
+		checkDiamond(pool);
+		checkNestedWait(pool);
+		checkErrors(pool);
+	}
+
+	std::printf("poolcheck: %d checks, %d failed\n", checks, failures);
+	return failures == 0 ? 0 : 1;
+}
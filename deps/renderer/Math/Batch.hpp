@@ -0,0 +1,291 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+
+#include "Vector.hpp"
+#include "Matrix.hpp"
+
+// the wide path is compiled for avx2 through a target attribute and picked at run time, so the
+// rest of the program keeps building for the baseline instruction set
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+	#define RENDERER_BATCH_AVX2
+	#include <immintrin.h>
+	#define RENDERER_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+/*
+ * kernels over many points, boxes or spheres at once. the data is laid out as structure of
+ * arrays, one array per component, so eight consecutive entries fill one avx register without
+ * shuffles. the arrays need no alignment and any count works, the wide path finishes the last
+ * few entries with the scalar one. both paths do the same operations in the same order and
+ * give identical results
+ */
+namespace Renderer
+{
+	namespace Batch
+	{
+		// count entries starting at each pointer
+		struct Points
+		{
+			const float* x;
+			const float* y;
+			const float* z;
+
+			Points advance(int _n) const { return { x + _n, y + _n, z + _n }; }
+		};
+
+		// w may be null when the transform is affine and only x, y and z are wanted
+		struct TransformedPoints
+		{
+			float* x;
+			float* y;
+			float* z;
+			float* w;
+
+			TransformedPoints advance(int _n) const { return { x + _n, y + _n, z + _n, w ? w + _n : nullptr }; }
+		};
+
+		// planes face inward and are normalized, so a * x + b * y + c * z + d is the signed distance
+		struct Frustum
+		{
+			float planes[6][4];
+
+			// left, right, bottom, top, near and far from the rows of a view projection matrix
+			static Frustum fromMatrix(const Renderer::Mat4<float>& _view_projection)
+			{
+				const Renderer::Mat4<float>& m = _view_projection;
+				static const int rows[6] = { 0, 0, 1, 1, 2, 2 };
+				static const float signs[6] = { 1.f, -1.f, 1.f, -1.f, 1.f, -1.f };
+
+				Frustum frustum;
+				for(int p=0;p<6;++p)
+				{
+					for(int c=0;c<4;++c)
+						frustum.planes[p][c] = m(3, c) + signs[p] * m(rows[p], c);
+
+					float* plane = frustum.planes[p];
+					float inv_length = 1.f / std::sqrt(plane[0] * plane[0] + plane[1] * plane[1] + plane[2] * plane[2]);
+					for(int c=0;c<4;++c)
+						plane[c] *= inv_length;
+				}
+
+				return frustum;
+			}
+
+			// the box corner furthest along each plane normal only depends on the signs of the
+			// normal, so the arrays it is read from are picked once for a whole batch of boxes
+			void corners(Points _min, Points _max, Points _out[6]) const
+			{
+				for(int p=0;p<6;++p)
+					_out[p] = {
+						planes[p][0] >= 0.f ? _max.x : _min.x,
+						planes[p][1] >= 0.f ? _max.y : _min.y,
+						planes[p][2] >= 0.f ? _max.z : _min.z
+					};
+			}
+		};
+
+		namespace Scalar
+		{
+			// _out = _m * (x, y, z, 1)
+			inline void transformPoints(const Renderer::Mat4<float>& _m, Points _in, TransformedPoints _out, int _count)
+			{
+				for(int i=0;i<_count;++i)
+				{
+					float x = _in.x[i], y = _in.y[i], z = _in.z[i];
+					_out.x[i] = _m(0, 0) * x + _m(0, 1) * y + _m(0, 2) * z + _m(0, 3);
+					_out.y[i] = _m(1, 0) * x + _m(1, 1) * y + _m(1, 2) * z + _m(1, 3);
+					_out.z[i] = _m(2, 0) * x + _m(2, 1) * y + _m(2, 2) * z + _m(2, 3);
+					if(_out.w)
+						_out.w[i] = _m(3, 0) * x + _m(3, 1) * y + _m(3, 2) * z + _m(3, 3);
+				}
+			}
+
+			// distance in front of the camera, the view matrix looks down -z
+			inline void viewDepths(const Renderer::Mat4<float>& _view, Points _in, float* _depth, int _count)
+			{
+				for(int i=0;i<_count;++i)
+					_depth[i] = -(_view(2, 0) * _in.x[i] + _view(2, 1) * _in.y[i] + _view(2, 2) * _in.z[i] + _view(2, 3));
+			}
+
+			// 1 when the sphere touches the frustum, conservative near the corners like every plane test
+			inline void cullSpheres(const Frustum& _frustum, Points _centers, const float* _radius, uint8_t* _visible, int _count)
+			{
+				for(int i=0;i<_count;++i)
+				{
+					// no early out, a branch per plane mispredicts on anything near the edges
+					bool outside = false;
+					for(int p=0;p<6;++p)
+					{
+						const float* plane = _frustum.planes[p];
+						float distance = plane[0] * _centers.x[i] + plane[1] * _centers.y[i] + plane[2] * _centers.z[i] + plane[3];
+						outside |= distance < -_radius[i];
+					}
+					_visible[i] = !outside;
+				}
+			}
+
+			// tests the corner furthest along each plane normal, 1 when the box touches the frustum
+			inline void cullBoxes(const Frustum& _frustum, Points _min, Points _max, uint8_t* _visible, int _count)
+			{
+				Points corners[6];
+				_frustum.corners(_min, _max, corners);
+
+				for(int i=0;i<_count;++i)
+				{
+					bool outside = false;
+					for(int p=0;p<6;++p)
+					{
+						const float* plane = _frustum.planes[p];
+						outside |= plane[0] * corners[p].x[i] + plane[1] * corners[p].y[i] + plane[2] * corners[p].z[i] + plane[3] < 0.f;
+					}
+					_visible[i] = !outside;
+				}
+			}
+		}
+
+#if defined(RENDERER_BATCH_AVX2)
+		namespace Avx2
+		{
+			RENDERER_TARGET_AVX2 inline __m256 load(const float* _p) { return _mm256_loadu_ps(_p); }
+
+			// a * x + b * y + c * z + d without fma, so the result matches the scalar path bit for bit
+			RENDERER_TARGET_AVX2 inline __m256 plane(const float* _row, __m256 _x, __m256 _y, __m256 _z)
+			{
+				__m256 r = _mm256_mul_ps(_mm256_set1_ps(_row[0]), _x);
+				r = _mm256_add_ps(r, _mm256_mul_ps(_mm256_set1_ps(_row[1]), _y));
+				r = _mm256_add_ps(r, _mm256_mul_ps(_mm256_set1_ps(_row[2]), _z));
+				return _mm256_add_ps(r, _mm256_set1_ps(_row[3]));
+			}
+
+			// one byte per lane of an eight bit compare mask
+			inline void storeMask(uint8_t* _out, int _mask)
+			{
+				for(int b=0;b<8;++b)
+					_out[b] = (_mask >> b) & 1;
+			}
+
+			RENDERER_TARGET_AVX2 inline void transformPoints(const Renderer::Mat4<float>& _m, Points _in, TransformedPoints _out, int _count)
+			{
+				const float rows[4][4] = {
+					{ _m(0, 0), _m(0, 1), _m(0, 2), _m(0, 3) },
+					{ _m(1, 0), _m(1, 1), _m(1, 2), _m(1, 3) },
+					{ _m(2, 0), _m(2, 1), _m(2, 2), _m(2, 3) },
+					{ _m(3, 0), _m(3, 1), _m(3, 2), _m(3, 3) }
+				};
+
+				int i = 0;
+				for(;i+8<=_count;i+=8)
+				{
+					__m256 x = load(_in.x + i), y = load(_in.y + i), z = load(_in.z + i);
+					_mm256_storeu_ps(_out.x + i, plane(rows[0], x, y, z));
+					_mm256_storeu_ps(_out.y + i, plane(rows[1], x, y, z));
+					_mm256_storeu_ps(_out.z + i, plane(rows[2], x, y, z));
+					if(_out.w)
+						_mm256_storeu_ps(_out.w + i, plane(rows[3], x, y, z));
+				}
+
+				Scalar::transformPoints(_m, _in.advance(i), _out.advance(i), _count - i);
+			}
+
+			RENDERER_TARGET_AVX2 inline void viewDepths(const Renderer::Mat4<float>& _view, Points _in, float* _depth, int _count)
+			{
+				const float row[4] = { _view(2, 0), _view(2, 1), _view(2, 2), _view(2, 3) };
+				const __m256 sign = _mm256_set1_ps(-0.f);
+
+				int i = 0;
+				for(;i+8<=_count;i+=8)
+				{
+					__m256 z = plane(row, load(_in.x + i), load(_in.y + i), load(_in.z + i));
+					_mm256_storeu_ps(_depth + i, _mm256_xor_ps(z, sign));
+				}
+
+				Scalar::viewDepths(_view, _in.advance(i), _depth + i, _count - i);
+			}
+
+			RENDERER_TARGET_AVX2 inline void cullSpheres(const Frustum& _frustum, Points _centers, const float* _radius, uint8_t* _visible, int _count)
+			{
+				const __m256 sign = _mm256_set1_ps(-0.f);
+
+				int i = 0;
+				for(;i+8<=_count;i+=8)
+				{
+					__m256 x = load(_centers.x + i), y = load(_centers.y + i), z = load(_centers.z + i);
+					__m256 negative_radius = _mm256_xor_ps(load(_radius + i), sign);
+
+					// lanes that are behind any plane by more than their radius
+					__m256 outside = _mm256_setzero_ps();
+					for(int p=0;p<6;++p)
+						outside = _mm256_or_ps(outside,
+								_mm256_cmp_ps(plane(_frustum.planes[p], x, y, z), negative_radius, _CMP_LT_OQ));
+
+					storeMask(_visible + i, ~_mm256_movemask_ps(outside));
+				}
+
+				Scalar::cullSpheres(_frustum, _centers.advance(i), _radius + i, _visible + i, _count - i);
+			}
+
+			RENDERER_TARGET_AVX2 inline void cullBoxes(const Frustum& _frustum, Points _min, Points _max, uint8_t* _visible, int _count)
+			{
+				Points corners[6];
+				_frustum.corners(_min, _max, corners);
+
+				int i = 0;
+				for(;i+8<=_count;i+=8)
+				{
+					__m256 outside = _mm256_setzero_ps();
+					for(int p=0;p<6;++p)
+					{
+						__m256 distance = plane(_frustum.planes[p], load(corners[p].x + i), load(corners[p].y + i), load(corners[p].z + i));
+						outside = _mm256_or_ps(outside, _mm256_cmp_ps(distance, _mm256_setzero_ps(), _CMP_LT_OQ));
+					}
+
+					storeMask(_visible + i, ~_mm256_movemask_ps(outside));
+				}
+
+				Scalar::cullBoxes(_frustum, _min.advance(i), _max.advance(i), _visible + i, _count - i);
+			}
+		}
+#endif
+
+		// checked once, every call after the first is a load of a static
+		inline bool hasAvx2()
+		{
+#if defined(RENDERER_BATCH_AVX2)
+			static const bool supported = __builtin_cpu_supports("avx2");
+			return supported;
+#else
+			return false;
+#endif
+		}
+
+#if defined(RENDERER_BATCH_AVX2)
+	#define RENDERER_BATCH_DISPATCH(call) if(hasAvx2()) Avx2::call; else Scalar::call
+#else
+	#define RENDERER_BATCH_DISPATCH(call) Scalar::call
+#endif
+
+		inline void transformPoints(const Renderer::Mat4<float>& _m, Points _in, TransformedPoints _out, int _count)
+		{
+			RENDERER_BATCH_DISPATCH(transformPoints(_m, _in, _out, _count));
+		}
+
+		inline void viewDepths(const Renderer::Mat4<float>& _view, Points _in, float* _depth, int _count)
+		{
+			RENDERER_BATCH_DISPATCH(viewDepths(_view, _in, _depth, _count));
+		}
+
+		inline void cullSpheres(const Frustum& _frustum, Points _centers, const float* _radius, uint8_t* _visible, int _count)
+		{
+			RENDERER_BATCH_DISPATCH(cullSpheres(_frustum, _centers, _radius, _visible, _count));
+		}
+
+		inline void cullBoxes(const Frustum& _frustum, Points _min, Points _max, uint8_t* _visible, int _count)
+		{
+			RENDERER_BATCH_DISPATCH(cullBoxes(_frustum, _min, _max, _visible, _count));
+		}
+
+#undef RENDERER_BATCH_DISPATCH
+	}
+}
@@ -0,0 +1,221 @@
+#pragma once
+
+#include <type_traits>
+#include <utility>
+
+#include "Simd.hpp"
+
+namespace Renderer
+{
+	inline namespace Pod
+	{
+		/*
+		 * arithmetic on vectors and matrices builds a small tree of nodes instead of a result per
+		 * operator. the tree is walked once, element by element (or four floats at a time for the
+		 * 4 wide types), when it is assigned to or used to construct a vector or matrix, so a chain
+		 * like a + b * s - c writes its result once with no intermediate objects.
+		 *
+		 * named values are held by reference and temporaries by value, so a tree stays valid as
+		 * long as the named values it was built from do. every element only reads the same element
+		 * of its operands, so assigning a tree back into one of them is safe
+		 */
+		struct VectorKind { };
+		struct MatrixKind { };
+
+		// tag for results that are about to have every element written
+		struct NoInit { };
+
+		// empty base of every vector, matrix and node, carries what the operators need to match
+		template<typename T, int N, typename K>
+		struct Expression
+		{
+			typedef Expression<T, N, K> ExpressionType;
+			typedef T Scalar;
+			typedef K Kind;
+			static constexpr int Size = N;
+			static constexpr int Elements = std::is_same<K, MatrixKind>::value ? N * N : N;
+		};
+
+		template<typename E, typename = void>
+		struct IsExpression : std::false_type { };
+
+		template<typename E>
+		struct IsExpression<E, std::void_t<typename E::ExpressionType>>
+			: std::is_base_of<typename E::ExpressionType, E> { };
+
+		template<typename E>
+		constexpr bool isExpression = IsExpression<std::decay_t<E>>::value;
+
+		// both trees of the same scalar, size and kind, false for anything that is not a tree
+		template<typename A, typename B, bool = IsExpression<A>::value && IsExpression<B>::value>
+		struct SameShape : std::false_type { };
+
+		template<typename A, typename B>
+		struct SameShape<A, B, true> : std::is_same<typename A::ExpressionType, typename B::ExpressionType> { };
+
+		template<typename A, typename B>
+		constexpr bool sameShape = SameShape<std::decay_t<A>, std::decay_t<B>>::value;
+
+		template<typename E, typename K, bool = IsExpression<E>::value>
+		struct IsKind : std::false_type { };
+
+		template<typename E, typename K>
+		struct IsKind<E, K, true> : std::is_same<typename E::Kind, K> { };
+
+		template<typename E, typename K>
+		constexpr bool isKind = IsKind<std::decay_t<E>, K>::value;
+
+		// how a node holds an operand, named values by reference and temporaries by value
+		template<typename E>
+		using Operand = std::conditional_t<std::is_lvalue_reference<E>::value, const std::decay_t<E>&, std::decay_t<E>>;
+
+		// the vector or matrix a tree evaluates to, Vec3 over Vec<T, 3> when both appear
+		template<typename A, typename B>
+		using MoreDerived = std::conditional_t<std::is_base_of<A, B>::value, B, A>;
+
+		// the float 4 wide types are evaluated a register at a time
+		template<typename E>
+		constexpr bool usesPackets = std::is_same<typename E::Scalar, float>::value && E::Size == 4;
+
+		struct Add
+		{
+			template<typename X> static X apply(X _a, X _b) { return _a + _b; }
+			static Simd::Float4 apply(Simd::Float4 _a, Simd::Float4 _b) { return Simd::add(_a, _b); }
+		};
+
+		struct Subtract
+		{
+			template<typename X> static X apply(X _a, X _b) { return _a - _b; }
+			static Simd::Float4 apply(Simd::Float4 _a, Simd::Float4 _b) { return Simd::sub(_a, _b); }
+		};
+
+		struct Multiply
+		{
+			template<typename X> static X apply(X _a, X _b) { return _a * _b; }
+			static Simd::Float4 apply(Simd::Float4 _a, Simd::Float4 _b) { return Simd::mul(_a, _b); }
+		};
+
+		// base of the nodes, takes its shape from the operand E
+		template<typename D, typename E>
+		class ExpressionNode : public Expression<typename E::Scalar, E::Size, typename E::Kind>
+		{
+			public:
+				auto eval() const { return typename D::Result(static_cast<const D&>(*this)); }
+
+				// members of the result for calls made straight on a tree, which evaluate it first
+				auto length() const { return eval().length(); }
+				auto get(int _index) const { return eval().get(_index); }
+				auto at(int _r, int _c) const { return eval().at(_r, _c); }
+				template<typename X> auto dot(const X& _other) const { return eval().dot(_other); }
+				template<typename X> auto cross(const X& _other) const { return eval().cross(_other); }
+		};
+
+		// element by element between two operands of the same shape
+		template<typename Op, typename L, typename R>
+		class BinaryExpression : public ExpressionNode<BinaryExpression<Op, L, R>, std::decay_t<L>>
+		{
+			public:
+				typedef typename std::decay_t<L>::Scalar T;
+				typedef MoreDerived<typename std::decay_t<L>::Result, typename std::decay_t<R>::Result> Result;
+
+				template<typename A, typename B>
+				BinaryExpression(A&& _left, B&& _right)
+					: left(std::forward<A>(_left)), right(std::forward<B>(_right))
+				{ }
+
+				T element(int _i) const { return Op::apply(left.element(_i), right.element(_i)); }
+				Simd::Float4 packet(int _i) const { return Op::apply(left.packet(_i), right.packet(_i)); }
+
+			private:
+				L left;
+				R right;
+		};
+
+		// every element against one scalar
+		template<typename Op, typename E>
+		class ScalarExpression : public ExpressionNode<ScalarExpression<Op, E>, std::decay_t<E>>
+		{
+			public:
+				typedef typename std::decay_t<E>::Scalar T;
+				typedef typename std::decay_t<E>::Result Result;
+
+				template<typename A>
+				ScalarExpression(A&& _expression, T _scalar)
+					: expression(std::forward<A>(_expression)), scalar{ _scalar }
+				{ }
+
+				T element(int _i) const { return Op::apply(expression.element(_i), scalar); }
+				Simd::Float4 packet(int _i) const { return Op::apply(expression.packet(_i), Simd::splat(scalar)); }
+
+			private:
+				E expression;
+				T scalar;
+		};
+
+		template<typename L, typename R, std::enable_if_t<sameShape<L, R>, int> = 0>
+		BinaryExpression<Add, Operand<L&&>, Operand<R&&>> operator+(L&& _left, R&& _right)
+		{
+			return { std::forward<L>(_left), std::forward<R>(_right) };
+		}
+
+		template<typename L, typename R, std::enable_if_t<sameShape<L, R>, int> = 0>
+		BinaryExpression<Subtract, Operand<L&&>, Operand<R&&>> operator-(L&& _left, R&& _right)
+		{
+			return { std::forward<L>(_left), std::forward<R>(_right) };
+		}
+
+		// between two vectors * is per element, between matrices it is the product in Matrix.hpp
+		template<typename L, typename R, std::enable_if_t<sameShape<L, R> && isKind<L, VectorKind>, int> = 0>
+		BinaryExpression<Multiply, Operand<L&&>, Operand<R&&>> operator*(L&& _left, R&& _right)
+		{
+			return { std::forward<L>(_left), std::forward<R>(_right) };
+		}
+
+		template<typename E, std::enable_if_t<isExpression<E>, int> = 0>
+		ScalarExpression<Multiply, Operand<E&&>> operator*(E&& _expression, typename std::decay_t<E>::Scalar _scalar)
+		{
+			return { std::forward<E>(_expression), _scalar };
+		}
+
+		template<typename E, std::enable_if_t<isExpression<E>, int> = 0>
+		ScalarExpression<Multiply, Operand<E&&>> operator*(typename std::decay_t<E>::Scalar _scalar, E&& _expression)
+		{
+			return { std::forward<E>(_expression), _scalar };
+		}
+
+		// through the reciprocal, one divide for the whole tree
+		template<typename E, std::enable_if_t<isExpression<E>, int> = 0>
+		ScalarExpression<Multiply, Operand<E&&>> operator/(E&& _expression, typename std::decay_t<E>::Scalar _scalar)
+		{
+			typedef typename std::decay_t<E>::Scalar T;
+			return { std::forward<E>(_expression), ((T)1) / _scalar };
+		}
+
+		template<typename E, std::enable_if_t<isExpression<E>, int> = 0>
+		ScalarExpression<Multiply, Operand<E&&>> operator-(E&& _expression)
+		{
+			typedef typename std::decay_t<E>::Scalar T;
+			return { std::forward<E>(_expression), (T)-1 };
+		}
+
+		template<typename E, std::size_t... I>
+		void evaluateElements(typename E::Scalar* _out, const E& _expression, std::index_sequence<I...>)
+		{
+			// every element is read before the first store, so a store into an operand cannot
+			// force reloads, and the expansion unrolls short vectors that -O2 leaves as a loop
+			const typename E::Scalar values[] = { _expression.element(I)... };
+			((_out[I] = values[I]), ...);
+		}
+
+		// writes a tree into the storage of a vector or matrix in one pass
+		template<typename E>
+		void evaluate(typename E::Scalar* _out, const E& _expression)
+		{
+			if constexpr(usesPackets<E>)
+				for(int i=0;i<E::Elements/4;++i)
+					Simd::store(_out + i * 4, _expression.packet(i));
+			else
+				evaluateElements(_out, _expression, std::make_index_sequence<E::Elements>{});
+		}
+	}
+}
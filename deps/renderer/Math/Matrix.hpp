@@ -3,683 +3,500 @@
 #include <iostream>
 #include <cstring>
 #include <algorithm>
+#include <type_traits>
 
 #include "../Utils/Exceptions.hpp"
+#include "Simd.hpp"
+#include "Expression.hpp"
 #include "Vector.hpp"
 
 namespace Renderer
 {
-	template<typename T, int N>
-	class Mat
+	inline namespace Pod
 	{
-		protected:
+		// column major storage, vRC names row R column C over the same array
+		template<typename T, int N>
+		struct MatStorage
+		{
 			T m_data[N * N];
-		public:
-			Mat()
-			{
-				identity();
-			}
-
-			Mat(const Mat<T, N>& _other)
-			{
-				memcpy(m_data, _other.m_data, sizeof(T) * N * N);
-			}
+		};
 
-			void transpose()
+		template<typename T>
+		struct MatStorage<T, 2>
+		{
+			union
 			{
-				for(int i=0;i<N;++i)
-					for(int j=i+1;j<N;++j)
-						std::swap(m_data[i * N + j], m_data[j * N + i]);
-			}
+				T m_data[4];
+				struct
+				{
+					T v00, v10;
+					T v01, v11;
+				};
+			};
+		};
 
-			void identity()
+		template<typename T>
+		struct MatStorage<T, 3>
+		{
+			union
 			{
-				for(int i=0;i<N*N;++i)
+				T m_data[9];
+				struct
 				{
-					if(i % (N + 1) == 0)
-						m_data[i] = 1;
-					else
-						m_data[i] = 0;
-				}
-			}
+					T v00, v10, v20;
+					T v01, v11, v21;
+					T v02, v12, v22;
+				};
+			};
+		};
 
-			T atRawIndex(int _i) const
+		template<typename T>
+		struct alignas(16) MatStorage<T, 4>
+		{
+			union
 			{
-				if(_i >= N * N || _i < 0) throw Renderer::OutOfRangeException("Index out of range!");
-				return m_data[_i];
-			}
+				T m_data[16];
+				struct
+				{
+					T v00, v10, v20, v30;
+					T v01, v11, v21, v31;
+					T v02, v12, v22, v32;
+					T v03, v13, v23, v33;
+				};
+			};
+		};
+
+		template<typename T, int N>
+		class Mat : public Expression<T, N, MatrixKind>, public MatStorage<T, N>
+		{
+			public:
+				typedef Mat<T, N> Result;
 
-			T at(int _r, int _c) const
-			{
-				if(_r >= N || _r < 0 || _c >= N || _c < 0)
-					throw Renderer::OutOfRangeException("Index out of range!");
-				return m_data[_c * N + _r];
-			}
+				Mat()
+				{
+					identity();
+				}
 
-			void set(int _r, int _c, T _val)
-			{
-				if(_r >= N || _r < 0 || _c >= N || _c < 0)
-					throw Renderer::OutOfRangeException("Index out of range!");
-				m_data[_c * N + _r] = _val;
-			}
+				explicit Mat(NoInit)
+				{ }
 
-			virtual const T* operator*() const
-			{
-				return &m_data[0];
-			}
+				template<typename E, std::enable_if_t<sameShape<E, Mat<T, N>>, int> = 0>
+				Mat(const E& _expression)
+				{
+					evaluate(this->m_data, _expression);
+				}
 
-			virtual Mat<T, N>& operator=(const Mat<T, N>& _other)
-			{
-				if(&_other == this)
+				template<typename E, std::enable_if_t<sameShape<E, Mat<T, N>>, int> = 0>
+				Mat<T, N>& operator=(const E& _expression)
+				{
+					evaluate(this->m_data, _expression);
 					return *this;
+				}
 
-				Mat<T, N> temp(_other);
-				std::swap(m_data, temp.m_data);
-
-				return *this;
-			}
+				// leaves of an expression
+				T element(int _i) const { return this->m_data[_i]; }
+				Simd::Float4 packet(int _i) const { return Simd::load(this->m_data + _i * 4); }
 
-			virtual Vec<T, N> operator*(const Vec<T, N>& _other) const
-			{
-				Vec<T, N> new_vector;
-				for(int i=0;i<N;++i)
+				void transpose()
 				{
-					T sum = 0;
-					for(int k=0;k<N;++k)
-						sum += m_data[k * N + i] * _other.get(k);
-
-					new_vector.set(i, sum);
+					for(int i=0;i<N;++i)
+						for(int j=i+1;j<N;++j)
+							std::swap(this->m_data[i * N + j], this->m_data[j * N + i]);
 				}
 
-				return new_vector;
-			}
-
-			virtual Mat<T, N> operator*(const Mat<T, N>& _other) const
-			{
-				Mat<T, N> new_matrix;
-				for(int i=0;i<N;++i)
+				void identity()
 				{
-					for(int j=0;j<N;++j)
-					{
-						T sum = 0;
-						for(int k=0;k<N;++k)
-							sum += m_data[k * N + i] * _other.at(k, j);
-
-						new_matrix.set(i, j, sum);
-					}
+					for(int i=0;i<N*N;++i)
+						this->m_data[i] = 0;
+					for(int i=0;i<N;++i)
+						this->m_data[i * (N + 1)] = 1;
 				}
 
-				return new_matrix;
-			}
-
-			virtual Mat<T, N> operator+(const Mat<T, N>& _other) const
-			{
-				Mat<T, N> new_matrix;
-				for(int i=0;i<N;++i)
-					for(int j=0;j<N;++j)
-						new_matrix.set(i, j, m_data[j*N+i] + _other.at(i,j));
-
-				return new_matrix;
-			}
-
-			virtual Mat<T, N> operator-(const Mat<T, N>& _other) const
-			{
-				Mat<T, N> new_matrix;
-				for(int i=0;i<N;++i)
-					for(int j=0;j<N;++j)
-						new_matrix.set(i, j, m_data[j*N+i] - _other.at(i,j));
-
-				return new_matrix;
-			}
-
-			virtual bool operator==(const Mat<T, N>& _other) const
-			{
-				Mat<T, N> new_matrix;
-				for(int i=0;i<N*N;++i)
-					if(m_data[i] != _other.atRawIndex(i)) return false;
-
-				return true;
-			}
-
-			virtual bool operator!=(const Mat<T, N>& _other) const
-			{
-				Mat<T, N> new_matrix;
-				for(int i=0;i<N*N;++i)
-					if(m_data[i] != _other.atRawIndex(i)) return true;
-
-				return false;
-			}
+				// unchecked, for loops that already know their bounds
+				T& operator()(int _r, int _c) { return this->m_data[_c * N + _r]; }
+				const T& operator()(int _r, int _c) const { return this->m_data[_c * N + _r]; }
 
-			void print(std::ostream& _os) const
-			{
-				_os << "[\n";
-				for(int i=0;i<N;++i)
+				T atRawIndex(int _i) const
 				{
-					for(int j=0;j<N;++j)
-						_os << m_data[j * N + i] << " ";
-					_os << "\n";
+					if(_i >= N * N || _i < 0) throw Renderer::OutOfRangeException("Index out of range!");
+					return this->m_data[_i];
 				}
-				_os << "]\n";
-			}
-	};
 
-	template<typename T = float>
-	class Mat4 : public Mat<T, 4>
-	{
-		public:
-			T& v00 = this->m_data[0];
-			T& v10 = this->m_data[1];
-			T& v20 = this->m_data[2];
-			T& v30 = this->m_data[3];
-
-			T& v01 = this->m_data[4];
-			T& v11 = this->m_data[5];
-			T& v21 = this->m_data[6];
-			T& v31 = this->m_data[7];
-
-			T& v02 = this->m_data[8];
-			T& v12 = this->m_data[9];
-			T& v22 = this->m_data[10];
-			T& v32 = this->m_data[11];
-
-			T& v03 = this->m_data[12];
-			T& v13 = this->m_data[13];
-			T& v23 = this->m_data[14];
-			T& v33 = this->m_data[15];
-
-			Mat4()
-				: Mat<T, 4>()
-			{ }
-
-			Mat4(T* _arr)
-				: Mat<T, 4>()
-			{
-				memcpy(this->m_data, _arr, sizeof(T) * 16);
-			}
-
-			Mat4(
-					T a00, T a01, T a02, T a03,
-					T a10, T a11, T a12, T a13,
-					T a20, T a21, T a22, T a23,
-					T a30, T a31, T a32, T a33
-			)
-			{
-				v00 = a00;
-				v01 = a01;
-				v02 = a02;
-				v03 = a03;
-
-				v10 = a10;
-				v11 = a11;
-				v12 = a12;
-				v13 = a13;
-
-				v20 = a20;
-				v21 = a21;
-				v22 = a22;
-				v23 = a23;
-
-				v30 = a30;
-				v31 = a31;
-				v32 = a32;
-				v33 = a33;
-			}
-
-			Mat4(const Renderer::Vec4<T>& _basis1, const Renderer::Vec4<T>& _basis2,
-					const Renderer::Vec4<T>& _basis3, const Renderer::Vec4<T>& _basis4)
-			{
-				v00 = _basis1.x;
-				v10 = _basis1.y;
-				v20 = _basis1.z;
-				v30 = _basis1.w;
-
-				v01 = _basis2.x;
-				v11 = _basis2.y;
-				v21 = _basis2.z;
-				v31 = _basis2.w;
-
-				v02 = _basis3.x;
-				v12 = _basis3.y;
-				v22 = _basis3.z;
-				v32 = _basis3.w;
-
-				v03 = _basis4.x;
-				v13 = _basis4.y;
-				v23 = _basis4.z;
-				v33 = _basis4.w;
-			}
-
-			Mat4(const Mat4<T>& _other)
-			{
-				memcpy(this->m_data, _other.m_data, sizeof(T) * 16);
-			}
-
-			const T* operator*() const override
-			{
-				return &(this->m_data[0]);
-			}
-
-			T determinant() const
-			{
-				T determinant_value = 0;
-				for(int i=0;i<4;++i)
+				T at(int _r, int _c) const
 				{
-					T sign = i % 2 == 1 ? -1 : 1;
-					int c0 = i != 0 ? 0 : 1;
-					int c1 = i != 1 && c0 != 1 ? 1 : 2;
-					int c2 = i != 2 && c1 != 2 ? 2 : 3;
-
-					T det3x3 =
-						this->at(1, c0) *
-						(this->at(2, c1) * this->at(3, c2) - this->at(2, c2) * this->at(3, c1)) -
-						this->at(1, c1) *
-						(this->at(2, c0) * this->at(3, c2) - this->at(2, c2) * this->at(3, c0)) +
-						this->at(1, c2) *
-						(this->at(2, c0) * this->at(3, c1) - this->at(2, c1) * this->at(3, c0));
+					if(_r >= N || _r < 0 || _c >= N || _c < 0)
+						throw Renderer::OutOfRangeException("Index out of range!");
+					return this->m_data[_c * N + _r];
+				}
 
-					determinant_value += sign * this->at(0, i) * det3x3;
+				void set(int _r, int _c, T _val)
+				{
+					if(_r >= N || _r < 0 || _c >= N || _c < 0)
+						throw Renderer::OutOfRangeException("Index out of range!");
+					this->m_data[_c * N + _r] = _val;
 				}
 
-				return determinant_value;
-			}
+				const T* operator*() const
+				{
+					return &this->m_data[0];
+				}
 
-			void inverse()
-			{
-				T get_det = determinant();
-				if(get_det == 0)
-					throw Renderer::InvalidOperationException("Mat4 matrix det=0. Cannot take inverse!");
+				bool operator==(const Mat<T, N>& _other) const
+				{
+					for(int i=0;i<N*N;++i)
+						if(this->m_data[i] != _other.m_data[i]) return false;
 
-				T inv_det = ((T)1.f) / get_det;
+					return true;
+				}
 
-				T cpy_data[16];
-				memcpy(cpy_data, this->m_data, sizeof(T) * 16);
+				bool operator!=(const Mat<T, N>& _other) const
+				{
+					return !(*this == _other);
+				}
 
-				for(int i=0;i<4;++i)
+				void print(std::ostream& _os) const
 				{
-					for(int j=0;j<4;++j)
+					_os << "[\n";
+					for(int i=0;i<N;++i)
 					{
-						T sign = (i + j) % 2 == 1 ? -1 : 1;
-
-						// calculate the determinant of the 3x3
-						int r0 = i != 0 ? 0 : 1;
-						int r1 = i != 1 && r0 != 1 ? 1 : 2;
-						int r2 = i != 2 && r1 != 2 ? 2 : 3;
-						int c0 = j != 0 ? 0 : 1;
-						int c1 = j != 1 && c0 != 1 ? 1 : 2;
-						int c2 = j != 2 && c1 != 2 ? 2 : 3;
-
-						T det3x3 =
-							cpy_data[c0*4+r0] *
-							(cpy_data[c1*4+r1] * cpy_data[c2*4+r2] - cpy_data[c1*4+r2] * cpy_data[c2*4+r1]) -
-							cpy_data[c0*4+r1] *
-							(cpy_data[c1*4+r0] * cpy_data[c2*4+r2] - cpy_data[c1*4+r2] * cpy_data[c2*4+r0]) +
-							cpy_data[c0*4+r2] *
-							(cpy_data[c1*4+r0] * cpy_data[c2*4+r1] - cpy_data[c1*4+r1] * cpy_data[c2*4+r0]);
-
-						// j as row i as col -> transpose
-						this->m_data[i * 4 + j] = inv_det * sign * det3x3;
+						for(int j=0;j<N;++j)
+							_os << this->m_data[j * N + i] << " ";
+						_os << "\n";
 					}
+					_os << "]\n";
 				}
-			}
-
-			Mat4<T>& operator=(Mat4<T> _other)
-			{
-				if(&_other == this)
-					return *this;
-
-				Mat4<T> temp(_other);
-				std::swap(temp.m_data, this->m_data);
+		};
 
-				return *this;
-			}
-
-			Vec4<T> operator*(const Vec4<T>& _other) const
-			{
-				return Vec4<T>(
-						_other.x * v00 + _other.y * v01 + _other.z * v02 + _other.w * v03,
-						_other.x * v10 + _other.y * v11 + _other.z * v12 + _other.w * v13,
-						_other.x * v20 + _other.y * v21 + _other.z * v22 + _other.w * v23,
-						_other.x * v30 + _other.y * v31 + _other.z * v32 + _other.w * v33
-				);
-			}
-
-			Mat4<T> operator*(const Mat4<T>& _other) const
-			{
-				Mat4<T> new_matrix;
-				new_matrix.v00 = v00 * _other.v00 + v01 * _other.v10 + v02 * _other.v20 + v03 * _other.v30;
-				new_matrix.v01 = v00 * _other.v01 + v01 * _other.v11 + v02 * _other.v21 + v03 * _other.v31;
-				new_matrix.v02 = v00 * _other.v02 + v01 * _other.v12 + v02 * _other.v22 + v03 * _other.v32;
-				new_matrix.v03 = v00 * _other.v03 + v01 * _other.v13 + v02 * _other.v23 + v03 * _other.v33;
-
-				new_matrix.v10 = v10 * _other.v00 + v11 * _other.v10 + v12 * _other.v20 + v13 * _other.v30;
-				new_matrix.v11 = v10 * _other.v01 + v11 * _other.v11 + v12 * _other.v21 + v13 * _other.v31;
-				new_matrix.v12 = v10 * _other.v02 + v11 * _other.v12 + v12 * _other.v22 + v13 * _other.v32;
-				new_matrix.v13 = v10 * _other.v03 + v11 * _other.v13 + v12 * _other.v23 + v13 * _other.v33;
-
-				new_matrix.v20 = v20 * _other.v00 + v21 * _other.v10 + v22 * _other.v20 + v23 * _other.v30;
-				new_matrix.v21 = v20 * _other.v01 + v21 * _other.v11 + v22 * _other.v21 + v23 * _other.v31;
-				new_matrix.v22 = v20 * _other.v02 + v21 * _other.v12 + v22 * _other.v22 + v23 * _other.v32;
-				new_matrix.v23 = v20 * _other.v03 + v21 * _other.v13 + v22 * _other.v23 + v23 * _other.v33;
-
-				new_matrix.v30 = v30 * _other.v00 + v31 * _other.v10 + v32 * _other.v20 + v33 * _other.v30;
-				new_matrix.v31 = v30 * _other.v01 + v31 * _other.v11 + v32 * _other.v21 + v33 * _other.v31;
-				new_matrix.v32 = v30 * _other.v02 + v31 * _other.v12 + v32 * _other.v22 + v33 * _other.v32;
-				new_matrix.v33 = v30 * _other.v03 + v31 * _other.v13 + v32 * _other.v23 + v33 * _other.v33;
-
-				return new_matrix;
-			}
-
-			Mat4<T> operator+(const Mat4<T>& _other) const
-			{
-				return Mat4<T>(
-						v00 + _other.v00, v01 + _other.v01, v02 + _other.v02, v03 + _other.v03,
-						v10 + _other.v10, v11 + _other.v11, v12 + _other.v12, v13 + _other.v13,
-						v20 + _other.v20, v21 + _other.v21, v22 + _other.v22, v23 + _other.v23,
-						v30 + _other.v30, v31 + _other.v31, v32 + _other.v32, v33 + _other.v33
-				);
-			}
-
-			Mat4<T> operator-(const Mat4<T>& _other) const
-			{
-				return Mat4<T>(
-						v00 - _other.v00, v01 - _other.v01, v02 - _other.v02, v03 - _other.v03,
-						v10 - _other.v10, v11 - _other.v11, v12 - _other.v12, v13 - _other.v13,
-						v20 - _other.v20, v21 - _other.v21, v22 - _other.v22, v23 - _other.v23,
-						v30 - _other.v30, v31 - _other.v31, v32 - _other.v32, v33 - _other.v33
-				);
-			}
-	};
+		template<typename T = float>
+		class Mat4 : public Mat<T, 4>
+		{
+			public:
+				typedef Mat4<T> Result;
 
-	template<typename T = float>
-	class Mat3 : public Mat<T, 3>
-	{
-		public:
-			T& v00 = this->m_data[0];
-			T& v10 = this->m_data[1];
-			T& v20 = this->m_data[2];
+				Mat4()
+					: Mat<T, 4>()
+				{ }
 
-			T& v01 = this->m_data[3];
-			T& v11 = this->m_data[4];
-			T& v21 = this->m_data[5];
+				Mat4(const T* _arr)
+					: Mat<T, 4>(NoInit{})
+				{
+					memcpy(this->m_data, _arr, sizeof(T) * 16);
+				}
 
-			T& v02 = this->m_data[6];
-			T& v12 = this->m_data[7];
-			T& v22 = this->m_data[8];
+				Mat4(
+						T a00, T a01, T a02, T a03,
+						T a10, T a11, T a12, T a13,
+						T a20, T a21, T a22, T a23,
+						T a30, T a31, T a32, T a33
+				)
+					: Mat<T, 4>(NoInit{})
+				{
+					this->v00 = a00;
+					this->v01 = a01;
+					this->v02 = a02;
+					this->v03 = a03;
+
+					this->v10 = a10;
+					this->v11 = a11;
+					this->v12 = a12;
+					this->v13 = a13;
+
+					this->v20 = a20;
+					this->v21 = a21;
+					this->v22 = a22;
+					this->v23 = a23;
+
+					this->v30 = a30;
+					this->v31 = a31;
+					this->v32 = a32;
+					this->v33 = a33;
+				}
 
-			Mat3()
-				: Mat<T, 3>()
-			{ }
+				Mat4(const Renderer::Vec4<T>& _basis1, const Renderer::Vec4<T>& _basis2,
+						const Renderer::Vec4<T>& _basis3, const Renderer::Vec4<T>& _basis4)
+					: Mat<T, 4>(NoInit{})
+				{
+					// each basis is a column, which is exactly how they are stored
+					memcpy(this->m_data, _basis1.m_data, sizeof(T) * 4);
+					memcpy(this->m_data + 4, _basis2.m_data, sizeof(T) * 4);
+					memcpy(this->m_data + 8, _basis3.m_data, sizeof(T) * 4);
+					memcpy(this->m_data + 12, _basis4.m_data, sizeof(T) * 4);
+				}
 
-			Mat3(T* _arr)
-				: Mat<T, 3>()
-			{
-				memcpy(this->m_data, _arr, sizeof(T) * 9);
-			}
+				explicit Mat4(NoInit)
+					: Mat<T, 4>(NoInit{})
+				{ }
 
-			Mat3(
-					T a00, T a01, T a02,
-					T a10, T a11, T a12,
-					T a20, T a21, T a22
-			)
-			{
-				v00 = a00;
-				v01 = a01;
-				v02 = a02;
-				v10 = a10;
-				v11 = a11;
-				v12 = a12;
-				v20 = a20;
-				v21 = a21;
-				v22 = a22;
-			}
+				template<typename E, std::enable_if_t<sameShape<E, Mat4<T>>, int> = 0>
+				Mat4(const E& _expression)
+					: Mat<T, 4>(NoInit{})
+				{
+					evaluate(this->m_data, _expression);
+				}
 
-			Mat3(const Renderer::Vec3<T>& _basis1, const Renderer::Vec3<T>& _basis2,
-					const Renderer::Vec3<T>& _basis3)
-			{
-				v00 = _basis1.x;
-				v10 = _basis1.y;
-				v20 = _basis1.z;
-				v01 = _basis2.x;
-				v11 = _basis2.y;
-				v21 = _basis2.z;
-				v02 = _basis3.x;
-				v12 = _basis3.y;
-				v22 = _basis3.z;
-			}
+				using Mat<T, 4>::operator=;
 
-			Mat3(const Mat3<T>& _other)
-			{
-				memcpy(this->m_data, _other.m_data, sizeof(T) * 9);
-			}
+				T determinant() const
+				{
+					const T* m = this->m_data;
+					return (m[0] * m[5] - m[4] * m[1]) * (m[10] * m[15] - m[14] * m[11]) -
+						(m[0] * m[6] - m[4] * m[2]) * (m[9] * m[15] - m[13] * m[11]) +
+						(m[0] * m[7] - m[4] * m[3]) * (m[9] * m[14] - m[13] * m[10]) +
+						(m[1] * m[6] - m[5] * m[2]) * (m[8] * m[15] - m[12] * m[11]) -
+						(m[1] * m[7] - m[5] * m[3]) * (m[8] * m[14] - m[12] * m[10]) +
+						(m[2] * m[7] - m[6] * m[3]) * (m[8] * m[13] - m[12] * m[9]);
+				}
 
-			T determinant() const
-			{
-				return v00 * (v11 * v22 - v12 * v21) -
-					v01 * (v10 * v22 - v12 * v20) +
-					v02 * (v10 * v21 - v11 * v20);
-			}
+				void transpose()
+				{
+					if constexpr(std::is_same<T, float>::value)
+						Simd::transposeMat4(this->m_data);
+					else
+						Mat<T, 4>::transpose();
+				}
 
-			const T* operator*() const override
-			{
-				return &(this->m_data[0]);
-			}
+				void inverse()
+				{
+					T get_det;
+					if constexpr(std::is_same<T, float>::value)
+						get_det = Simd::inverseMat4(this->m_data, this->m_data);
+					else
+						get_det = Simd::inverseMat4Scalar(this->m_data, this->m_data);
 
-			void inverse()
-			{
-				T get_det = determinant();
-				if(get_det == 0)
-					throw Renderer::InvalidOperationException("Mat3 matrix det=0. Cannot take inverse!");
+					if(get_det == 0)
+						throw Renderer::InvalidOperationException("Mat4 matrix det=0. Cannot take inverse!");
+				}
+		};
 
-				T inv_det = ((T)1.f) / get_det;
+		template<typename T = float>
+		class Mat3 : public Mat<T, 3>
+		{
+			public:
+				typedef Mat3<T> Result;
 
-				T cpy_data[9];
-				memcpy(cpy_data, this->m_data, sizeof(T) * 9);
+				Mat3()
+					: Mat<T, 3>()
+				{ }
 
-				for(int i=0;i<3;++i)
+				Mat3(const T* _arr)
+					: Mat<T, 3>(NoInit{})
 				{
-					for(int j=0;j<3;++j)
-					{
-						T sign = (i + j) % 2 == 1 ? -1 : 1;
-
-						int index_t = i != 0 ? 0 : 1;
-						int index_b = i != 1 && index_t != 1 ? 1 : 2;
-						int index_l = j != 0 ? 0 : 1;
-						int index_r = j != 1 && index_l != 1 ? 1 : 2;
-						// a * b - c * d
-						T component_a = cpy_data[index_l * 3 + index_t];
-						T component_b = cpy_data[index_r * 3 + index_b];
-						T component_c = cpy_data[index_r * 3 + index_t];
-						T component_d = cpy_data[index_l * 3 + index_b];
-
-						// j as row i as col -> transpose
-						this->m_data[i * 3 + j] = inv_det * sign *
-							(component_a * component_b - component_c * component_d);
-					}
+					memcpy(this->m_data, _arr, sizeof(T) * 9);
 				}
-			}
-
-			Mat3<T>& operator=(Mat3<T> _other)
-			{
-				if(&_other == this)
-					return *this;
-
-				Mat3<T> temp(_other);
-				std::swap(_other.m_data, this->m_data);
-
-				return *this;
-			}
 
-			Vec3<T> operator*(const Vec3<T>& _other) const
-			{
-				return Vec3<T>(
-						_other.x * v00 + _other.y * v01 + _other.z * v02,
-						_other.x * v10 + _other.y * v11 + _other.z * v12,
-						_other.x * v20 + _other.y * v21 + _other.z * v22
-				);
-			}
+				Mat3(
+						T a00, T a01, T a02,
+						T a10, T a11, T a12,
+						T a20, T a21, T a22
+				)
+					: Mat<T, 3>(NoInit{})
+				{
+					this->v00 = a00;
+					this->v01 = a01;
+					this->v02 = a02;
+					this->v10 = a10;
+					this->v11 = a11;
+					this->v12 = a12;
+					this->v20 = a20;
+					this->v21 = a21;
+					this->v22 = a22;
+				}
 
-			Mat3<T> operator*(const Mat3<T>& _other) const
-			{
-				Mat3<T> new_matrix;
-				new_matrix.v00 = v00 * _other.v00 + v01 * _other.v10 + v02 * _other.v20;
-				new_matrix.v01 = v00 * _other.v01 + v01 * _other.v11 + v02 * _other.v21;
-				new_matrix.v02 = v00 * _other.v02 + v01 * _other.v12 + v02 * _other.v22;
+				Mat3(const Renderer::Vec3<T>& _basis1, const Renderer::Vec3<T>& _basis2,
+						const Renderer::Vec3<T>& _basis3)
+					: Mat<T, 3>(NoInit{})
+				{
+					memcpy(this->m_data, _basis1.m_data, sizeof(T) * 3);
+					memcpy(this->m_data + 3, _basis2.m_data, sizeof(T) * 3);
+					memcpy(this->m_data + 6, _basis3.m_data, sizeof(T) * 3);
+				}
 
-				new_matrix.v10 = v10 * _other.v00 + v11 * _other.v10 + v12 * _other.v20;
-				new_matrix.v11 = v10 * _other.v01 + v11 * _other.v11 + v12 * _other.v21;
-				new_matrix.v12 = v10 * _other.v02 + v11 * _other.v12 + v12 * _other.v22;
+				explicit Mat3(NoInit)
+					: Mat<T, 3>(NoInit{})
+				{ }
 
-				new_matrix.v20 = v20 * _other.v00 + v21 * _other.v10 + v22 * _other.v20;
-				new_matrix.v21 = v20 * _other.v01 + v21 * _other.v11 + v22 * _other.v21;
-				new_matrix.v22 = v20 * _other.v02 + v21 * _other.v12 + v22 * _other.v22;
+				template<typename E, std::enable_if_t<sameShape<E, Mat3<T>>, int> = 0>
+				Mat3(const E& _expression)
+					: Mat<T, 3>(NoInit{})
+				{
+					evaluate(this->m_data, _expression);
+				}
 
-				return new_matrix;
-			}
+				using Mat<T, 3>::operator=;
 
-			Mat3<T> operator+(const Mat3<T>& _other) const
-			{
-				return Mat3<T>(
-						v00 + _other.v00, v01 + _other.v01, v02 + _other.v02,
-						v10 + _other.v10, v11 + _other.v11, v12 + _other.v12,
-						v20 + _other.v20, v21 + _other.v21, v22 + _other.v22
-				);
-			}
+				T determinant() const
+				{
+					return this->v00 * (this->v11 * this->v22 - this->v12 * this->v21) -
+						this->v01 * (this->v10 * this->v22 - this->v12 * this->v20) +
+						this->v02 * (this->v10 * this->v21 - this->v11 * this->v20);
+				}
 
-			Mat3<T> operator-(const Mat3<T>& _other) const
-			{
-				return Mat3<T>(
-						v00 - _other.v00, v01 - _other.v01, v02 - _other.v02,
-						v10 - _other.v10, v11 - _other.v11, v12 - _other.v12,
-						v20 - _other.v20, v21 - _other.v21, v22 - _other.v22
-				);
-			}
-	};
+				void inverse()
+				{
+					T get_det = determinant();
+					if(get_det == 0)
+						throw Renderer::InvalidOperationException("Mat3 matrix det=0. Cannot take inverse!");
+
+					T inv_det = ((T)1.f) / get_det;
+
+					// the adjugate written out, each entry a signed 2x2 minor of the transpose
+					Mat3<T> m(*this);
+					this->v00 = (m.v11 * m.v22 - m.v12 * m.v21) * inv_det;
+					this->v01 = (m.v02 * m.v21 - m.v01 * m.v22) * inv_det;
+					this->v02 = (m.v01 * m.v12 - m.v02 * m.v11) * inv_det;
+					this->v10 = (m.v12 * m.v20 - m.v10 * m.v22) * inv_det;
+					this->v11 = (m.v00 * m.v22 - m.v02 * m.v20) * inv_det;
+					this->v12 = (m.v02 * m.v10 - m.v00 * m.v12) * inv_det;
+					this->v20 = (m.v10 * m.v21 - m.v11 * m.v20) * inv_det;
+					this->v21 = (m.v01 * m.v20 - m.v00 * m.v21) * inv_det;
+					this->v22 = (m.v00 * m.v11 - m.v01 * m.v10) * inv_det;
+				}
+		};
 
-	template<typename T = float>
-	class Mat2 : public Mat<T, 2>
-	{
-		public:
-			T& v00 = this->m_data[0];
-			T& v10 = this->m_data[1];
+		template<typename T = float>
+		class Mat2 : public Mat<T, 2>
+		{
+			public:
+				typedef Mat2<T> Result;
 
-			T& v01 = this->m_data[2];
-			T& v11 = this->m_data[3];
+				Mat2()
+					: Mat<T, 2>()
+				{ }
 
-			Mat2()
-				: Mat<T, 2>()
-			{ }
+				Mat2(const T* _arr)
+					: Mat<T, 2>(NoInit{})
+				{
+					memcpy(this->m_data, _arr, sizeof(T) * 4);
+				}
 
-			Mat2(T* _arr)
-				: Mat<T, 2>()
-			{
-				memcpy(this->m_data, _arr, sizeof(T) * 4);
-			}
+				Mat2(
+						T a00, T a01,
+						T a10, T a11
+				)
+					: Mat<T, 2>(NoInit{})
+				{
+					this->v00 = a00;
+					this->v01 = a01;
+					this->v10 = a10;
+					this->v11 = a11;
+				}
 
-			Mat2(
-					T a00, T a01,
-					T a10, T a11
-			)
-			{
-				v00 = a00;
-				v01 = a01;
-				v10 = a10;
-				v11 = a11;
-			}
+				Mat2(const Renderer::Vec2<T>& _basis1, const Renderer::Vec2<T>& _basis2)
+					: Mat<T, 2>(NoInit{})
+				{
+					this->v00 = _basis1.x;
+					this->v10 = _basis1.y;
+					this->v01 = _basis2.x;
+					this->v11 = _basis2.y;
+				}
 
-			Mat2(const Renderer::Vec2<T>& _basis1, const Renderer::Vec2<T>& _basis2)
-			{
-				v00 = _basis1.x;
-				v10 = _basis1.y;
-				v01 = _basis2.x;
-				v11 = _basis2.y;
-			}
+				explicit Mat2(NoInit)
+					: Mat<T, 2>(NoInit{})
+				{ }
 
-			Mat2(const Mat2<T>& _other)
-			{
-				memcpy(this->m_data, _other.m_data, sizeof(T) * 4);
-			}
+				template<typename E, std::enable_if_t<sameShape<E, Mat2<T>>, int> = 0>
+				Mat2(const E& _expression)
+					: Mat<T, 2>(NoInit{})
+				{
+					evaluate(this->m_data, _expression);
+				}
 
-			const T* operator*() const override
-			{
-				return &(this->m_data[0]);
-			}
+				using Mat<T, 2>::operator=;
 
-			T determinant() const
-			{
-				return (v00 * v11) - (v01 * v10);
-			}
+				T determinant() const
+				{
+					return (this->v00 * this->v11) - (this->v01 * this->v10);
+				}
 
-			void inverse()
-			{
-				T get_det = determinant();
-				if(get_det == 0)
-					throw Renderer::InvalidOperationException("Mat2 matrix det=0. Cannot take inverse!");
+				void inverse()
+				{
+					T get_det = determinant();
+					if(get_det == 0)
+						throw Renderer::InvalidOperationException("Mat2 matrix det=0. Cannot take inverse!");
 
-				T inv_det = ((T)1.f) / get_det;
+					T inv_det = ((T)1.f) / get_det;
 
-				T v00_cpy = v00;
+					T v00_cpy = this->v00;
 
-				v00 = v11 * inv_det;
-				v11 = v00_cpy * inv_det;
-				v10 *= -inv_det;
-				v01 *= -inv_det;
-			}
+					this->v00 = this->v11 * inv_det;
+					this->v11 = v00_cpy * inv_det;
+					this->v10 *= -inv_det;
+					this->v01 *= -inv_det;
+				}
+		};
 
-			Mat2<T>& operator=(Mat2<T> _other)
-			{
-				if(&_other == this)
-					return *this;
+		// products read whole rows and columns, so they are not part of a tree. both sides are
+		// evaluated first, which also makes m = m * n safe
+		template<typename L, typename R, std::enable_if_t<sameShape<L, R> && isKind<L, MatrixKind>, int> = 0>
+		MoreDerived<typename std::decay_t<L>::Result, typename std::decay_t<R>::Result> operator*(const L& _left, const R& _right)
+		{
+			typedef MoreDerived<typename std::decay_t<L>::Result, typename std::decay_t<R>::Result> M;
+			typedef typename M::Scalar T;
+			constexpr int N = M::Size;
+			const M& a = _left;
+			const M& b = _right;
+
+			M result{ NoInit{} };
+			if constexpr(usesPackets<M>)
+				Simd::mulMat4(a.m_data, b.m_data, result.m_data);
+			else
+				for(int i=0;i<N;++i)
+					for(int j=0;j<N;++j)
+					{
+						T sum = 0;
+						for(int k=0;k<N;++k)
+							sum += a(i, k) * b(k, j);
 
-				Mat2<T> temp(_other);
-				std::swap(_other.m_data, this->m_data);
+						result(i, j) = sum;
+					}
 
-				return *this;
-			}
+			return result;
+		}
 
-			Vec2<T> operator*(const Vec2<T>& _other) const
-			{
-				return Vec2<T>(_other.x * v00 + _other.y * v01, _other.x * v10 + _other.y * v11);
-			}
+		template<typename L, typename R, std::enable_if_t<isKind<L, MatrixKind> && isKind<R, VectorKind> &&
+				std::is_same<typename std::decay_t<L>::Scalar, typename std::decay_t<R>::Scalar>::value &&
+				std::decay_t<L>::Size == std::decay_t<R>::Size, int> = 0>
+		typename std::decay_t<R>::Result operator*(const L& _matrix, const R& _vector)
+		{
+			typedef typename std::decay_t<L>::Result M;
+			typedef typename std::decay_t<R>::Result V;
+			typedef typename M::Scalar T;
+			constexpr int N = M::Size;
+			const M& m = _matrix;
+			const V& v = _vector;
+
+			V result{ NoInit{} };
+			if constexpr(usesPackets<M>)
+				Simd::mulMat4Vec4(m.m_data, v.m_data, result.m_data);
+			else
+				for(int i=0;i<N;++i)
+				{
+					T sum = 0;
+					for(int k=0;k<N;++k)
+						sum += m(i, k) * v[k];
 
-			Mat2<T> operator*(const Mat2<T>& _other) const
-			{
-				Mat2<T> new_matrix;
-				new_matrix.v00 = v00 * _other.v00 + v01 * _other.v10;
-				new_matrix.v01 = v00 * _other.v01 + v01 * _other.v11;
-				new_matrix.v10 = v10 * _other.v00 + v11 * _other.v10;
-				new_matrix.v11 = v10 * _other.v01 + v11 * _other.v11;
+					result[i] = sum;
+				}
 
-				return new_matrix;
-			}
+			return result;
+		}
 
-			Mat2<T> operator+(const Mat2<T>& _other) const
-			{
-				return Mat2<T>(
-						v00 + _other.v00, v01 + _other.v01,
-						v10 + _other.v10, v11 + _other.v11
-				);
-			}
+		static_assert(std::is_trivially_copyable<Mat4<float>>::value && std::is_standard_layout<Mat4<float>>::value,
+				"Mat4 must stay plain data");
+		static_assert(sizeof(Mat4<float>) == 64 && alignof(Mat4<float>) == 16, "Mat4 must be four aligned columns");
 
-			Mat2<T> operator-(const Mat2<T>& _other) const
+		namespace Math
+		{
+			template<typename T>
+			Mat4<T> projection2D(T _l, T _r, T _t, T _b, T _n, T _f)
 			{
-				return Mat2<T>(
-						v00 - _other.v00, v01 - _other.v01,
-						v10 - _other.v10, v11 - _other.v11
+				return Mat4<T>(
+					((T) 2) / (_r - _l), 0, 0, -(_r + _l)/(_r - _l),
+					0, ((T) 2) / (_t - _b), 0, -(_t + _b)/(_t - _b),
+					0, 0, ((T) -2) / (_f - _n), -(_f + _n)/(_f - _n),
+					0, 0, 0, 1
 				);
 			}
-	};
-
-	namespace Math
-	{
-		template<typename T>
-		Mat4<T> projection2D(T _l, T _r, T _t, T _b, T _n, T _f)
-		{
-			return Mat4<T>(
-				((T) 2) / (_r - _l), 0, 0, -(_r + _l)/(_r - _l),
-				0, ((T) 2) / (_t - _b), 0, -(_t + _b)/(_t - _b),
-				0, 0, ((T) -2) / (_f - _n), -(_f + _n)/(_f - _n),
-				0, 0, 0, 1
-			);
 		}
 	}
 }
@@ -0,0 +1,310 @@
+#pragma once
+
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#define RENDERER_MATH_SSE
+	#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+	#define RENDERER_MATH_NEON
+	#include <arm_neon.h>
+#endif
+
+// kernels behind the float Vec4/Mat4, all on column major 16 byte aligned arrays
+namespace Renderer
+{
+	namespace Simd
+	{
+#if defined(RENDERER_MATH_SSE)
+		typedef __m128 Float4;
+
+		inline Float4 load(const float* _p) { return _mm_load_ps(_p); }
+		inline void store(float* _p, Float4 _v) { _mm_store_ps(_p, _v); }
+		inline Float4 splat(float _s) { return _mm_set1_ps(_s); }
+		inline Float4 add(Float4 _a, Float4 _b) { return _mm_add_ps(_a, _b); }
+		inline Float4 sub(Float4 _a, Float4 _b) { return _mm_sub_ps(_a, _b); }
+		inline Float4 mul(Float4 _a, Float4 _b) { return _mm_mul_ps(_a, _b); }
+
+		// _b * _c[L] and _a + _b * _c[L]
+		template<int L>
+		inline Float4 mulLane(Float4 _b, Float4 _c)
+		{
+			return _mm_mul_ps(_b, _mm_shuffle_ps(_c, _c, _MM_SHUFFLE(L, L, L, L)));
+		}
+
+		template<int L>
+		inline Float4 maddLane(Float4 _a, Float4 _b, Float4 _c)
+		{
+			return _mm_add_ps(_a, mulLane<L>(_b, _c));
+		}
+
+		inline float sum(Float4 _v)
+		{
+			Float4 pairs = _mm_add_ps(_v, _mm_movehl_ps(_v, _v));
+			return _mm_cvtss_f32(_mm_add_ss(pairs, _mm_shuffle_ps(pairs, pairs, _MM_SHUFFLE(1, 1, 1, 1))));
+		}
+#elif defined(RENDERER_MATH_NEON)
+		typedef float32x4_t Float4;
+
+		inline Float4 load(const float* _p) { return vld1q_f32(_p); }
+		inline void store(float* _p, Float4 _v) { vst1q_f32(_p, _v); }
+		inline Float4 splat(float _s) { return vdupq_n_f32(_s); }
+		inline Float4 add(Float4 _a, Float4 _b) { return vaddq_f32(_a, _b); }
+		inline Float4 sub(Float4 _a, Float4 _b) { return vsubq_f32(_a, _b); }
+		inline Float4 mul(Float4 _a, Float4 _b) { return vmulq_f32(_a, _b); }
+
+		template<int L>
+		inline Float4 mulLane(Float4 _b, Float4 _c)
+		{
+			return vmulq_n_f32(_b, vgetq_lane_f32(_c, L));
+		}
+
+		template<int L>
+		inline Float4 maddLane(Float4 _a, Float4 _b, Float4 _c)
+		{
+			return vmlaq_n_f32(_a, _b, vgetq_lane_f32(_c, L));
+		}
+
+		inline float sum(Float4 _v)
+		{
+			float32x2_t pairs = vadd_f32(vget_low_f32(_v), vget_high_f32(_v));
+			return vget_lane_f32(vpadd_f32(pairs, pairs), 0);
+		}
+#else
+		struct Float4 { float v[4]; };
+
+		inline Float4 load(const float* _p) { Float4 r; memcpy(r.v, _p, sizeof(r.v)); return r; }
+		inline void store(float* _p, Float4 _v) { memcpy(_p, _v.v, sizeof(_v.v)); }
+		inline Float4 splat(float _s) { return { { _s, _s, _s, _s } }; }
+		inline Float4 add(Float4 _a, Float4 _b) { return { { _a.v[0] + _b.v[0], _a.v[1] + _b.v[1], _a.v[2] + _b.v[2], _a.v[3] + _b.v[3] } }; }
+		inline Float4 sub(Float4 _a, Float4 _b) { return { { _a.v[0] - _b.v[0], _a.v[1] - _b.v[1], _a.v[2] - _b.v[2], _a.v[3] - _b.v[3] } }; }
+		inline Float4 mul(Float4 _a, Float4 _b) { return { { _a.v[0] * _b.v[0], _a.v[1] * _b.v[1], _a.v[2] * _b.v[2], _a.v[3] * _b.v[3] } }; }
+
+		template<int L>
+		inline Float4 mulLane(Float4 _b, Float4 _c)
+		{
+			return mul(_b, splat(_c.v[L]));
+		}
+
+		template<int L>
+		inline Float4 maddLane(Float4 _a, Float4 _b, Float4 _c)
+		{
+			return add(_a, mulLane<L>(_b, _c));
+		}
+
+		inline float sum(Float4 _v)
+		{
+			return (_v.v[0] + _v.v[1]) + (_v.v[2] + _v.v[3]);
+		}
+#endif
+
+		inline float dot4(const float* _a, const float* _b)
+		{
+			return sum(mul(load(_a), load(_b)));
+		}
+
+		// _out = _m * _v, _out may alias _v
+		inline void mulMat4Vec4(const float* _m, const float* _v, float* _out)
+		{
+			Float4 v = load(_v);
+			Float4 r = mulLane<0>(load(_m), v);
+			r = maddLane<1>(r, load(_m + 4), v);
+			r = maddLane<2>(r, load(_m + 8), v);
+			r = maddLane<3>(r, load(_m + 12), v);
+			store(_out, r);
+		}
+
+		// _out = _a * _b, every column of _out is _a applied to the same column of _b
+		inline void mulMat4(const float* _a, const float* _b, float* _out)
+		{
+			Float4 a0 = load(_a);
+			Float4 a1 = load(_a + 4);
+			Float4 a2 = load(_a + 8);
+			Float4 a3 = load(_a + 12);
+
+			Float4 b0 = load(_b);
+			Float4 b1 = load(_b + 4);
+			Float4 b2 = load(_b + 8);
+			Float4 b3 = load(_b + 12);
+
+			// every input is in registers before the first store, so _out may alias either
+			store(_out, maddLane<3>(maddLane<2>(maddLane<1>(mulLane<0>(a0, b0), a1, b0), a2, b0), a3, b0));
+			store(_out + 4, maddLane<3>(maddLane<2>(maddLane<1>(mulLane<0>(a0, b1), a1, b1), a2, b1), a3, b1));
+			store(_out + 8, maddLane<3>(maddLane<2>(maddLane<1>(mulLane<0>(a0, b2), a1, b2), a2, b2), a3, b2));
+			store(_out + 12, maddLane<3>(maddLane<2>(maddLane<1>(mulLane<0>(a0, b3), a1, b3), a2, b3), a3, b3));
+		}
+
+		inline void transposeMat4(float* _m)
+		{
+#if defined(RENDERER_MATH_SSE)
+			__m128 c0 = _mm_load_ps(_m);
+			__m128 c1 = _mm_load_ps(_m + 4);
+			__m128 c2 = _mm_load_ps(_m + 8);
+			__m128 c3 = _mm_load_ps(_m + 12);
+			_MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+			_mm_store_ps(_m, c0);
+			_mm_store_ps(_m + 4, c1);
+			_mm_store_ps(_m + 8, c2);
+			_mm_store_ps(_m + 12, c3);
+#elif defined(RENDERER_MATH_NEON)
+			// the interleaved load de-interleaves the columns into rows
+			float32x4x4_t rows = vld4q_f32(_m);
+			vst1q_f32(_m, rows.val[0]);
+			vst1q_f32(_m + 4, rows.val[1]);
+			vst1q_f32(_m + 8, rows.val[2]);
+			vst1q_f32(_m + 12, rows.val[3]);
+#else
+			for(int i=0;i<4;++i)
+				for(int j=i+1;j<4;++j)
+				{
+					float t = _m[i * 4 + j];
+					_m[i * 4 + j] = _m[j * 4 + i];
+					_m[j * 4 + i] = t;
+				}
+#endif
+		}
+
+		// cofactor expansion through the twelve 2x2 minors, returns the determinant and
+		// leaves _out untouched when it is zero. works for any element type
+		template<typename T>
+		T inverseMat4Scalar(const T* _m, T* _out)
+		{
+			T s0 = _m[0] * _m[5] - _m[4] * _m[1];
+			T s1 = _m[0] * _m[6] - _m[4] * _m[2];
+			T s2 = _m[0] * _m[7] - _m[4] * _m[3];
+			T s3 = _m[1] * _m[6] - _m[5] * _m[2];
+			T s4 = _m[1] * _m[7] - _m[5] * _m[3];
+			T s5 = _m[2] * _m[7] - _m[6] * _m[3];
+
+			T c5 = _m[10] * _m[15] - _m[14] * _m[11];
+			T c4 = _m[9] * _m[15] - _m[13] * _m[11];
+			T c3 = _m[9] * _m[14] - _m[13] * _m[10];
+			T c2 = _m[8] * _m[15] - _m[12] * _m[11];
+			T c1 = _m[8] * _m[14] - _m[12] * _m[10];
+			T c0 = _m[8] * _m[13] - _m[12] * _m[9];
+
+			T det = s0 * c5 - s1 * c4 + s2 * c3 + s3 * c2 - s4 * c1 + s5 * c0;
+			if(det == (T)0)
+				return det;
+
+			T inv = ((T)1) / det;
+			T r[16];
+			r[0] = (_m[5] * c5 - _m[6] * c4 + _m[7] * c3) * inv;
+			r[1] = (-_m[1] * c5 + _m[2] * c4 - _m[3] * c3) * inv;
+			r[2] = (_m[13] * s5 - _m[14] * s4 + _m[15] * s3) * inv;
+			r[3] = (-_m[9] * s5 + _m[10] * s4 - _m[11] * s3) * inv;
+
+			r[4] = (-_m[4] * c5 + _m[6] * c2 - _m[7] * c1) * inv;
+			r[5] = (_m[0] * c5 - _m[2] * c2 + _m[3] * c1) * inv;
+			r[6] = (-_m[12] * s5 + _m[14] * s2 - _m[15] * s1) * inv;
+			r[7] = (_m[8] * s5 - _m[10] * s2 + _m[11] * s1) * inv;
+
+			r[8] = (_m[4] * c4 - _m[5] * c2 + _m[7] * c0) * inv;
+			r[9] = (-_m[0] * c4 + _m[1] * c2 - _m[3] * c0) * inv;
+			r[10] = (_m[12] * s4 - _m[13] * s2 + _m[15] * s0) * inv;
+			r[11] = (-_m[8] * s4 + _m[9] * s2 - _m[11] * s0) * inv;
+
+			r[12] = (-_m[4] * c3 + _m[5] * c1 - _m[6] * c0) * inv;
+			r[13] = (_m[0] * c3 - _m[1] * c1 + _m[2] * c0) * inv;
+			r[14] = (-_m[12] * s3 + _m[13] * s1 - _m[14] * s0) * inv;
+			r[15] = (_m[8] * s3 - _m[9] * s1 + _m[10] * s0) * inv;
+
+			memcpy(_out, r, sizeof(r));
+			return det;
+		}
+
+#if defined(RENDERER_MATH_SSE)
+		// (_v[X] _v[Y] _v[Z] _v[W])
+		template<int X, int Y, int Z, int W>
+		inline __m128 swizzle(__m128 _v)
+		{
+			return _mm_shuffle_ps(_v, _v, _MM_SHUFFLE(W, Z, Y, X));
+		}
+
+		// (_a[X] _a[Y] _b[Z] _b[W])
+		template<int X, int Y, int Z, int W>
+		inline __m128 shuffle(__m128 _a, __m128 _b)
+		{
+			return _mm_shuffle_ps(_a, _b, _MM_SHUFFLE(W, Z, Y, X));
+		}
+
+		// 2x2 blocks packed as (m00 m01 m10 m11)
+		inline __m128 mulMat2(__m128 _a, __m128 _b)
+		{
+			return _mm_add_ps(_mm_mul_ps(_a, swizzle<0, 3, 0, 3>(_b)),
+					_mm_mul_ps(swizzle<1, 0, 3, 2>(_a), swizzle<2, 1, 2, 1>(_b)));
+		}
+
+		// adj(_a) * _b
+		inline __m128 adjMulMat2(__m128 _a, __m128 _b)
+		{
+			return _mm_sub_ps(_mm_mul_ps(swizzle<3, 3, 0, 0>(_a), _b),
+					_mm_mul_ps(swizzle<1, 1, 2, 2>(_a), swizzle<2, 3, 0, 1>(_b)));
+		}
+
+		// _a * adj(_b)
+		inline __m128 mulAdjMat2(__m128 _a, __m128 _b)
+		{
+			return _mm_sub_ps(_mm_mul_ps(_a, swizzle<3, 0, 3, 0>(_b)),
+					_mm_mul_ps(swizzle<1, 0, 3, 2>(_a), swizzle<2, 1, 2, 1>(_b)));
+		}
+#endif
+
+		// returns the determinant, _out is left untouched when it is zero
+		inline float inverseMat4(const float* _m, float* _out)
+		{
+#if defined(RENDERER_MATH_SSE)
+			// blockwise inverse of | A B |
+			//                      | C D |
+			// written for rows, but the inverse of the transpose is the transpose of the
+			// inverse, so running it on the stored columns gives the columns of the result
+			__m128 r0 = _mm_load_ps(_m);
+			__m128 r1 = _mm_load_ps(_m + 4);
+			__m128 r2 = _mm_load_ps(_m + 8);
+			__m128 r3 = _mm_load_ps(_m + 12);
+
+			__m128 a = _mm_movelh_ps(r0, r1);
+			__m128 b = _mm_movehl_ps(r1, r0);
+			__m128 c = _mm_movelh_ps(r2, r3);
+			__m128 d = _mm_movehl_ps(r3, r2);
+
+			// (|A| |B| |C| |D|)
+			__m128 det_sub = _mm_sub_ps(
+					_mm_mul_ps(shuffle<0, 2, 0, 2>(r0, r2), shuffle<1, 3, 1, 3>(r1, r3)),
+					_mm_mul_ps(shuffle<1, 3, 1, 3>(r0, r2), shuffle<0, 2, 0, 2>(r1, r3)));
+			__m128 det_a = swizzle<0, 0, 0, 0>(det_sub);
+			__m128 det_b = swizzle<1, 1, 1, 1>(det_sub);
+			__m128 det_c = swizzle<2, 2, 2, 2>(det_sub);
+			__m128 det_d = swizzle<3, 3, 3, 3>(det_sub);
+
+			__m128 d_c = adjMulMat2(d, c);
+			__m128 a_b = adjMulMat2(a, b);
+			__m128 x = _mm_sub_ps(_mm_mul_ps(det_d, a), mulMat2(b, d_c));
+			__m128 w = _mm_sub_ps(_mm_mul_ps(det_a, d), mulMat2(c, a_b));
+			__m128 y = _mm_sub_ps(_mm_mul_ps(det_b, c), mulAdjMat2(d, a_b));
+			__m128 z = _mm_sub_ps(_mm_mul_ps(det_c, b), mulAdjMat2(a, d_c));
+
+			// |M| = |A||D| + |B||C| - tr(adj(A)B adj(D)C)
+			float det = _mm_cvtss_f32(det_a) * _mm_cvtss_f32(det_d) + _mm_cvtss_f32(det_b) * _mm_cvtss_f32(det_c) -
+				sum(_mm_mul_ps(a_b, swizzle<0, 2, 1, 3>(d_c)));
+			if(det == 0.f)
+				return det;
+
+			__m128 inv_det = _mm_div_ps(_mm_setr_ps(1.f, -1.f, -1.f, 1.f), _mm_set1_ps(det));
+			x = _mm_mul_ps(x, inv_det);
+			y = _mm_mul_ps(y, inv_det);
+			z = _mm_mul_ps(z, inv_det);
+			w = _mm_mul_ps(w, inv_det);
+
+			// the adjugate of each block folded into the shuffle that unpacks them
+			_mm_store_ps(_out, shuffle<3, 1, 3, 1>(x, y));
+			_mm_store_ps(_out + 4, shuffle<2, 0, 2, 0>(x, y));
+			_mm_store_ps(_out + 8, shuffle<3, 1, 3, 1>(z, w));
+			_mm_store_ps(_out + 12, shuffle<2, 0, 2, 0>(z, w));
+			return det;
+#else
+			return inverseMat4Scalar(_m, _out);
+#endif
+		}
+	}
+}
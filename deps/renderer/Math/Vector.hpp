@@ -3,534 +3,420 @@
 #include <cmath>
 #include <iostream>
 #include <cstring>
+#include <type_traits>
 
 #include "../Utils/Exceptions.hpp"
+#include "Simd.hpp"
+#include "Expression.hpp"
 
 namespace Renderer
 {
-	template<typename T, int N>
-	class Vec
+	// the prebuilt library still holds weak copies of the old virtual math classes. the inline
+	// namespace gives these types their own mangled names so the linker never merges the two
+	// layouts, while every Renderer::Vec3 and Renderer::Math spelling keeps resolving here
+	inline namespace Pod
 	{
-		protected:
+		// plain storage, the sizes with named components alias them over the array
+		template<typename T, int N>
+		struct VecStorage
+		{
 			T m_data[N];
-		public:
-			Vec()
-			{
-				for(int i=0;i<N;++i)
-					m_data[i] = 0;
-			}
-
-			Vec(const Vec<T, N>& _other)
-			{
-				for(int i=0;i<N;++i)
-					m_data[i] = _other.get(i);
-			}
-
-			void set(int _index, T _value)
-			{
-				if(_index >= N || _index < 0)
-					throw Renderer::OutOfRangeException("Index out of range!");
-
-				m_data[_index] = _value;
-			}
-
-			T get(int _index) const
-			{
-				if(_index >= N || _index < 0)
-					throw Renderer::OutOfRangeException("Index out of range!");
-
-				return m_data[_index];
-			}
-
-			T length() const
-			{
-				T sq_len = 0;
-				for(int i=0;i<N;++i)
-					sq_len += m_data[i] * m_data[i];
-
-				return std::sqrt(sq_len);
-			}
-
-			void normalize()
-			{
-				T len = length();
-				for(int i=0;i<N;++i)
-					m_data[i] /= len;
-			}
-
-			virtual Vec<T, N>& operator=(const Vec<T, N>& _other)
-			{
-				if(&_other == this)
-					return *this;
-
-				for(int i=0;i<N;++i)
-					m_data[i] = _other.get(i);
-
-				return *this;
-			}
-
-			virtual const T* operator*() const
-			{
-				return &m_data[0];
-			}
-
-			virtual Vec<T, N> operator*(const Vec<T, N>& _other) const
-			{
-				Vec<T, N> new_vector;
-				for(int i=0;i<N;++i)
-					new_vector.set(i, m_data[i] * _other.get(i));
-
-				return new_vector;
-			}
-
-			virtual Vec<T, N> operator*(T _scalar) const
-			{
-				Vec<T, N> new_vector;
-				for(int i=0;i<N;++i)
-					new_vector.set(i, m_data[i] * _scalar);
-
-				return new_vector;
-			}
-
-			virtual Vec<T, N> operator+(const Vec<T, N>& _other) const
-			{
-				Vec<T, N> new_vector;
-				for(int i=0;i<N;++i)
-					new_vector.set(i, m_data[i] + _other.get(i));
-
-				return new_vector;
-			}
-
-			virtual Vec<T, N> operator-(const Vec<T, N>& _other) const
-			{
-				Vec<T, N> new_vector;
-				for(int i=0;i<N;++i)
-					new_vector.set(i, m_data[i] - _other.get(i));
-
-				return new_vector;
-			}
-
-			bool operator==(const Vec<T, N>& _other) const
-			{
-				for(int i=0;i<N;++i)
-					if(_other.get(i) != m_data[i]) return false;
-
-				return true;
-			}
-
-			bool operator!=(const Vec<T, N>& _other) const
-			{
-				for(int i=0;i<N;++i)
-					if(_other.get(i) != m_data[i]) return true;
-
-				return false;
-			}
-
-			virtual T dot(Vec<T, N> _other) const
-			{
-				T result = 0;
-				for(int i=0;i<N;++i)
-					result += m_data[i] * _other.get(i);
-
-				return result;
-			}
-
-			virtual void print(std::ostream& _os, bool _newline = false) const
-			{
-				_os << "< ";
-				for(int i=0;i<N;++i)
-					_os << m_data[i] << " ";
-				_os << ">";
-
-				if(_newline)
-					_os << "\n";
-			}
-	};
-
-	template<typename T = float>
-	class Vec4 : public Vec<T, 4>
-	{
-		public:
-			T& x = this->m_data[0];
-			T& y = this->m_data[1];
-			T& z = this->m_data[2];
-			T& w = this->m_data[3];
-
-			Vec4()
-				: Vec<T, 4>()
-			{ }
-
-			Vec4(T _v)
-				: Vec<T, 4>()
-			{
-				x = _v;
-				y = _v;
-				z = _v;
-				w = _v;
-			}
-
-			Vec4(T _x, T _y, T _z, T _w=(T)1)
-				: Vec<T, 4>()
-			{
-				x = _x;
-				y = _y;
-				z = _z;
-				w = _w;
-			}
-
-			Vec4(const Vec4<T>& _other)
-				: Vec<T, 4>()
-			{
-				x = _other.x;
-				y = _other.y;
-				z = _other.z;
-				w = _other.w;
-			}
-
-			virtual const T* operator*() const override
-			{
-				return &(this->m_data[0]);
-			}
-
-			Vec4& operator=(Vec4<T> _other)
-			{
-				if(&_other == this)
-					return *this;
-
-				x = _other.x;
-				y = _other.y;
-				z = _other.z;
-				w = _other.w;
-				return *this;
-			}
-
-			Vec4 operator*(Vec4<T> _other) const
-			{
-				Vec4<T> result;
-				result.x = x * _other.x;
-				result.y = y * _other.y;
-				result.z = z * _other.z;
-				result.w = w * _other.w;
-
-				return result;
-			}
-
-			Vec4 operator+(Vec4<T> _other) const
-			{
-				Vec4<T> result;
-				result.x = x + _other.x;
-				result.y = y + _other.y;
-				result.z = z + _other.z;
-				result.w = w + _other.w;
-
-				return result;
-			}
-
-			Vec4 operator-(Vec4<T> _other) const
-			{
-				Vec4<T> result;
-				result.x = x - _other.x;
-				result.y = y - _other.y;
-				result.z = z - _other.z;
-				result.w = w - _other.w;
-
-				return result;
-			}
-
-			Vec4<T> reflect(Vec4<T> _other) const
-			{
-				Vec4<T> projection = project(_other) * (T)(2.f);
-				return projection - *this;
-			}
-
-			Vec4<T> project(Vec4<T> _other) const
-			{
-				T other_dot_self = _other.dot(_other);
-				if(other_dot_self == (T)(0))
-					return Vec4<T>(0, 0, 0, 0);
-
-				T this_dot_other = this->dot(_other);
+		};
 
-				T scale = this_dot_other / other_dot_self;
-				return _other * scale;
-			}
-
-			Vec4<T> Q_mult(Vec4<T> _other) const
-			{
-				T component_x = w * _other.x + x * _other.w + y * _other.z - z * _other.y;
-				T component_y = w * _other.y - x * _other.z + y * _other.w + z * _other.x;
-				T component_z = w * _other.z + x * _other.y - y * _other.x + z * _other.w;
-				T real_component = w * _other.w - x * _other.x - y * _other.y - z * _other.z;
-
-				return Vec4<T>(component_x, component_y, component_z, real_component);
-			}
-
-			void Q_inverse()
-			{
-				T length_sq = x * x + y * y + z * z + w * w;
-				length_sq = (T)(1.f) / length_sq;
-				x = -x * length_sq;
-				y = -y * length_sq;
-				z = -z * length_sq;
-				w = w * length_sq;
-			}
-	};
-
-	template<typename T = float>
-	class Vec3 : public Vec<T, 3>
-	{
-		public:
-			T& x = this->m_data[0];
-			T& y = this->m_data[1];
-			T& z = this->m_data[2];
-
-			Vec3()
-				: Vec<T, 3>()
-			{ }
-
-			Vec3(T _v)
-				: Vec<T, 3>()
-			{
-				x = _v;
-				y = _v;
-				z = _v;
-			}
-
-			Vec3(T _x, T _y, T _z)
-				: Vec<T, 3>()
+		template<typename T>
+		struct VecStorage<T, 2>
+		{
+			union
 			{
-				x = _x;
-				y = _y;
-				z = _z;
-			}
+				T m_data[2];
+				struct { T x, y; };
+			};
+		};
 
-			Vec3(const Vec3<T>& _other)
-				: Vec<T, 3>()
+		template<typename T>
+		struct VecStorage<T, 3>
+		{
+			union
 			{
-				x = _other.x;
-				y = _other.y;
-				z = _other.z;
-			}
+				T m_data[3];
+				struct { T x, y, z; };
+			};
+		};
 
-			virtual const T* operator*() const override
+		template<typename T>
+		struct alignas(16) VecStorage<T, 4>
+		{
+			union
 			{
-				return &(this->m_data[0]);
-			}
+				T m_data[4];
+				struct { T x, y, z, w; };
+			};
+		};
 
-			Vec3& operator=(Vec3<T> _other)
-			{
-				if(&_other == this)
+		template<typename T, int N>
+		class Vec : public Expression<T, N, VectorKind>, public VecStorage<T, N>
+		{
+			public:
+				typedef Vec<T, N> Result;
+
+				Vec()
+				{
+					for(int i=0;i<N;++i)
+						this->m_data[i] = 0;
+				}
+
+				explicit Vec(NoInit)
+				{ }
+
+				template<typename E, std::enable_if_t<sameShape<E, Vec<T, N>>, int> = 0>
+				Vec(const E& _expression)
+				{
+					evaluate(this->m_data, _expression);
+				}
+
+				template<typename E, std::enable_if_t<sameShape<E, Vec<T, N>>, int> = 0>
+				Vec<T, N>& operator=(const E& _expression)
+				{
+					evaluate(this->m_data, _expression);
 					return *this;
+				}
+
+				// leaves of an expression
+				T element(int _i) const { return this->m_data[_i]; }
+				Simd::Float4 packet(int _i) const { return Simd::load(this->m_data + _i * 4); }
+
+				// unchecked, for loops that already know their bounds
+				T& operator[](int _index) { return this->m_data[_index]; }
+				const T& operator[](int _index) const { return this->m_data[_index]; }
+
+				void set(int _index, T _value)
+				{
+					if(_index >= N || _index < 0)
+						throw Renderer::OutOfRangeException("Index out of range!");
+
+					this->m_data[_index] = _value;
+				}
+
+				T get(int _index) const
+				{
+					if(_index >= N || _index < 0)
+						throw Renderer::OutOfRangeException("Index out of range!");
+
+					return this->m_data[_index];
+				}
+
+				T length() const
+				{
+					return std::sqrt(dot(*this));
+				}
+
+				void normalize()
+				{
+					T len = length();
+					for(int i=0;i<N;++i)
+						this->m_data[i] /= len;
+				}
+
+				const T* operator*() const
+				{
+					return &this->m_data[0];
+				}
+
+				bool operator==(const Vec<T, N>& _other) const
+				{
+					for(int i=0;i<N;++i)
+						if(_other[i] != this->m_data[i]) return false;
+
+					return true;
+				}
+
+				bool operator!=(const Vec<T, N>& _other) const
+				{
+					return !(*this == _other);
+				}
+
+				T dot(const Vec<T, N>& _other) const
+				{
+					T result = 0;
+					for(int i=0;i<N;++i)
+						result += this->m_data[i] * _other[i];
+
+					return result;
+				}
+
+				void print(std::ostream& _os, bool _newline = false) const
+				{
+					_os << "< ";
+					for(int i=0;i<N;++i)
+						_os << this->m_data[i] << " ";
+					_os << ">";
+
+					if(_newline)
+						_os << "\n";
+				}
+		};
+
+		template<typename T = float>
+		class Vec4 : public Vec<T, 4>
+		{
+			public:
+				typedef Vec4<T> Result;
+
+				Vec4()
+					: Vec<T, 4>()
+				{ }
+
+				Vec4(T _v)
+				{
+					this->x = _v;
+					this->y = _v;
+					this->z = _v;
+					this->w = _v;
+				}
+
+				Vec4(T _x, T _y, T _z, T _w=(T)1)
+				{
+					this->x = _x;
+					this->y = _y;
+					this->z = _z;
+					this->w = _w;
+				}
+
+				explicit Vec4(NoInit)
+					: Vec<T, 4>(NoInit{})
+				{ }
+
+				template<typename E, std::enable_if_t<sameShape<E, Vec4<T>>, int> = 0>
+				Vec4(const E& _expression)
+					: Vec<T, 4>(NoInit{})
+				{
+					evaluate(this->m_data, _expression);
+				}
+
+				using Vec<T, 4>::operator=;
+
+				T dot(const Vec<T, 4>& _other) const
+				{
+					if constexpr(std::is_same<T, float>::value)
+						return Simd::dot4(this->m_data, _other.m_data);
+					else
+						return Vec<T, 4>::dot(_other);
+				}
+
+				Vec4<T> reflect(const Vec4<T>& _other) const
+				{
+					return project(_other) * (T)(2.f) - *this;
+				}
+
+				Vec4<T> project(const Vec4<T>& _other) const
+				{
+					T other_dot_self = _other.dot(_other);
+					if(other_dot_self == (T)(0))
+						return Vec4<T>(0, 0, 0, 0);
+
+					T this_dot_other = this->dot(_other);
+
+					T scale = this_dot_other / other_dot_self;
+					return _other * scale;
+				}
+
+				Vec4<T> Q_mult(const Vec4<T>& _other) const
+				{
+					const T x = this->x, y = this->y, z = this->z, w = this->w;
+					T component_x = w * _other.x + x * _other.w + y * _other.z - z * _other.y;
+					T component_y = w * _other.y - x * _other.z + y * _other.w + z * _other.x;
+					T component_z = w * _other.z + x * _other.y - y * _other.x + z * _other.w;
+					T real_component = w * _other.w - x * _other.x - y * _other.y - z * _other.z;
+
+					return Vec4<T>(component_x, component_y, component_z, real_component);
+				}
+
+				void Q_inverse()
+				{
+					T length_sq = dot(*this);
+					length_sq = (T)(1.f) / length_sq;
+					this->x = -this->x * length_sq;
+					this->y = -this->y * length_sq;
+					this->z = -this->z * length_sq;
+					this->w = this->w * length_sq;
+				}
+		};
+
+		template<typename T = float>
+		class Vec3 : public Vec<T, 3>
+		{
+			public:
+				typedef Vec3<T> Result;
+
+				Vec3()
+					: Vec<T, 3>()
+				{ }
+
+				Vec3(T _v)
+				{
+					this->x = _v;
+					this->y = _v;
+					this->z = _v;
+				}
+
+				Vec3(T _x, T _y, T _z)
+				{
+					this->x = _x;
+					this->y = _y;
+					this->z = _z;
+				}
+
+				explicit Vec3(NoInit)
+					: Vec<T, 3>(NoInit{})
+				{ }
+
+				template<typename E, std::enable_if_t<sameShape<E, Vec3<T>>, int> = 0>
+				Vec3(const E& _expression)
+					: Vec<T, 3>(NoInit{})
+				{
+					evaluate(this->m_data, _expression);
+				}
+
+				using Vec<T, 3>::operator=;
+
+				Vec3<T> reflect(const Vec3<T>& _other) const
+				{
+					return project(_other) * (T)(2.f) - *this;
+				}
+
+				Vec3<T> project(const Vec3<T>& _other) const
+				{
+					T other_dot_self = _other.dot(_other);
+					if(other_dot_self == (T)(0))
+						return Vec3<T>(0, 0, 0);
+
+					T this_dot_other = this->dot(_other);
+
+					T scale = this_dot_other / other_dot_self;
+					return _other * scale;
+				}
+
+				Vec3<T> cross(const Vec3<T>& _other) const
+				{
+					T component_x = this->y * _other.z - this->z * _other.y;
+					T component_y = -(this->x * _other.z - this->z * _other.x);
+					T component_z = this->x * _other.y - this->y * _other.x;
+
+					return Vec3<T>(component_x, component_y, component_z);
+				}
+		};
+
+		template<typename T = float>
+		class Vec2 : public Vec<T, 2>
+		{
+			public:
+				typedef Vec2<T> Result;
+
+				Vec2()
+					: Vec<T, 2>()
+				{ }
+
+				Vec2(T _v)
+				{
+					this->x = _v;
+					this->y = _v;
+				}
+
+				Vec2(T _x, T _y)
+				{
+					this->x = _x;
+					this->y = _y;
+				}
+
+				explicit Vec2(NoInit)
+					: Vec<T, 2>(NoInit{})
+				{ }
+
+				template<typename E, std::enable_if_t<sameShape<E, Vec2<T>>, int> = 0>
+				Vec2(const E& _expression)
+					: Vec<T, 2>(NoInit{})
+				{
+					evaluate(this->m_data, _expression);
+				}
+
+				using Vec<T, 2>::operator=;
+
+				Vec2<T> reflect(const Vec2<T>& _other) const
+				{
+					return project(_other) * (T)(2.f) - *this;
+				}
+
+				Vec2<T> project(const Vec2<T>& _other) const
+				{
+					T other_dot_self = _other.dot(_other);
+					if(other_dot_self == (T)(0))
+						return Vec2<T>(0, 0);
+
+					T this_dot_other = this->dot(_other);
+
+					T scale = this_dot_other / other_dot_self;
+					return _other * scale;
+				}
+		};
+
+		static_assert(std::is_trivially_copyable<Vec4<float>>::value && std::is_standard_layout<Vec4<float>>::value,
+				"Vec4 must stay plain data");
+		static_assert(sizeof(Vec4<float>) == 16 && alignof(Vec4<float>) == 16, "Vec4 must be one aligned register");
+		static_assert(sizeof(Vec3<float>) == 12 && sizeof(Vec2<float>) == 8, "vectors must be tightly packed");
+
+		namespace Math
+		{
+			const float PI = 3.14159265359;
 
-				x = _other.x;
-				y = _other.y;
-				z = _other.z;
-				return *this;
-			}
-
-			Vec3 operator*(Vec3<T> _other) const
-			{
-				Vec3<T> result;
-				result.x = x * _other.x;
-				result.y = y * _other.y;
-				result.z = z * _other.z;
-
-				return result;
-			}
-
-			Vec3 operator+(Vec3<T> _other) const
-			{
-				Vec3<T> result;
-				result.x = x + _other.x;
-				result.y = y + _other.y;
-				result.z = z + _other.z;
-
-				return result;
-			}
-
-			Vec3 operator-(Vec3<T> _other) const
-			{
-				Vec3<T> result;
-				result.x = x - _other.x;
-				result.y = y - _other.y;
-				result.z = z - _other.z;
-
-				return result;
-			}
-
-			Vec3<T> reflect(Vec3<T> _other) const
-			{
-				Vec3<T> projection = project(_other) * (T)(2.f);
-				return projection - *this;
-			}
-
-			Vec3<T> project(Vec3<T> _other) const
-			{
-				T other_dot_self = _other.dot(_other);
-				if(other_dot_self == (T)(0))
-					return Vec3<T>(0, 0, 0);
-
-				T this_dot_other = this->dot(_other);
-
-				T scale = this_dot_other / other_dot_self;
-				return _other * scale;
-			}
-
-			Vec3<T> cross(Vec3<T> _other) const
-			{
-				T component_x = y * _other.z - z * _other.y;
-				T component_y = -(x * _other.z - z * _other.x);
-				T component_z = x * _other.y - y * _other.x;
-
-				return Vec3<T>(component_x, component_y, component_z);
-			}
-	};
-
-	template<typename T = float>
-	class Vec2 : public Vec<T, 2>
-	{
-		public:
-			T& x = this->m_data[0];
-			T& y = this->m_data[1];
-
-			Vec2()
-				: Vec<T, 2>()
-			{ }
-
-			Vec2(T _v)
-				: Vec<T, 2>()
-			{
-				x = _v;
-				y = _v;
-			}
-
-			Vec2(T _x, T _y)
-				: Vec<T, 2>()
-			{
-				x = _x;
-				y = _y;
-			}
-
-			Vec2(const Vec2<T>& _other)
-				: Vec<T, 2>()
-			{
-				x = _other.x;
-				y = _other.y;
-			}
-
-			virtual const T* operator*() const override
-			{
-				return &(this->m_data[0]);
-			}
-
-			Vec2& operator=(Vec2<T> _other)
+			template<typename T>
+			T Lerp(T _start, T _end, float _t)
 			{
-				if(&_other == this)
-					return *this;
-
-				x = _other.x;
-				y = _other.y;
-				return *this;
+				T difference = _end - _start;
+				return _start + (difference * _t);
 			}
 
-			Vec2 operator*(Vec2<T> _other) const
+			template<typename T>
+			Vec3<T> Slerp(Vec3<T> _start, Vec3<T> _end, float _t)
 			{
-				Vec2<T> result;
-				result.x = x * _other.x;
-				result.y = y * _other.y;
+				// make sure the two vectors are normalized
+				_start.normalize();
+				_end.normalize();
 
-				return result;
-			}
+				// calculate the angle
+				float calculate_angle = std::acos(_start.dot(_end));
+				// if angle = 0, _start = _end
+				if(calculate_angle == 0.f) return _start;
 
-			Vec2 operator+(Vec2<T> _other) const
-			{
-				Vec2<T> result;
-				result.x = x + _other.x;
-				result.y = y + _other.y;
+				// calculate the weights
+				T weight_one = (T)(std::sin((1.f - _t) * calculate_angle));
+				T weight_two = (T)(std::sin(_t * calculate_angle));
+				T csc_angle = (T)(1.f / std::sin(calculate_angle));
 
-				return result;
+				// return the interpolated vector
+				return ((_start * weight_one) + (_end * weight_two)) * csc_angle;
 			}
 
-			Vec2 operator-(Vec2<T> _other) const
+			template<typename T>
+			void RotateVec3(Renderer::Vec3<T>& _rotateVector, Renderer::Vec3<T> _axis, float _angle)
 			{
-				Vec2<T> result;
-				result.x = x - _other.x;
-				result.y = y - _other.y;
-
-				return result;
-			}
+				_axis.normalize();
+				// create the q quaternion
+				T cos_angle = std::cos(_angle / 2.f);
+				_axis = _axis * (T)(std::sin(_angle / 2.f));
+				Renderer::Vec4<T> vector_q(_axis.x, _axis.y, _axis.z, cos_angle);
 
-			Vec2<T> reflect(Vec2<T> _other) const
-			{
-				Vec2<T> projection = project(_other) * (T)(2.f);
-				return projection - *this;
-			}
+				// create the q^-1 quaternion
+				Renderer::Vec4<T> vector_q_inv = vector_q;
+				vector_q_inv.Q_inverse();
 
-			Vec2<T> project(Vec2<T> _other) const
-			{
-				T other_dot_self = _other.dot(_other);
-				if(other_dot_self == (T)(0))
-					return Vec2<T>(0, 0);
+				Renderer::Vec4<T> vector_quaternion(_rotateVector.x, _rotateVector.y, _rotateVector.z, (T)0);
 
-				T this_dot_other = this->dot(_other);
+				vector_quaternion = vector_q.Q_mult(vector_quaternion).Q_mult(vector_q_inv);
 
-				T scale = this_dot_other / other_dot_self;
-				return _other * scale;
+				_rotateVector.x = vector_quaternion.x;
+				_rotateVector.y = vector_quaternion.y;
+				_rotateVector.z = vector_quaternion.z;
 			}
-	};
-
-	namespace Math
-	{
-		const float PI = 3.14159265359;
-
-		template<typename T>
-		T Lerp(T _start, T _end, float _t)
-		{
-			T difference = _end - _start;
-			return _start + (difference * _t);
-		}
-
-		template<typename T>
-		Vec3<T> Slerp(Vec3<T> _start, Vec3<T> _end, float _t)
-		{
-			// make sure the two vectors are normalized
-			_start.normalize();
-			_end.normalize();
-
-			// calculate the angle
-			float calculate_angle = std::acos(_start.dot(_end));
-			// if angle = 0, _start = _end
-			if(calculate_angle == 0.f) return _start;
-
-			// calculate the weights
-			T weight_one = (T)(std::sin((1.f - _t) * calculate_angle));
-			T weight_two = (T)(std::sin(_t * calculate_angle));
-			T csc_angle = (T)(1.f / std::sin(calculate_angle));
-
-			// return the interpolated vector
-			return ((_start * weight_one) + (_end * weight_two)) * csc_angle;
-		}
-
-		template<typename T>
-		void RotateVec3(Renderer::Vec3<T>& _rotateVector, Renderer::Vec3<T> _axis, float _angle)
-		{
-			_axis.normalize();
-			// create the q quaternion
-			T cos_angle = std::cos(_angle / 2.f);
-			_axis = _axis * (T)(std::sin(_angle / 2.f));
-			Renderer::Vec4<T> vector_q(_axis.x, _axis.y, _axis.z, cos_angle);
-
-			// create the q^-1 quaternion
-			Renderer::Vec4<T> vector_q_inv = vector_q;
-			vector_q_inv.Q_inverse();
-
-			Renderer::Vec4<T> vector_quaternion(_rotateVector.x, _rotateVector.y, _rotateVector.z, (T)0);
-
-			vector_quaternion = vector_q.Q_mult(vector_quaternion).Q_mult(vector_q_inv);
-
-			_rotateVector.x = vector_quaternion.x;
-			_rotateVector.y = vector_quaternion.y;
-			_rotateVector.z = vector_quaternion.z;
 		}
 	}
 }
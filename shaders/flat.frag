@@ -0,0 +1,9 @@
+#version 410 core
+
+precision highp float;
+
+layout (location=0) out vec4 FragColor;
+
+void main() {
+	FragColor = vec4(0.34f, 0.7f, 1.f, 1.0);
+}
@@ -0,0 +1,18 @@
+#version 410 core
+
+layout (location=0) in vec3 a_position;
+
+layout (std140) uniform FrameData
+{
+	mat4 u_view;
+	mat4 u_projection;
+	mat4 u_viewProjection;
+	vec4 u_camera;
+	float u_time;
+};
+
+// cheap stand in for the surface shader while it compiles
+void main()
+{
+	gl_Position = u_viewProjection * vec4(a_position, 1.0);
+}
@@ -0,0 +1,28 @@
+#version 410 core
+
+precision highp float;
+
+layout (location=0) out vec4 FragColor;
+
+// equirectangular, streamed in as the view needs its levels
+uniform sampler2D u_sky;
+
+in vec3 v_direction;
+
+const float PI = 3.14159265;
+
+void main() {
+	vec3 direction = normalize(v_direction);
+
+	// the mapping the environment bake uses, so the backdrop lines up with the reflections
+	float u = atan(direction.z, direction.x) / (2.0 * PI);
+	float v = acos(clamp(direction.y, -1.0, 1.0)) / PI;
+
+	// u jumps by one where atan wraps, take its derivatives from whichever side does not
+	float u_wrapped = fract(u);
+	float du_dx = abs(dFdx(u)) < abs(dFdx(u_wrapped)) ? dFdx(u) : dFdx(u_wrapped);
+	float du_dy = abs(dFdy(u)) < abs(dFdy(u_wrapped)) ? dFdy(u) : dFdy(u_wrapped);
+
+	vec3 color = textureGrad(u_sky, vec2(u, v), vec2(du_dx, dFdx(v)), vec2(du_dy, dFdy(v))).rgb;
+	FragColor = vec4(color, 1.0);
+}
@@ -0,0 +1,24 @@
+#version 410 core
+
+layout (location=0) in vec2 a_position;
+
+layout (std140) uniform FrameData
+{
+	mat4 u_view;
+	mat4 u_projection;
+	mat4 u_viewProjection;
+	vec4 u_camera;
+	float u_time;
+};
+
+out vec3 v_direction;
+
+void main()
+{
+	// the view ray through the corner is linear across the screen, so it interpolates exactly
+	vec3 ray = vec3(a_position.x / u_projection[0][0], a_position.y / u_projection[1][1], -1.0);
+	v_direction = transpose(mat3(u_view)) * ray;
+
+	// halfway into the depth range, the sky writes no depth so anything drawn later covers it
+	gl_Position = vec4(a_position, 0.0, 1.0);
+}
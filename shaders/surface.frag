@@ -4,67 +4,48 @@ precision highp float;
 
 layout (location=0) out vec4 FragColor;
 
-uniform vec3 u_camera;
+layout (std140) uniform FrameData
+{
+	mat4 u_view;
+	mat4 u_projection;
+	mat4 u_viewProjection;
+	vec4 u_camera;
+	float u_time;
+};
+
 uniform float u_roughness;
 uniform float u_metallic;
 
-uniform sampler2D u_skybox;
+// prefiltered on the cpu, mip n holds roughness n / ENVIRONMENT_MAX_LOD
+uniform samplerCube u_environment;
+
+// split sum scale and bias of f0, indexed by n dot v and roughness
+uniform sampler2D u_brdf;
 
 in float v_height;
 in vec3 v_normal;
 in vec3 v_position;
 
-#define PI 3.141592653589
-float myatan(float z, float x) {
-	float ang = atan(z, x);
-	if(ang < 0.f) {
-		ang = 2.f * PI + ang;
-	}
-
-	return ang;
-}
+// water reflects about 2% of the light at normal incidence
+const vec3 WATER_F0 = vec3(0.02f);
+const vec3 WATER_COLOR = vec3(0.34f, 0.7f, 1.f);
 
 void main() {
 	vec3 sunpos = normalize(vec3(0.f, 1.f, -1.f));
-	vec3 view = normalize(u_camera - v_position);
-	vec3 halfway = normalize(sunpos + view);
-
-	float f0 = 0.5f;
-	float fresnel = f0 + (1.f - f0) * pow((1.f - max(dot(view, v_normal), 0.f)), 5.f);
-
-	vec3 specular = vec3(0.8f) * pow(dot(halfway, v_normal), 1.f);
-	vec3 ambient = vec3(0.5f);
+	vec3 normal = normalize(v_normal);
+	vec3 view = normalize(u_camera.xyz - v_position);
+	float n_dot_v = max(dot(normal, view), 1e-4f);
 
-	//float fresnel = 
+	vec3 f0 = mix(WATER_F0, WATER_COLOR, u_metallic);
+	vec2 brdf = texture(u_brdf, vec2(n_dot_v, u_roughness)).rg;
+	vec3 reflectance = f0 * brdf.r + brdf.g;
 
-	vec3 sample_light = normalize(reflect(-view, v_normal));
-	float u = myatan(sample_light.z, sample_light.x) / (2 * PI);
-	float v = acos(sample_light.y) / PI;
-	vec4 texel = texture(u_skybox, vec2(u, v));
+	vec3 sample_light = reflect(-view, normal);
+	vec3 specular = textureLod(u_environment, sample_light, u_roughness * ENVIRONMENT_MAX_LOD).rgb * reflectance;
 
-	//vec3 col = (specular + ambient) * vec3(0.53f, 0.8f, 0.92f);
-	//vec3 color = fresnel * texel.rgb + (1.f - fresnel) * vec3(0.188f, 0.38f, 1.f);
-	//vec3 color = fresnel * texel.rgb + specular + ambient;
-	vec3 color = (specular + ambient) * vec3(0.34f, 0.7f, 1.f) + (texel.rgb * 0.2f);
+	// light scattered back out of the water body, whatever was not reflected
+	vec3 scatter = WATER_COLOR * (0.5f + 0.5f * max(dot(normal, sunpos), 0.f));
+	vec3 color = (1.f - reflectance) * (1.f - u_metallic) * scatter + specular;
 
-	//vec3 gamma_corrected = pow(color, vec3(1.0 / 2.2));
-	vec3 gamma_corrected = color;
-	FragColor = vec4(gamma_corrected, 1.0);
-	
-	//FragColor = vec4(clamp(v_normal, vec3(0.f), vec3(1.f)), 1.0);
+	FragColor = vec4(color, 1.0);
 }
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
@@ -0,0 +1,137 @@
+#include "framestats.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <sstream>
+#include <vector>
+
+FrameStats::FrameStats(std::size_t window)
+	: window{ std::max<std::size_t>(1, window) }
+{
+	for(Ring& ring : rings)
+	{
+		ring.samples.reset(new std::atomic<float>[this->window]);
+		for(std::size_t i=0;i<this->window;++i)
+			ring.samples[i].store(0.f, std::memory_order_relaxed);
+		ring.written = 0;
+	}
+}
+
+void FrameStats::record(FrameTiming timing, double milliseconds)
+{
+	record(static_cast<int>(timing), milliseconds);
+}
+
+void FrameStats::record(FrameCounter counter, double value)
+{
+	record(TIMINGS + static_cast<int>(counter), value);
+}
+
+void FrameStats::record(int metric, double value)
+{
+	Ring& ring = rings[metric];
+	uint64_t written = ring.written.load(std::memory_order_relaxed);
+	ring.samples[written % window].store(static_cast<float>(value), std::memory_order_relaxed);
+	ring.written.store(written + 1, std::memory_order_release);
+}
+
+FrameSummary FrameStats::summarize(FrameTiming timing) const
+{
+	return summarize(static_cast<int>(timing));
+}
+
+FrameSummary FrameStats::summarize(FrameCounter counter) const
+{
+	return summarize(TIMINGS + static_cast<int>(counter));
+}
+
+FrameSummary FrameStats::summarize(int metric) const
+{
+	const Ring& ring = rings[metric];
+	std::size_t count = static_cast<std::size_t>(std::min<uint64_t>(ring.written.load(std::memory_order_acquire), window));
+
+	FrameSummary summary{ count, 0.0, 0.0, 0.0, 0.0, 0.0 };
+	if(count == 0)
+		return summary;
+
+	// a sample may be replaced while it is copied, which only moves the window by one
+	std::vector<float> samples(count);
+	for(std::size_t i=0;i<count;++i)
+		samples[i] = ring.samples[i].load(std::memory_order_relaxed);
+	std::sort(samples.begin(), samples.end());
+
+	double total = 0.0;
+	for(float sample : samples)
+		total += sample;
+
+	// nearest rank
+	auto percentile = [&samples](double p) {
+		std::size_t rank = static_cast<std::size_t>(std::ceil(p * samples.size()));
+		return static_cast<double>(samples[std::min(samples.size(), std::max<std::size_t>(1, rank)) - 1]);
+	};
+
+	summary.mean = total / count;
+	summary.p50 = percentile(0.50);
+	summary.p95 = percentile(0.95);
+	summary.p99 = percentile(0.99);
+	summary.max = samples.back();
+	return summary;
+}
+
+void FrameStats::writeCsvHeader(std::ostream& os)
+{
+	os << "seconds,metric,count,mean,p50,p95,p99,max\n";
+}
+
+void FrameStats::writeCsv(std::ostream& os, double seconds) const
+{
+	// formatted apart and written at once, the stream may be shared with other threads
+	std::ostringstream rows;
+	rows << std::fixed << std::setprecision(3);
+	for(int i=0;i<METRICS;++i)
+	{
+		FrameSummary summary = summarize(i);
+		rows << seconds << "," << getName(i) << "," << summary.count << "," << summary.mean << ","
+			<< summary.p50 << "," << summary.p95 << "," << summary.p99 << "," << summary.max << "\n";
+	}
+	os << rows.str();
+}
+
+void FrameStats::writeJson(std::ostream& os) const
+{
+	std::ostringstream json;
+	json << std::fixed << std::setprecision(3) << "{\n";
+	for(int i=0;i<METRICS;++i)
+	{
+		FrameSummary summary = summarize(i);
+		json << "\t\"" << getName(i) << "\": { \"count\": " << summary.count << ", \"mean\": " << summary.mean
+			<< ", \"p50\": " << summary.p50 << ", \"p95\": " << summary.p95 << ", \"p99\": " << summary.p99
+			<< ", \"max\": " << summary.max << " }" << (i + 1 < METRICS ? ",\n" : "\n");
+	}
+	json << "}\n";
+	os << json.str();
+}
+
+const char* FrameStats::getName(FrameTiming timing)
+{
+	return getName(static_cast<int>(timing));
+}
+
+const char* FrameStats::getName(FrameCounter counter)
+{
+	return getName(TIMINGS + static_cast<int>(counter));
+}
+
+const char* FrameStats::getName(int metric)
+{
+	// timings carry their unit, counters are plain amounts
+	static const char* const names[METRICS] = {
+		"frame_ms", "update_ms", "render_ms", "swap_ms",
+		"draw_calls", "primitives", "vertices", "indices", "buffer_bytes", "texture_bytes",
+		"program_binds", "texture_binds", "uniform_uploads", "indexed_draws",
+		"resident_texture_bytes", "texture_evictions"
+	};
+
+	return metric >= 0 && metric < METRICS ? names[metric] : "unknown";
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <ostream>
+
+enum class FrameTiming
+{
+	// main loop iteration, what the old per frame fps print measured
+	FRAME,
+	// Scene::Update on the pool
+	UPDATE,
+	// drawing the scene and the renderer's batch on the render thread
+	RENDER,
+	// the buffer swap, where vsync waits
+	SWAP,
+	COUNT
+};
+
+// per frame amounts, summarized like the timings
+enum class FrameCounter
+{
+	DRAW_CALLS,
+	PRIMITIVES,
+	VERTICES,
+	INDICES,
+	BUFFER_BYTES,
+	TEXTURE_BYTES,
+	PROGRAM_BINDS,
+	TEXTURE_BINDS,
+	UNIFORM_UPLOADS,
+	INDEXED_DRAWS,
+	// gpu bytes the texture budget holds, pinned textures included
+	RESIDENT_TEXTURE_BYTES,
+	// textures the budget downsampled or evicted this frame
+	TEXTURE_EVICTIONS,
+	COUNT
+};
+
+struct FrameSummary
+{
+	// samples in the window, timings are in milliseconds
+	std::size_t count;
+	double mean;
+	double p50;
+	double p95;
+	double p99;
+	double max;
+};
+
+/*
+ * rolling frame timings. every timing keeps its last window samples in a ring that one thread
+ * writes without locking or allocating, so recording is safe on the hot path of any thread.
+ * summaries copy the ring and sort it, so they belong off the frame, like the writers below
+ */
+class FrameStats
+{
+	public:
+		FrameStats(std::size_t window = 600);
+
+		// one writer per timing or counter at a time
+		void record(FrameTiming timing, double milliseconds);
+		void record(FrameCounter counter, double value);
+
+		FrameSummary summarize(FrameTiming timing) const;
+		FrameSummary summarize(FrameCounter counter) const;
+
+		// one row per timing and counter, the header names the columns
+		static void writeCsvHeader(std::ostream& os);
+		void writeCsv(std::ostream& os, double seconds) const;
+		void writeJson(std::ostream& os) const;
+
+		static const char* getName(FrameTiming timing);
+		static const char* getName(FrameCounter counter);
+
+	private:
+		struct Ring
+		{
+			std::unique_ptr<std::atomic<float>[]> samples;
+			std::atomic<uint64_t> written;
+		};
+
+		static constexpr int TIMINGS = static_cast<int>(FrameTiming::COUNT);
+		static constexpr int METRICS = TIMINGS + static_cast<int>(FrameCounter::COUNT);
+
+		std::size_t window;
+		// the timings, then the counters
+		Ring rings[METRICS];
+
+		void record(int metric, double value);
+		FrameSummary summarize(int metric) const;
+		static const char* getName(int metric);
+};
@@ -0,0 +1,129 @@
+#include "inputqueue.hpp"
+
+#include <algorithm>
+#include <chrono>
+
+InputState::InputState()
+	: mouseX{ 0.0 }, mouseY{ 0.0 }
+{
+	keys.fill(false);
+	buttons.fill(false);
+}
+
+void InputState::apply(const InputEvent& event)
+{
+	switch(event.type)
+	{
+		case InputType::KEY_DOWN:
+		case InputType::KEY_UP:
+			// glfw reports keys it cannot map as -1
+			if(event.code >= 0 && event.code <= GLFW_KEY_LAST)
+				keys[event.code] = event.type == InputType::KEY_DOWN;
+			break;
+		case InputType::BUTTON_DOWN:
+		case InputType::BUTTON_UP:
+			if(event.code >= 0 && event.code <= GLFW_MOUSE_BUTTON_LAST)
+				buttons[event.code] = event.type == InputType::BUTTON_DOWN;
+			break;
+		case InputType::MOUSE_MOVE:
+			mouseX = event.x;
+			mouseY = event.y;
+			break;
+	}
+}
+
+double InputFrame::heldFor(int key) const
+{
+	double held = 0.0;
+	double downSince = start.keyDown(key) ? beginTime : -1.0;
+
+	for(const InputEvent& event : events)
+	{
+		if(event.code != key)
+			continue;
+
+		// an event stamped just before the previous collect still counts from the frame start
+		double time = std::clamp(event.time, beginTime, endTime);
+		if(event.type == InputType::KEY_DOWN && downSince < 0.0)
+			downSince = time;
+		else if(event.type == InputType::KEY_UP && downSince >= 0.0)
+		{
+			held += time - downSince;
+			downSince = -1.0;
+		}
+	}
+
+	if(downSince >= 0.0)
+		held += endTime - downSince;
+
+	return held;
+}
+
+bool InputFrame::pressed(int key) const
+{
+	for(const InputEvent& event : events)
+		if(event.type == InputType::KEY_DOWN && event.code == key)
+			return true;
+
+	return false;
+}
+
+InputQueue::InputQueue(std::size_t capacity)
+	: ring{ capacity }, lastCollect{ now() }
+{ }
+
+double InputQueue::now()
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void InputQueue::push(InputType type, int code, double x, double y)
+{
+	InputEvent event{ type, code, x, y, now() };
+
+	// the ring only takes events in order, so while a backlog exists new ones queue behind it
+	flush();
+	if(backlog.empty() && ring.tryPush(event))
+		return;
+
+	if(type == InputType::MOUSE_MOVE && !backlog.empty() && backlog.back().type == InputType::MOUSE_MOVE)
+		backlog.back() = event;
+	else
+		backlog.push_back(event);
+}
+
+void InputQueue::flush()
+{
+	std::size_t moved = 0;
+	while(moved < backlog.size() && ring.tryPush(backlog[moved]))
+		++moved;
+
+	backlog.erase(backlog.begin(), backlog.begin() + moved);
+}
+
+InputFrame InputQueue::collect()
+{
+	InputFrame frame;
+	frame.start = state;
+	frame.beginTime = lastCollect;
+
+	InputEvent event;
+	while(ring.tryPop(event))
+	{
+		if(event.type == InputType::MOUSE_MOVE && !frame.events.empty() &&
+				frame.events.back().type == InputType::MOUSE_MOVE)
+			frame.events.back() = event;
+		else
+			frame.events.push_back(event);
+
+		state.apply(event);
+	}
+
+	frame.end = state;
+	frame.endTime = now();
+	if(!frame.events.empty())
+		frame.endTime = std::max(frame.endTime, frame.events.back().time);
+	lastCollect = frame.endTime;
+
+	return frame;
+}
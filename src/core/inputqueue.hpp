@@ -0,0 +1,106 @@
+#pragma once
+
+#include <renderer/Renderer.hpp>
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include "spscqueue.hpp"
+
+enum class InputType : uint8_t
+{
+	KEY_DOWN,
+	KEY_UP,
+	BUTTON_DOWN,
+	BUTTON_UP,
+	MOUSE_MOVE
+};
+
+struct InputEvent
+{
+	InputType type;
+	// glfw key or mouse button, unused for moves
+	int code;
+	// cursor position, only set for moves
+	double x;
+	double y;
+	// seconds on InputQueue::now
+	double time;
+};
+
+// what is held and where the cursor is, rebuilt by applying events in order
+class InputState
+{
+	public:
+		InputState();
+
+		void apply(const InputEvent& event);
+
+		bool keyDown(int key) const { return key >= 0 && key <= GLFW_KEY_LAST && keys[key]; };
+		bool buttonDown(int button) const { return button >= 0 && button <= GLFW_MOUSE_BUTTON_LAST && buttons[button]; };
+
+		double mouseX;
+		double mouseY;
+
+	private:
+		std::array<bool, GLFW_KEY_LAST + 1> keys;
+		std::array<bool, GLFW_MOUSE_BUTTON_LAST + 1> buttons;
+};
+
+/*
+ * the input of one simulation step, everything that happened between two collects in order.
+ * runs of cursor moves with nothing else between them are merged into their last one, so
+ * presses and releases shorter than a frame survive while mouse noise stays small
+ */
+class InputFrame
+{
+	public:
+		// seconds the key was down inside the frame, for movement that follows the real hold time
+		double heldFor(int key) const;
+		// any press inside the frame, even one released again before it ended
+		bool pressed(int key) const;
+
+		const InputState& getStart() const { return start; };
+		const InputState& getEnd() const { return end; };
+		const std::vector<InputEvent>& getEvents() const { return events; };
+		double getDuration() const { return endTime - beginTime; };
+
+	private:
+		friend class InputQueue;
+
+		InputState start;
+		InputState end;
+		std::vector<InputEvent> events;
+		double beginTime;
+		double endTime;
+};
+
+/*
+ * carries input events from the glfw callbacks to whichever thread runs the simulation, over a
+ * lock-free ring. push and flush belong to the event thread, collect to one consumer at a time.
+ * what does not fit in the ring waits in a backlog on the event thread, so nothing is dropped
+ */
+class InputQueue
+{
+	public:
+		InputQueue(std::size_t capacity = 1024);
+
+		// event thread
+		void push(InputType type, int code, double x = 0.0, double y = 0.0);
+		// moves the backlog into the ring, call before the consumer collects
+		void flush();
+
+		// consumer thread, everything pushed since the previous collect
+		InputFrame collect();
+
+		static double now();
+
+	private:
+		SpscQueue<InputEvent> ring;
+		std::vector<InputEvent> backlog;
+
+		// consumer side
+		InputState state;
+		double lastCollect;
+};
@@ -0,0 +1,133 @@
+#include "renderthread.hpp"
+#include "trace.hpp"
+
+std::atomic<int> RenderThread::s_resizedWidth{ 0 };
+std::atomic<int> RenderThread::s_resizedHeight{ 0 };
+std::atomic<bool> RenderThread::s_resized{ false };
+
+RenderThread::RenderThread(std::size_t depth)
+	: queue{ depth > 0 ? depth : 1 }, context{ nullptr }, previousResize{ nullptr }, sleepers{ 0 },
+	stopping{ false }, failed{ false }
+{ }
+
+void RenderThread::start(Renderer::Window& window)
+{
+	context = window.getWindow();
+	stopping = false;
+
+	// glfw callbacks run on this thread during pollEvents, so resizes are forwarded instead
+	previousResize = glfwSetFramebufferSizeCallback(context, &RenderThread::framebufferResized);
+
+	// a context can only be current on one thread at a time
+	glfwMakeContextCurrent(nullptr);
+	thread = std::thread(&RenderThread::run, this);
+}
+
+void RenderThread::stop()
+{
+	if(!thread.joinable())
+		return;
+
+	stopping = true;
+	wakeSleepers();
+	thread.join();
+
+	glfwMakeContextCurrent(context);
+	glfwSetFramebufferSizeCallback(context, previousResize);
+
+	if(failed)
+		std::rethrow_exception(error);
+}
+
+void RenderThread::submit(std::function<void()> command)
+{
+	if(failed)
+		std::rethrow_exception(error);
+
+	while(!queue.tryPush(std::move(command)))
+		sleepUntil([this]() { return queue.size() < queue.getCapacity() || failed; });
+
+	wakeSleepers();
+}
+
+template<typename Predicate>
+void RenderThread::sleepUntil(Predicate predicate)
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	++sleepers;
+	changed.wait(lock, predicate);
+	--sleepers;
+}
+
+void RenderThread::wakeSleepers()
+{
+	// orders the queue update before reading sleepers, pairs with the increment in sleepUntil,
+	// so either the sleeper sees the update or this sees the sleeper
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	if(sleepers == 0)
+		return;
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+	}
+	changed.notify_all();
+}
+
+void RenderThread::run()
+{
+	Trace::nameThread("render");
+	glfwMakeContextCurrent(context);
+
+	for(;;)
+	{
+		std::function<void()> command;
+		if(!queue.tryPop(command))
+		{
+			// everything submitted before stop is visible once stopping is, so empty is final here
+			if(stopping && queue.empty())
+				break;
+
+			sleepUntil([this]() { return !queue.empty() || stopping; });
+			continue;
+		}
+
+		// the producer may be waiting for the slot this freed
+		wakeSleepers();
+
+		if(s_resized.exchange(false))
+			glViewport(0, 0, s_resizedWidth, s_resizedHeight);
+
+		if(failed)
+			continue;
+
+		try
+		{
+			command();
+		}
+		catch(...)
+		{
+			error = std::current_exception();
+			failed = true;
+			wakeSleepers();
+		}
+	}
+
+	glfwMakeContextCurrent(nullptr);
+}
+
+void RenderThread::framebufferResized(GLFWwindow* /*window*/, int width, int height)
+{
+	s_resizedWidth = width;
+	s_resizedHeight = height;
+	s_resized = true;
+}
+
+RenderThread::~RenderThread()
+{
+	try
+	{
+		stop();
+	}
+	catch(...)
+	{ }
+}
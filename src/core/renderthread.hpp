@@ -0,0 +1,63 @@
+#pragma once
+
+#include <renderer/Renderer.hpp>
+
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+#include "spscqueue.hpp"
+
+/*
+ * owns the window's gl context on a thread of its own and runs the commands the main thread
+ * queues, in order. the main thread keeps events and simulation, so a long driver call or a
+ * blocking swap no longer delays input. the depth is how many commands may wait in the queue,
+ * 1 keeps input latency lowest and more lets the main thread run further ahead
+ */
+class RenderThread
+{
+	public:
+		RenderThread(std::size_t depth);
+		~RenderThread();
+
+		// moves the context of the window from the calling thread to the render thread
+		void start(Renderer::Window& window);
+		// runs what is still queued and makes the context current on the calling thread again
+		void stop();
+
+		// waits while the queue is full, rethrows the first exception a command threw
+		void submit(std::function<void()> command);
+
+		std::size_t getDepth() const { return queue.getCapacity(); };
+
+	private:
+		SpscQueue<std::function<void()>> queue;
+		std::thread thread;
+		GLFWwindow* context;
+		GLFWframebuffersizefun previousResize;
+
+		// either side only sleeps here when the queue is full or empty
+		std::mutex mutex;
+		std::condition_variable changed;
+		std::atomic<int> sleepers;
+		std::atomic<bool> stopping;
+
+		// commands are skipped after the first one throws, submit hands the error to the main thread
+		std::exception_ptr error;
+		std::atomic<bool> failed;
+
+		template<typename Predicate>
+		void sleepUntil(Predicate predicate);
+		void wakeSleepers();
+
+		void run();
+
+		// the library resizes the viewport from the event thread, which no longer has the context
+		static std::atomic<int> s_resizedWidth;
+		static std::atomic<int> s_resizedHeight;
+		static std::atomic<bool> s_resized;
+		static void framebufferResized(GLFWwindow* window, int width, int height);
+};
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <utility>
+
+/*
+ * bounded queue between exactly one producer thread and one consumer thread. each side only
+ * writes its own index and reads the other's, so pushing and popping never lock. what to do
+ * when it is full or empty is left to the caller
+ */
+template<typename T>
+class SpscQueue
+{
+	public:
+		SpscQueue(std::size_t capacity)
+			: slots{ new T[capacity] }, capacity{ capacity }, head{ 0 }, tail{ 0 }
+		{ }
+
+		// producer only, false when full and the value is left untouched
+		bool tryPush(T&& value)
+		{
+			std::size_t t = tail.load(std::memory_order_relaxed);
+			if(t - head.load(std::memory_order_acquire) == capacity)
+				return false;
+
+			slots[t % capacity] = std::move(value);
+			tail.store(t + 1, std::memory_order_release);
+			return true;
+		}
+
+		bool tryPush(const T& value)
+		{
+			T copy = value;
+			return tryPush(std::move(copy));
+		}
+
+		// consumer only, false when empty
+		bool tryPop(T& value)
+		{
+			std::size_t h = head.load(std::memory_order_relaxed);
+			if(h == tail.load(std::memory_order_acquire))
+				return false;
+
+			// reset the slot so whatever the value holds is released now, not when it is overwritten
+			value = std::move(slots[h % capacity]);
+			slots[h % capacity] = T();
+			head.store(h + 1, std::memory_order_release);
+			return true;
+		}
+
+		// exact from either side only while the other one is idle
+		std::size_t size() const { return tail.load(std::memory_order_acquire) - head.load(std::memory_order_acquire); };
+		bool empty() const { return size() == 0; };
+		std::size_t getCapacity() const { return capacity; };
+
+	private:
+		std::unique_ptr<T[]> slots;
+		const std::size_t capacity;
+
+		// both only ever grow, on separate cache lines so the two threads do not false share
+		alignas(64) std::atomic<std::size_t> head;
+		alignas(64) std::atomic<std::size_t> tail;
+};
@@ -0,0 +1,62 @@
+#include "startup.hpp"
+
+#include <algorithm>
+#include <iomanip>
+
+Startup::Startup(ThreadPool& pool)
+	: pool{ pool }, begin{ std::chrono::steady_clock::now() }, timeToFirstFrame{ 0.0 }, finished{ false }
+{ }
+
+void Startup::firstFrame()
+{
+	if(finished)
+		return;
+
+	timeToFirstFrame = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+	finished = true;
+}
+
+void Startup::record(const char* name, std::chrono::steady_clock::time_point start, bool worker)
+{
+	auto end = std::chrono::steady_clock::now();
+	StartupStage stage{
+		name,
+		std::chrono::duration<double, std::milli>(start - begin).count(),
+		std::chrono::duration<double, std::milli>(end - start).count(),
+		worker
+	};
+
+	std::lock_guard<std::mutex> lock(mutex);
+	stages.push_back(stage);
+}
+
+void Startup::report(std::ostream& os) const
+{
+	std::vector<StartupStage> sorted;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		sorted = stages;
+	}
+	std::sort(sorted.begin(), sorted.end(),
+			[](const StartupStage& a, const StartupStage& b) { return a.start < b.start; });
+
+	// main thread stages nest, so only the worker time adds up
+	double worker_time = 0.0;
+
+	os << "startup (" << pool.getThreadCount() << " worker threads):\n" << std::fixed << std::setprecision(2);
+	for(const StartupStage& stage : sorted)
+	{
+		os << "  " << std::left << std::setw(20) << stage.name << std::right
+			<< std::setw(6) << (stage.worker ? "worker" : "main")
+			<< "  start " << std::setw(9) << stage.start << " ms"
+			<< "  took " << std::setw(9) << stage.duration << " ms\n";
+
+		if(stage.worker)
+			worker_time += stage.duration;
+	}
+
+	os << "  worker time " << worker_time << " ms\n";
+	if(finished)
+		os << "  time to first frame " << timeToFirstFrame << " ms\n";
+	os << std::defaultfloat;
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <chrono>
+#include <future>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "threadpool.hpp"
+
+struct StartupStage
+{
+	std::string name;
+
+	// milliseconds since the orchestrator was created
+	double start;
+	double duration;
+	bool worker;
+};
+
+/*
+ * runs independent startup work on the pool while the main thread brings up
+ * the window and context, and times every stage up to the first frame
+ */
+class Startup
+{
+	public:
+		Startup(ThreadPool& pool);
+
+		// cpu only work, runs on a worker thread
+		template<typename Task>
+		std::future<std::invoke_result_t<Task>> async(const char* name, Task&& task);
+
+		// gl bound work, runs on the calling thread
+		template<typename Task>
+		std::invoke_result_t<Task> run(const char* name, Task&& task);
+
+		// waits for a worker stage and records how long the main thread was blocked
+		template<typename Result>
+		Result wait(const char* name, std::future<Result>& result);
+
+		// call once the first frame is presented, later calls are ignored
+		void firstFrame();
+		bool isFinished() const { return finished; };
+
+		void report(std::ostream& os) const;
+
+		ThreadPool& getPool() { return pool; };
+
+	private:
+		ThreadPool& pool;
+		std::chrono::steady_clock::time_point begin;
+		double timeToFirstFrame;
+		bool finished;
+
+		mutable std::mutex mutex;
+		std::vector<StartupStage> stages;
+
+		void record(const char* name, std::chrono::steady_clock::time_point start, bool worker);
+
+		// records the stage when it goes out of scope, so throwing stages are timed too
+		struct StageTimer
+		{
+			Startup& startup;
+			const char* name;
+			bool worker;
+			std::chrono::steady_clock::time_point start;
+
+			~StageTimer() { startup.record(name, start, worker); };
+		};
+};
+
+template<typename Task>
+std::future<std::invoke_result_t<Task>> Startup::async(const char* name, Task&& task)
+{
+	return pool.submit([this, name, task = std::forward<Task>(task)]() mutable {
+		StageTimer timer{ *this, name, true, std::chrono::steady_clock::now() };
+		return task();
+	});
+}
+
+template<typename Task>
+std::invoke_result_t<Task> Startup::run(const char* name, Task&& task)
+{
+	StageTimer timer{ *this, name, false, std::chrono::steady_clock::now() };
+	return task();
+}
+
+template<typename Result>
+Result Startup::wait(const char* name, std::future<Result>& result)
+{
+	StageTimer timer{ *this, name, false, std::chrono::steady_clock::now() };
+	return result.get();
+}
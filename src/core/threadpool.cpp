@@ -0,0 +1,337 @@
+#include "threadpool.hpp"
+#include "trace.hpp"
+
+#include <algorithm>
+#include <iomanip>
+#include <string>
+
+namespace
+{
+	// the pool and deque of the calling thread, unset outside the workers
+	thread_local ThreadPool* currentPool = nullptr;
+	thread_local std::size_t currentWorker = 0;
+}
+
+ThreadPool::ThreadPool(unsigned int threadCount)
+	: queued{ 0 }, waiting{ 0 }, stopping{ false }, statsStart{ std::chrono::steady_clock::now() }
+{
+	// hardware_concurrency is 0 when it cannot be detected
+	if(threadCount == 0)
+	{
+		unsigned int hardware = std::thread::hardware_concurrency();
+		threadCount = hardware > 1 ? hardware - 1 : 1;
+	}
+
+	// every deque exists before the first worker can try to steal from it
+	for(unsigned int i=0;i<threadCount;++i)
+	{
+		workers.push_back(std::make_unique<Worker>());
+		workers.back()->busyNanoseconds = 0;
+		workers.back()->tasksRun = 0;
+		workers.back()->steals = 0;
+	}
+
+	for(unsigned int i=0;i<threadCount;++i)
+		workers[i]->thread = std::thread(&ThreadPool::run, this, i);
+}
+
+void ThreadPool::push(std::function<void()> task)
+{
+	if(currentPool == this)
+	{
+		std::lock_guard<std::mutex> lock(workers[currentWorker]->mutex);
+		workers[currentWorker]->tasks.push_back(std::move(task));
+	}
+	else
+	{
+		std::lock_guard<std::mutex> lock(injectedMutex);
+		injected.push_back(std::move(task));
+	}
+	++queued;
+
+	// a worker checks queued under the lock before it sleeps, so taking it here means
+	// the notify either lands after it is waiting or it already saw the new task
+	{
+		std::lock_guard<std::mutex> lock(sleepMutex);
+	}
+	wake.notify_one();
+}
+
+bool ThreadPool::take(std::size_t index, std::function<void()>& task)
+{
+	Worker& self = *workers[index];
+	{
+		std::lock_guard<std::mutex> lock(self.mutex);
+		if(!self.tasks.empty())
+		{
+			task = std::move(self.tasks.back());
+			self.tasks.pop_back();
+			--queued;
+			return true;
+		}
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(injectedMutex);
+		if(!injected.empty())
+		{
+			task = std::move(injected.front());
+			injected.pop_front();
+			--queued;
+			return true;
+		}
+	}
+
+	for(std::size_t i=1;i<workers.size();++i)
+	{
+		Worker& victim = *workers[(index + i) % workers.size()];
+		std::lock_guard<std::mutex> lock(victim.mutex);
+		if(!victim.tasks.empty())
+		{
+			task = std::move(victim.tasks.front());
+			victim.tasks.pop_front();
+			--queued;
+			++self.steals;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void ThreadPool::run(std::size_t index)
+{
+	currentPool = this;
+	currentWorker = index;
+	Trace::nameThread("worker " + std::to_string(index));
+	Worker& self = *workers[index];
+
+	for(;;)
+	{
+		std::function<void()> task;
+		if(take(index, task))
+		{
+			// only the outermost task is timed, tasks run while waiting are inside it
+			auto start = std::chrono::steady_clock::now();
+			task();
+			self.busyNanoseconds += std::chrono::duration_cast<std::chrono::nanoseconds>(
+					std::chrono::steady_clock::now() - start).count();
+			++self.tasksRun;
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(sleepMutex);
+		wake.wait(lock, [this]() { return stopping || queued > 0; });
+
+		// drain every deque before exiting so no future is left without a value
+		if(stopping && queued == 0)
+			return;
+	}
+}
+
+ThreadPool::JobHandle ThreadPool::schedule(std::function<void()> work, const std::vector<JobHandle>& dependencies)
+{
+	JobHandle job = std::make_shared<Job>();
+	job->work = std::move(work);
+	job->pending = 1;
+	job->done = false;
+
+	for(const JobHandle& dependency : dependencies)
+	{
+		std::lock_guard<std::mutex> lock(dependency->mutex);
+		if(!dependency->done)
+		{
+			++job->pending;
+			dependency->dependents.push_back(job);
+		}
+	}
+
+	// drop the count held while registering, the job may be queued right here
+	release(job);
+
+	return job;
+}
+
+void ThreadPool::release(const JobHandle& job)
+{
+	if(--job->pending == 0)
+		push([this, job]() { runJob(job); });
+}
+
+void ThreadPool::runJob(const JobHandle& job)
+{
+	try
+	{
+		job->work();
+	}
+	catch(...)
+	{
+		job->error = std::current_exception();
+	}
+	// free whatever the work captured now rather than when the last handle goes
+	job->work = nullptr;
+
+	std::vector<JobHandle> dependents;
+	{
+		std::lock_guard<std::mutex> lock(job->mutex);
+		job->done = true;
+		dependents.swap(job->dependents);
+	}
+	job->finished.notify_all();
+
+	// workers waiting on a job sleep with the idle ones, done is stored before waiting is read
+	// and waiting raised before done is checked, so one side always sees the other
+	if(waiting > 0)
+	{
+		{
+			std::lock_guard<std::mutex> lock(sleepMutex);
+		}
+		wake.notify_all();
+	}
+
+	for(const JobHandle& dependent : dependents)
+		release(dependent);
+}
+
+void ThreadPool::wait(const JobHandle& job)
+{
+	if(currentPool == this)
+	{
+		// blocking here could starve the job of the one worker that would run it, so run other
+		// tasks meanwhile and only sleep while there are none, until a task arrives or the job ends
+		while(!job->isDone())
+		{
+			std::function<void()> task;
+			if(take(currentWorker, task))
+			{
+				task();
+				++workers[currentWorker]->tasksRun;
+				continue;
+			}
+
+			++waiting;
+			{
+				std::unique_lock<std::mutex> lock(sleepMutex);
+				wake.wait(lock, [this, &job]() { return job->isDone() || queued > 0; });
+			}
+			--waiting;
+		}
+	}
+	else
+	{
+		std::unique_lock<std::mutex> lock(job->mutex);
+		job->finished.wait(lock, [&job]() { return job->isDone(); });
+	}
+
+	if(job->error)
+		std::rethrow_exception(job->error);
+}
+
+void ThreadPool::parallelFor(std::size_t count, const std::function<void(std::size_t)>& body)
+{
+	parallelFor(count, 1, [&body](std::size_t begin, std::size_t end) {
+		for(std::size_t i=begin;i<end;++i)
+			body(i);
+	});
+}
+
+void ThreadPool::parallelFor(std::size_t count, std::size_t grain, const std::function<void(std::size_t, std::size_t)>& body)
+{
+	if(count == 0)
+		return;
+
+	// four chunks per thread leaves room to balance uneven chunks
+	if(grain == 0)
+		grain = std::max<std::size_t>(1, count / ((workers.size() + 1) * 4));
+
+	auto state = std::make_shared<ParallelFor>();
+	state->count = count;
+	state->grain = grain;
+	state->body = &body;
+	state->next = 0;
+	state->done = 0;
+
+	// helpers go to the caller's own deque when it is a worker, idle workers steal them from there.
+	// helpers that start after the work ran out return straight away
+	std::size_t chunks = (count + grain - 1) / grain;
+	std::size_t helpers = std::min<std::size_t>(workers.size(), chunks - 1);
+	for(std::size_t i=0;i<helpers;++i)
+		push([state]() { runParallelFor(*state); });
+
+	runParallelFor(*state);
+
+	// every chunk left is already running on some thread, so blocking cannot deadlock
+	std::unique_lock<std::mutex> lock(state->mutex);
+	state->finished.wait(lock, [&state]() { return state->done == state->count; });
+
+	if(state->error)
+		std::rethrow_exception(state->error);
+}
+
+void ThreadPool::runParallelFor(ParallelFor& state)
+{
+	for(;;)
+	{
+		std::size_t begin = state.next.fetch_add(state.grain);
+		if(begin >= state.count)
+			return;
+		std::size_t end = std::min(begin + state.grain, state.count);
+
+		try
+		{
+			(*state.body)(begin, end);
+		}
+		catch(...)
+		{
+			std::lock_guard<std::mutex> lock(state.mutex);
+			if(!state.error)
+				state.error = std::current_exception();
+		}
+
+		if((state.done += end - begin) == state.count)
+		{
+			std::lock_guard<std::mutex> lock(state.mutex);
+			state.finished.notify_all();
+		}
+	}
+}
+
+std::vector<WorkerStats> ThreadPool::collectStats()
+{
+	auto now = std::chrono::steady_clock::now();
+	double wall = std::chrono::duration<double, std::nano>(now - statsStart).count();
+	statsStart = now;
+
+	std::vector<WorkerStats> stats;
+	for(const std::unique_ptr<Worker>& worker : workers)
+	{
+		double busy = static_cast<double>(worker->busyNanoseconds.exchange(0));
+		stats.push_back({
+			wall > 0.0 ? std::min(1.0, busy / wall) : 0.0,
+			worker->tasksRun.exchange(0),
+			worker->steals.exchange(0)
+		});
+	}
+
+	return stats;
+}
+
+void ThreadPool::report(std::ostream& os)
+{
+	std::vector<WorkerStats> stats = collectStats();
+	for(std::size_t i=0;i<stats.size();++i)
+		os << "worker " << i << ": " << std::fixed << std::setprecision(1) << stats[i].utilisation * 100.0
+			<< "% busy, " << stats[i].tasks << " tasks, " << stats[i].steals << " stolen\n";
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(sleepMutex);
+		stopping = true;
+	}
+	wake.notify_all();
+
+	for(std::unique_ptr<Worker>& worker : workers)
+		worker->thread.join();
+}
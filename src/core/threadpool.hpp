@@ -0,0 +1,149 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+struct WorkerStats
+{
+	// fraction of the wall time spent running tasks, a task counts when it finishes
+	double utilisation;
+	uint64_t tasks;
+	// tasks taken from another worker's deque
+	uint64_t steals;
+};
+
+/*
+ * a fixed set of worker threads, each with its own deque of tasks. a worker runs the newest
+ * task of its own deque first and steals the oldest task of another deque when it runs dry,
+ * so work spawned from a task stays on the core that spawned it until someone is idle.
+ * threads outside the pool hand tasks in through a shared queue.
+ * tasks must not touch the gl context
+ */
+class ThreadPool
+{
+	public:
+		class Job;
+		typedef std::shared_ptr<Job> JobHandle;
+
+		// 0 leaves one hardware thread for the main thread
+		ThreadPool(unsigned int threadCount = 0);
+		~ThreadPool();
+
+		template<typename Task>
+		std::future<std::invoke_result_t<Task>> submit(Task&& task);
+
+		// runs work once every dependency has finished, a dependency that threw still counts as finished
+		JobHandle schedule(std::function<void()> work, const std::vector<JobHandle>& dependencies = {});
+
+		// rethrows what the job threw. a worker runs other tasks while it waits, any other thread blocks
+		void wait(const JobHandle& job);
+
+		// runs body(i) for every i below count on the workers and the calling thread.
+		// the caller never waits on queued tasks, so this is safe to call from a task
+		void parallelFor(std::size_t count, const std::function<void(std::size_t)>& body);
+
+		// runs body(begin, end) over chunks of at most grain indices, 0 gives every thread a few chunks
+		void parallelFor(std::size_t count, std::size_t grain, const std::function<void(std::size_t, std::size_t)>& body);
+
+		unsigned int getThreadCount() const { return static_cast<unsigned int>(workers.size()); };
+
+		// per worker figures since the previous call
+		std::vector<WorkerStats> collectStats();
+		void report(std::ostream& os);
+
+		class Job
+		{
+			public:
+				bool isDone() const { return done; };
+
+			private:
+				friend class ThreadPool;
+
+				std::function<void()> work;
+				// unfinished dependencies, plus one until schedule has registered them all
+				std::atomic<int> pending;
+
+				std::mutex mutex;
+				std::condition_variable finished;
+				std::atomic<bool> done;
+				std::vector<JobHandle> dependents;
+				std::exception_ptr error;
+		};
+
+	private:
+		struct Worker
+		{
+			std::thread thread;
+
+			std::mutex mutex;
+			std::deque<std::function<void()>> tasks;
+
+			std::atomic<uint64_t> busyNanoseconds;
+			std::atomic<uint64_t> tasksRun;
+			std::atomic<uint64_t> steals;
+		};
+
+		std::vector<std::unique_ptr<Worker>> workers;
+
+		// tasks from threads outside the pool
+		std::deque<std::function<void()>> injected;
+		std::mutex injectedMutex;
+
+		// tasks sitting in any deque, idle workers sleep while it is 0
+		std::atomic<std::size_t> queued;
+		// workers inside wait, finishing a job only wakes the sleepers when there are some
+		std::atomic<int> waiting;
+		std::mutex sleepMutex;
+		std::condition_variable wake;
+		bool stopping;
+
+		std::chrono::steady_clock::time_point statsStart;
+
+		struct ParallelFor
+		{
+			std::size_t count;
+			std::size_t grain;
+			const std::function<void(std::size_t, std::size_t)>* body;
+
+			std::atomic<std::size_t> next;
+			std::atomic<std::size_t> done;
+			std::mutex mutex;
+			std::condition_variable finished;
+			std::exception_ptr error;
+		};
+
+		void push(std::function<void()> task);
+		bool take(std::size_t index, std::function<void()>& task);
+		void run(std::size_t index);
+
+		void release(const JobHandle& job);
+		void runJob(const JobHandle& job);
+
+		static void runParallelFor(ParallelFor& state);
+};
+
+template<typename Task>
+std::future<std::invoke_result_t<Task>> ThreadPool::submit(Task&& task)
+{
+	using Result = std::invoke_result_t<Task>;
+
+	// std::function has to be copyable, the packaged task is not
+	auto packaged = std::make_shared<std::packaged_task<Result()>>(std::forward<Task>(task));
+	std::future<Result> result = packaged->get_future();
+
+	push([packaged]() { (*packaged)(); });
+
+	return result;
+}
@@ -0,0 +1,168 @@
+#include "trace.hpp"
+
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+// events a track holds per capture, later ones are counted as dropped
+static constexpr std::size_t TRACK_EVENTS = 16384;
+// frames after a capture before it is written, so queued frames and gpu timings can land
+static constexpr unsigned int SETTLE_FRAMES = 8;
+
+std::atomic<bool> Trace::s_capturing{ false };
+std::atomic<bool> Trace::s_busy{ false };
+std::atomic<uint64_t> Trace::s_generation{ 0 };
+unsigned int Trace::s_framesLeft = 0;
+unsigned int Trace::s_settleFrames = 0;
+
+std::mutex Trace::s_mutex;
+std::vector<std::unique_ptr<Trace::Track>> Trace::s_tracks;
+
+const std::chrono::steady_clock::time_point Trace::s_epoch = std::chrono::steady_clock::now();
+
+static thread_local Trace::Track* t_track = nullptr;
+
+void Trace::nameThread(const std::string& name)
+{
+	// the writer reads names at any time, so a thread keeps the track it first got
+	if(!t_track)
+		t_track = createTrack(name);
+}
+
+Trace::Track* Trace::createTrack(const std::string& name)
+{
+	std::unique_ptr<Track> track(new Track);
+	track->events.reset(new Event[TRACK_EVENTS]);
+	track->count = 0;
+	track->generation = 0;
+	track->dropped = 0;
+
+	std::lock_guard<std::mutex> lock(s_mutex);
+	track->id = static_cast<int>(s_tracks.size());
+	track->name = name.empty() ? "thread " + std::to_string(track->id) : name;
+	s_tracks.push_back(std::move(track));
+	return s_tracks.back().get();
+}
+
+Trace::Track& Trace::threadTrack()
+{
+	// threads nobody named get a track the first time they record
+	if(!t_track)
+		t_track = createTrack("");
+
+	return *t_track;
+}
+
+bool Trace::requestCapture(unsigned int frames)
+{
+	if(frames == 0 || s_busy.exchange(true))
+		return false;
+
+	s_framesLeft = frames;
+	return true;
+}
+
+bool Trace::frame()
+{
+	if(s_capturing.load(std::memory_order_relaxed))
+	{
+		if(--s_framesLeft == 0)
+		{
+			s_capturing.store(false, std::memory_order_release);
+			s_settleFrames = SETTLE_FRAMES;
+		}
+		return false;
+	}
+
+	if(s_settleFrames > 0)
+		return --s_settleFrames == 0;
+
+	if(s_framesLeft > 0)
+	{
+		// zones read the generation after they see the capture start
+		s_generation.fetch_add(1, std::memory_order_relaxed);
+		s_capturing.store(true, std::memory_order_release);
+	}
+
+	return false;
+}
+
+void Trace::record(Track& track, const char* name, double start, double duration, uint64_t generation)
+{
+	uint64_t current = track.generation.load(std::memory_order_relaxed);
+
+	// a zone left over from an earlier capture
+	if(generation < current)
+		return;
+
+	// the first event of a capture starts the track over, only its own thread ever resets it
+	if(generation > current)
+	{
+		track.count.store(0, std::memory_order_relaxed);
+		track.dropped.store(0, std::memory_order_relaxed);
+		track.generation.store(generation, std::memory_order_release);
+	}
+
+	std::size_t count = track.count.load(std::memory_order_relaxed);
+	if(count == TRACK_EVENTS)
+	{
+		track.dropped.fetch_add(1, std::memory_order_relaxed);
+		return;
+	}
+
+	track.events[count] = { name, start, duration };
+	track.count.store(count + 1, std::memory_order_release);
+}
+
+void Trace::write(const std::string& path)
+{
+	std::ofstream file(path);
+	write(file);
+
+	std::cout << "trace written to " << path << "\n";
+}
+
+void Trace::write(std::ostream& os)
+{
+	uint64_t generation = getGeneration();
+
+	std::vector<Track*> tracks;
+	{
+		std::lock_guard<std::mutex> lock(s_mutex);
+		for(const std::unique_ptr<Track>& track : s_tracks)
+			tracks.push_back(track.get());
+	}
+
+	os << std::fixed << std::setprecision(3) << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+	os << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"WaterRender\"}}";
+
+	uint64_t dropped = 0;
+	for(Track* track : tracks)
+	{
+		os << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << track->id
+			<< ",\"args\":{\"name\":\"" << track->name << "\"}}";
+		os << ",\n{\"name\":\"thread_sort_index\",\"ph\":\"M\",\"pid\":1,\"tid\":" << track->id
+			<< ",\"args\":{\"sort_index\":" << track->id << "}}";
+
+		if(track->generation.load(std::memory_order_acquire) != generation)
+			continue;
+
+		std::size_t count = track->count.load(std::memory_order_acquire);
+		for(std::size_t i=0;i<count;++i)
+		{
+			const Event& event = track->events[i];
+			os << ",\n{\"name\":\"" << event.name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << track->id
+				<< ",\"ts\":" << event.start << ",\"dur\":" << event.duration << "}";
+		}
+		dropped += track->dropped.load(std::memory_order_relaxed);
+	}
+
+	os << "\n],\"otherData\":{\"dropped\":" << dropped << "}}\n";
+
+	s_busy = false;
+}
+
+double Trace::now()
+{
+	return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - s_epoch).count();
+}
@@ -0,0 +1,121 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// 0 compiles the zone macros away, the tracer itself stays for code that records directly
+#ifndef TRACE_ENABLED
+#define TRACE_ENABLED 1
+#endif
+
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+
+#if TRACE_ENABLED
+// times the rest of the enclosing scope while a capture runs, name has to outlive the capture
+#define TRACE_SCOPE(name) Trace::Zone TRACE_CONCAT(trace_zone_, __LINE__){ name }
+#else
+#define TRACE_SCOPE(name) do { } while(false)
+#endif
+
+/*
+ * records named cpu zones into one track per thread for a capture of a few frames, and writes
+ * them as chrome trace events for perfetto or chrome://tracing. a thread appends to its own
+ * track without locking, outside a capture a zone costs one atomic load.
+ * the main thread drives captures through requestCapture and frame
+ */
+class Trace
+{
+	public:
+		struct Event
+		{
+			const char* name;
+			// microseconds since the program started
+			double start;
+			double duration;
+		};
+
+		// written by a single thread, read by the writer once the capture is over
+		struct Track
+		{
+			std::string name;
+			int id;
+
+			std::unique_ptr<Event[]> events;
+			std::atomic<std::size_t> count;
+			std::atomic<uint64_t> generation;
+			std::atomic<uint64_t> dropped;
+		};
+
+		class Zone
+		{
+			public:
+				Zone(const char* name);
+				~Zone();
+
+				Zone(const Zone&) = delete;
+				Zone& operator=(const Zone&) = delete;
+
+			private:
+				const char* name;
+				double start;
+				// 0 when the zone began outside a capture
+				uint64_t generation;
+		};
+
+		// names the calling thread's track, call before the thread records anything
+		static void nameThread(const std::string& name);
+		// a track that is not a thread, such as gpu timings, only one thread may record to it
+		static Track* createTrack(const std::string& name);
+
+		// starts a capture of frames frames with the next frame, ignored while one is in progress
+		static bool requestCapture(unsigned int frames);
+		// call once per frame on the main thread, true once a capture is ready to be written
+		static bool frame();
+		// writes the finished capture and allows the next one, off the frame
+		static void write(const std::string& path);
+		static void write(std::ostream& os);
+
+		static bool isCapturing() { return s_capturing.load(std::memory_order_acquire); };
+		static uint64_t getGeneration() { return s_generation.load(std::memory_order_relaxed); };
+
+		static void record(Track& track, const char* name, double start, double duration, uint64_t generation);
+
+		static double now();
+
+	private:
+		static std::atomic<bool> s_capturing;
+		static std::atomic<bool> s_busy;
+		static std::atomic<uint64_t> s_generation;
+		static unsigned int s_framesLeft;
+		static unsigned int s_settleFrames;
+
+		static std::mutex s_mutex;
+		static std::vector<std::unique_ptr<Track>> s_tracks;
+
+		static const std::chrono::steady_clock::time_point s_epoch;
+
+		static Track& threadTrack();
+};
+
+inline Trace::Zone::Zone(const char* name)
+	: name{ name }, start{ 0.0 }, generation{ 0 }
+{
+	if(isCapturing())
+	{
+		generation = getGeneration();
+		start = now();
+	}
+}
+
+inline Trace::Zone::~Zone()
+{
+	if(generation)
+		record(threadTrack(), name, start, now() - start, generation);
+}
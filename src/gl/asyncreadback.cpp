@@ -0,0 +1,218 @@
+#include "asyncreadback.hpp"
+
+#include <algorithm>
+
+AsyncReadback::AsyncReadback(unsigned int ringSize)
+	: slots(std::max(1u, ringSize)), head{ 0 }, count{ 0 }, frame{ 0 }, dropped{ 0 }, failed{ 0 }
+{
+	for(Slot& slot : slots)
+	{
+		slot.buffer = 0;
+		slot.capacity = 0;
+		slot.fence = nullptr;
+	}
+}
+
+void AsyncReadback::Init()
+{
+	for(Slot& slot : slots)
+		glGenBuffers(1, &slot.buffer);
+}
+
+bool AsyncReadback::readFramebuffer(GLint x, GLint y, GLsizei width, GLsizei height, Callback callback,
+		GLenum format, GLenum type)
+{
+	std::size_t size = static_cast<std::size_t>(width) * height * pixelSize(format, type);
+	Slot* slot = acquire(size);
+	if(!slot)
+		return false;
+
+	// with a pack buffer bound the read only queues a copy on the gpu
+	glReadPixels(x, y, width, height, format, type, nullptr);
+
+	slot->callback = std::move(callback);
+	slot->width = width;
+	slot->height = height;
+	slot->format = format;
+	slot->type = type;
+	slot->size = size;
+	submit(*slot);
+	return true;
+}
+
+bool AsyncReadback::readTexture(GLuint texture, GLint level, Callback callback, GLenum format, GLenum type)
+{
+	GLint width, height;
+	glBindTexture(GL_TEXTURE_2D, texture);
+	glGetTexLevelParameteriv(GL_TEXTURE_2D, level, GL_TEXTURE_WIDTH, &width);
+	glGetTexLevelParameteriv(GL_TEXTURE_2D, level, GL_TEXTURE_HEIGHT, &height);
+
+	std::size_t size = static_cast<std::size_t>(width) * height * pixelSize(format, type);
+	Slot* slot = acquire(size);
+	if(!slot)
+		return false;
+
+	glGetTexImage(GL_TEXTURE_2D, level, format, type, nullptr);
+
+	slot->callback = std::move(callback);
+	slot->width = width;
+	slot->height = height;
+	slot->format = format;
+	slot->type = type;
+	slot->size = size;
+	submit(*slot);
+	return true;
+}
+
+void AsyncReadback::update()
+{
+	while(count > 0)
+	{
+		Slot& slot = slots[head];
+
+		// a zero timeout only polls, the flush makes sure the fence reaches the gpu at all
+		GLenum status = glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+		if(status == GL_TIMEOUT_EXPIRED)
+			break;
+
+		glDeleteSync(slot.fence);
+		slot.fence = nullptr;
+
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+		const void* data = status == GL_WAIT_FAILED ? nullptr :
+			glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, slot.size, GL_MAP_READ_BIT);
+
+		Callback callback = std::move(slot.callback);
+		slot.callback = nullptr;
+		head = (head + 1) % slots.size();
+		--count;
+
+		// a read the driver could not finish is counted like a dropped one, the frame goes on
+		if(!data)
+		{
+			glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+			++failed;
+			continue;
+		}
+
+		ReadbackResult result{ slot.width, slot.height, slot.format, slot.type,
+			static_cast<const unsigned char*>(data), slot.size, static_cast<unsigned int>(frame - slot.frame) };
+		callback(result);
+
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+		glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	}
+
+	++frame;
+}
+
+std::size_t AsyncReadback::pixelSize(GLenum format, GLenum type)
+{
+	std::size_t size = findPixelSize(format, type);
+	if(size == 0)
+		throw Renderer::TextureOperationRejected("Unsupported readback format or type!");
+	return size;
+}
+
+std::size_t AsyncReadback::findPixelSize(GLenum format, GLenum type)
+{
+	switch(type)
+	{
+		// packed types hold the whole pixel
+		case GL_UNSIGNED_INT_24_8:
+		case GL_UNSIGNED_INT_2_10_10_10_REV:
+		case GL_UNSIGNED_INT_10F_11F_11F_REV:
+		case GL_UNSIGNED_INT_5_9_9_9_REV:
+		case GL_UNSIGNED_INT_8_8_8_8:
+		case GL_UNSIGNED_INT_8_8_8_8_REV:
+			return 4;
+		case GL_UNSIGNED_SHORT_5_6_5: case GL_UNSIGNED_SHORT_5_6_5_REV:
+		case GL_UNSIGNED_SHORT_4_4_4_4: case GL_UNSIGNED_SHORT_4_4_4_4_REV:
+		case GL_UNSIGNED_SHORT_5_5_5_1: case GL_UNSIGNED_SHORT_1_5_5_5_REV:
+			return 2;
+		case GL_UNSIGNED_BYTE_3_3_2: case GL_UNSIGNED_BYTE_2_3_3_REV:
+			return 1;
+		case GL_FLOAT_32_UNSIGNED_INT_24_8_REV:
+			return 8;
+		default:
+			break;
+	}
+
+	std::size_t components;
+	switch(format)
+	{
+		case GL_RED: case GL_GREEN: case GL_BLUE: case GL_RED_INTEGER:
+		case GL_DEPTH_COMPONENT: case GL_STENCIL_INDEX:
+			components = 1;
+			break;
+		case GL_RG: case GL_RG_INTEGER:
+			components = 2;
+			break;
+		case GL_RGB: case GL_BGR: case GL_RGB_INTEGER:
+			components = 3;
+			break;
+		case GL_RGBA: case GL_BGRA: case GL_RGBA_INTEGER:
+			components = 4;
+			break;
+		default:
+			return 0;
+	}
+
+	switch(type)
+	{
+		case GL_UNSIGNED_BYTE: case GL_BYTE:
+			return components;
+		case GL_UNSIGNED_SHORT: case GL_SHORT: case GL_HALF_FLOAT:
+			return components * 2;
+		case GL_UNSIGNED_INT: case GL_INT: case GL_FLOAT:
+			return components * 4;
+		default:
+			return 0;
+	}
+}
+
+AsyncReadback::Slot* AsyncReadback::acquire(std::size_t size)
+{
+	// never wait for the gpu to free a slot, that would be the stall this is here to avoid
+	if(count == slots.size())
+	{
+		++dropped;
+		return nullptr;
+	}
+
+	Slot& slot = slots[(head + count) % slots.size()];
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+	if(slot.capacity < size)
+	{
+		glBufferData(GL_PIXEL_PACK_BUFFER, size, nullptr, GL_STREAM_READ);
+		slot.capacity = size;
+	}
+
+	// rows tightly packed whatever their width
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	return &slot;
+}
+
+void AsyncReadback::submit(Slot& slot)
+{
+	glPixelStorei(GL_PACK_ALIGNMENT, 4);
+
+	// other reads go to client memory, never leave the pbo bound
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+	slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	slot.frame = frame;
+	++count;
+}
+
+AsyncReadback::~AsyncReadback()
+{
+	for(Slot& slot : slots)
+	{
+		if(slot.fence)
+			glDeleteSync(slot.fence);
+		if(slot.buffer)
+			glDeleteBuffers(1, &slot.buffer);
+	}
+}
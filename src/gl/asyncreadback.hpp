@@ -0,0 +1,90 @@
+#pragma once
+
+#include <renderer/Renderer.hpp>
+
+#include <functional>
+#include <vector>
+
+struct ReadbackResult
+{
+	unsigned int width;
+	unsigned int height;
+	GLenum format;
+	GLenum type;
+
+	// tightly packed rows from the bottom, only valid during the callback
+	const unsigned char* data;
+	std::size_t size;
+
+	// frames between the read and its delivery
+	unsigned int latency;
+};
+
+/*
+ * reads framebuffers and textures back without stalling. every read goes into a pixel
+ * buffer from a small ring with a fence behind it, update hands it to the callback once
+ * the gpu is done with it, usually a frame or two later. reads past a full ring are dropped
+ */
+class AsyncReadback
+{
+	public:
+		typedef std::function<void(const ReadbackResult&)> Callback;
+
+		AsyncReadback(unsigned int ringSize = 4);
+		~AsyncReadback();
+
+		AsyncReadback(const AsyncReadback&) = delete;
+		AsyncReadback& operator=(const AsyncReadback&) = delete;
+
+		void Init();
+
+		// a rectangle of the bound read framebuffer
+		bool readFramebuffer(GLint x, GLint y, GLsizei width, GLsizei height, Callback callback,
+				GLenum format = GL_RGBA, GLenum type = GL_UNSIGNED_BYTE);
+
+		// a whole level of a 2d texture
+		bool readTexture(GLuint texture, GLint level, Callback callback,
+				GLenum format = GL_RGBA, GLenum type = GL_UNSIGNED_BYTE);
+
+		// call once per frame, delivers finished reads in the order they were made
+		void update();
+
+		unsigned int getPending() const { return count; };
+		uint64_t getDropped() const { return dropped; };
+		// reads whose fence wait or mapping failed, their callbacks are never called
+		uint64_t getFailed() const { return failed; };
+
+		// bytes of one pixel, packed types count once
+		static std::size_t pixelSize(GLenum format, GLenum type);
+		// the same without throwing, 0 for a format or type it does not know
+		static std::size_t findPixelSize(GLenum format, GLenum type);
+
+	private:
+		struct Slot
+		{
+			GLuint buffer;
+			std::size_t capacity;
+			GLsync fence;
+			Callback callback;
+
+			unsigned int width;
+			unsigned int height;
+			GLenum format;
+			GLenum type;
+			std::size_t size;
+			uint64_t frame;
+		};
+
+		// a queue over the ring, head is the oldest read in flight
+		std::vector<Slot> slots;
+		unsigned int head;
+		unsigned int count;
+
+		uint64_t frame;
+		uint64_t dropped;
+		uint64_t failed;
+
+		// the next free slot with room for size bytes, bound as the pack buffer
+		Slot* acquire(std::size_t size);
+		void submit(Slot& slot);
+};
@@ -0,0 +1,200 @@
+#include "asynctexture.hpp"
+
+#include <algorithm>
+
+AsyncTexture::AsyncTexture(std::size_t uploadBudget, TextureFormat format, const char* cacheDirectory)
+	: decoded{ false }, failed{ false }, format{ format }, cache{ cacheDirectory }, texture{ 0 }, placeholder{ 0 },
+	pbos{ 0, 0 }, nextPbo{ 0 }, uploadLevel{ -1 }, uploadRow{ 0 }, ready{ false }, uploadBudget{ uploadBudget }
+{ }
+
+void AsyncTexture::Init()
+{
+	// a single sky coloured texel until the real image arrives
+	const unsigned char placeholder_pixel[4] = { 135, 204, 235, 255 };
+	glGenTextures(1, &placeholder);
+	glBindTexture(GL_TEXTURE_2D, placeholder);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, placeholder_pixel);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+	glGenBuffers(2, pbos);
+}
+
+void AsyncTexture::load(const char* imagePath)
+{
+	if(decoding.valid() || ready)
+		throw Renderer::TextureOperationRejected("AsyncTexture::load is meant to only be called once!");
+
+	path = imagePath;
+	decoding = std::async(std::launch::async, &AsyncTexture::decode, this);
+}
+
+void AsyncTexture::load(const char* imagePath, Startup& startup)
+{
+	if(decoding.valid() || ready)
+		throw Renderer::TextureOperationRejected("AsyncTexture::load is meant to only be called once!");
+
+	path = imagePath;
+	decoding = startup.async("texture decode", [this]() { decode(); });
+}
+
+void AsyncTexture::update()
+{
+	if(ready || !decoded)
+		return;
+
+	if(decoding.valid())
+		decoding.get();
+
+	if(failed)
+		throw Renderer::FileNotFoundException("Unable to load texture: " + path);
+
+	if(!texture)
+		allocate();
+
+	std::size_t budget = uploadBudget;
+	while(budget > 0 && uploadLevel >= 0)
+		budget -= std::min(budget, uploadSlice(budget));
+
+	if(uploadLevel >= 0)
+		return;
+
+	// every level is on the gpu, release the mapping or the decoded copy
+	levels.release();
+	ready = true;
+}
+
+void AsyncTexture::bind(unsigned int slot)
+{
+	glActiveTexture(GL_TEXTURE0 + slot);
+	glBindTexture(GL_TEXTURE_2D, ready ? texture : placeholder);
+	glActiveTexture(GL_TEXTURE0);
+}
+
+void AsyncTexture::decode()
+{
+	// the flags are polled by update, so failures are reported through them too
+	try
+	{
+		levels.load(cache, path, format);
+	}
+	catch(const std::exception&)
+	{
+		failed = true;
+	}
+
+	decoded = true;
+}
+
+void AsyncTexture::allocate()
+{
+	glGenTextures(1, &texture);
+	glBindTexture(GL_TEXTURE_2D, texture);
+
+	// formats the context cannot sample are decoded a slice at a time into rgba8
+	bool supported = textureFormatSupported(format);
+	bool compressed = isCompressedFormat(format) && supported;
+	GLenum internal_format = supported ? textureInternalFormat(format) : GL_RGBA8;
+	GLenum client_format, type;
+	textureClientFormat(format, client_format, type);
+	for(unsigned int i=0;i<levels.getLevels();++i)
+	{
+		unsigned int level_width = levels.getLevelWidth(i);
+		unsigned int level_height = levels.getLevelHeight(i);
+		if(compressed)
+			glCompressedTexImage2D(GL_TEXTURE_2D, i, internal_format, level_width, level_height, 0,
+					static_cast<GLsizei>(textureLevelSize(format, level_width, level_height)), nullptr);
+		else
+			glTexImage2D(GL_TEXTURE_2D, i, internal_format, level_width, level_height, 0, client_format, type, nullptr);
+	}
+
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, static_cast<GLint>(levels.getLevels() - 1));
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+	uploadLevel = static_cast<int>(levels.getLevels()) - 1;
+	uploadRow = 0;
+}
+
+std::size_t AsyncTexture::uploadSlice(std::size_t budget)
+{
+	unsigned int level_width = levels.getLevelWidth(uploadLevel);
+	unsigned int level_height = levels.getLevelHeight(uploadLevel);
+
+	// block formats move 4 pixel rows at a time
+	unsigned int row_height = textureRowHeight(format);
+	std::size_t row_bytes = textureLevelSize(format, level_width, row_height);
+
+	// at least one row so a tiny budget still makes progress
+	unsigned int rows = static_cast<unsigned int>(std::max<std::size_t>(1, budget / row_bytes));
+	unsigned int remaining = (level_height - uploadRow + row_height - 1) / row_height;
+	rows = std::min(rows, remaining);
+	unsigned int pixel_rows = std::min(rows * row_height, level_height - uploadRow);
+
+	const unsigned char* source = levels.getLevel(uploadLevel) + (uploadRow / row_height) * row_bytes;
+	std::size_t bytes = rows * row_bytes;
+
+	bool compressed = isCompressedFormat(format);
+	bool decode_slice = compressed && !textureFormatSupported(format);
+	std::vector<unsigned char> decoded_slice;
+	if(decode_slice)
+	{
+		decoded_slice = decodeTexture(format, source, level_width, pixel_rows);
+		source = decoded_slice.data();
+		bytes = decoded_slice.size();
+	}
+
+	// alternate the buffers and orphan them so the copy never waits on the previous upload
+	GLuint pbo = pbos[nextPbo];
+	nextPbo = (nextPbo + 1) % 2;
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pbo);
+	glBufferData(GL_PIXEL_UNPACK_BUFFER, bytes, nullptr, GL_STREAM_DRAW);
+
+	void* mapped_buffer = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, bytes, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+	if(mapped_buffer)
+	{
+		memcpy(mapped_buffer, source, bytes);
+		glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+
+		glBindTexture(GL_TEXTURE_2D, texture);
+		if(compressed && !decode_slice)
+			glCompressedTexSubImage2D(GL_TEXTURE_2D, uploadLevel, 0, uploadRow, level_width, pixel_rows,
+					textureInternalFormat(format), static_cast<GLsizei>(bytes), nullptr);
+		else
+		{
+			GLenum client_format, type;
+			textureClientFormat(format, client_format, type);
+			glTexSubImage2D(GL_TEXTURE_2D, uploadLevel, 0, uploadRow, level_width, pixel_rows, client_format, type, nullptr);
+		}
+	}
+
+	// other uploads read from client memory, never leave the pbo bound
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+	if(!mapped_buffer)
+		throw Renderer::TextureOperationRejected("Unable to map the texture upload buffer!");
+
+	uploadRow += pixel_rows;
+	if(uploadRow >= level_height)
+	{
+		--uploadLevel;
+		uploadRow = 0;
+	}
+
+	return bytes;
+}
+
+AsyncTexture::~AsyncTexture()
+{
+	if(decoding.valid())
+		decoding.wait();
+
+	if(texture)
+		glDeleteTextures(1, &texture);
+	if(placeholder)
+		glDeleteTextures(1, &placeholder);
+	if(pbos[0])
+		glDeleteBuffers(2, pbos);
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <renderer/Renderer.hpp>
+
+#include <atomic>
+#include <future>
+#include <string>
+#include <vector>
+
+#include "../core/startup.hpp"
+#include "texturelevels.hpp"
+
+/*
+ * decodes an image on a worker thread and streams it to the gpu through pixel buffer
+ * objects a slice at a time, a placeholder stays bound until every level is uploaded.
+ * decoded levels go to the texture cache, later loads stream straight from the mapped entry.
+ * the float formats decode through stbi_loadf and keep the range of hdr images
+ */
+class AsyncTexture
+{
+	public:
+		AsyncTexture(std::size_t uploadBudget = 1 << 20, TextureFormat format = TextureFormat::RGBA8,
+				const char* cacheDirectory = "./cache/textures");
+		~AsyncTexture();
+
+		void Init();
+
+		// decoding needs no context, so it can start before Init
+		void load(const char* path);
+		void load(const char* path, Startup& startup);
+
+		// call once per frame on the thread that owns the context
+		void update();
+
+		void bind(unsigned int slot = 0);
+
+		bool isReady() const { return ready; };
+		GLuint getId() const { return ready ? texture : placeholder; };
+		unsigned int getWidth() const { return levels.getWidth(); };
+		unsigned int getHeight() const { return levels.getHeight(); };
+
+	private:
+		std::string path;
+		std::future<void> decoding;
+		std::atomic<bool> decoded;
+		std::atomic<bool> failed;
+
+		TextureFormat format;
+		TextureCache cache;
+
+		// released once every level is uploaded
+		TextureLevels levels;
+
+		GLuint texture;
+		GLuint placeholder;
+		GLuint pbos[2];
+		unsigned int nextPbo;
+
+		// upload progress, levels go from the smallest to level 0
+		int uploadLevel;
+		unsigned int uploadRow;
+		bool ready;
+
+		// bytes copied through the pbos per frame
+		std::size_t uploadBudget;
+
+		void decode();
+		void allocate();
+		std::size_t uploadSlice(std::size_t budget);
+};
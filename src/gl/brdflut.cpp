@@ -0,0 +1,208 @@
+#include "brdflut.hpp"
+#include "../utils.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+
+namespace
+{
+	// header written before the table in every cache file
+	struct BrdfCacheHeader
+	{
+		char magic[4];
+		uint32_t version;
+		uint32_t size;
+		uint32_t sampleCount;
+	};
+
+	const char CACHE_MAGIC[4] = { 'W', 'B', 'R', 'D' };
+	const uint32_t CACHE_VERSION = 1;
+
+	// schlick-ggx with the k used for image based lighting
+	float geometrySmith(float nDotV, float nDotL, float roughness)
+	{
+		float k = roughness * roughness / 2.f;
+		float view = nDotV / (nDotV * (1.f - k) + k);
+		float light = nDotL / (nDotL * (1.f - k) + k);
+		return view * light;
+	}
+}
+
+BrdfLut::BrdfLut(unsigned int size, unsigned int sampleCount, const char* cacheDirectory)
+	: cacheDirectory{ cacheDirectory }, size{ std::max(2u, size) }, sampleCount{ std::max(1u, sampleCount) },
+	texture{ 0 }, placeholder{ 0 }, ready{ false }
+{ }
+
+void BrdfLut::Init()
+{
+	// reflect exactly f0 until the table is ready
+	const float placeholder_texel[2] = { 1.f, 0.f };
+	glGenTextures(1, &placeholder);
+	glBindTexture(GL_TEXTURE_2D, placeholder);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RG16F, 1, 1, 0, GL_RG, GL_FLOAT, placeholder_texel);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+}
+
+void BrdfLut::generate(Startup& startup)
+{
+	if(generating.valid() || ready)
+		throw Renderer::TextureOperationRejected("BrdfLut::generate is meant to only be called once!");
+
+	ThreadPool& pool = startup.getPool();
+	generating = startup.async("brdf lut", [this, &pool]() { prepare(pool); });
+}
+
+void BrdfLut::update()
+{
+	if(ready || !generating.valid() || generating.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+		return;
+
+	generating.get();
+
+	glGenTextures(1, &texture);
+	glBindTexture(GL_TEXTURE_2D, texture);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RG16F, size, size, 0, GL_RG, GL_FLOAT, table.data());
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+	std::vector<float>().swap(table);
+	ready = true;
+}
+
+void BrdfLut::bind(unsigned int slot)
+{
+	glActiveTexture(GL_TEXTURE0 + slot);
+	glBindTexture(GL_TEXTURE_2D, ready ? texture : placeholder);
+	glActiveTexture(GL_TEXTURE0);
+}
+
+std::vector<float> BrdfLut::integrate(unsigned int size, unsigned int sampleCount, ThreadPool& pool)
+{
+	std::vector<float> result(static_cast<std::size_t>(size) * size * 2);
+
+	pool.parallelFor(size, [&](std::size_t row) {
+		// texel centres, so n dot v never reaches 0 and the lookup matches gl's filtering
+		float roughness = (row + 0.5f) / size;
+		float alpha = roughness * roughness;
+
+		for(unsigned int col=0;col<size;++col)
+		{
+			float n_dot_v = (col + 0.5f) / size;
+			float vx = std::sqrt(1.f - n_dot_v * n_dot_v);
+			float vz = n_dot_v;
+
+			float scale = 0.f;
+			float bias = 0.f;
+			for(unsigned int i=0;i<sampleCount;++i)
+			{
+				float hx, hy, hz;
+				sampleGgx((i + 0.5f) / sampleCount, radicalInverse(i), alpha, hx, hy, hz);
+
+				float v_dot_h = vx * hx + vz * hz;
+				float n_dot_l = 2.f * v_dot_h * hz - vz;
+				if(n_dot_l <= 0.f)
+					continue;
+
+				// the pdf cancels against the brdf up to these terms
+				float visibility = geometrySmith(n_dot_v, n_dot_l, roughness) * v_dot_h / (hz * n_dot_v);
+				float fresnel = std::pow(1.f - std::max(v_dot_h, 0.f), 5.f);
+				scale += (1.f - fresnel) * visibility;
+				bias += fresnel * visibility;
+			}
+
+			float* out = result.data() + (row * size + col) * 2;
+			out[0] = scale / sampleCount;
+			out[1] = bias / sampleCount;
+		}
+	});
+
+	return result;
+}
+
+void BrdfLut::prepare(ThreadPool& pool)
+{
+	std::string cache_file = cachePath();
+	if(readCache(cache_file))
+		return;
+
+	table = integrate(size, sampleCount, pool);
+	writeCache(cache_file);
+}
+
+std::string BrdfLut::cachePath() const
+{
+	uint32_t params[3] = { size, sampleCount, CACHE_VERSION };
+	uint64_t key = hashBytes(params, sizeof(params));
+
+	char filename[32];
+	std::snprintf(filename, sizeof(filename), "%016llx.lut", static_cast<unsigned long long>(key));
+	return cacheDirectory + "/" + filename;
+}
+
+bool BrdfLut::readCache(const std::string& cacheFile)
+{
+	std::ifstream file(cacheFile, std::ios::binary);
+	if(!file.is_open())
+		return false;
+
+	BrdfCacheHeader header;
+	if(!file.read(reinterpret_cast<char*>(&header), sizeof(header)))
+		return false;
+
+	if(memcmp(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) != 0 || header.version != CACHE_VERSION ||
+			header.size != size || header.sampleCount != sampleCount)
+		return false;
+
+	std::vector<float> result(static_cast<std::size_t>(size) * size * 2);
+	if(!file.read(reinterpret_cast<char*>(result.data()), result.size() * sizeof(float)))
+		return false;
+
+	table = std::move(result);
+	return true;
+}
+
+void BrdfLut::writeCache(const std::string& cacheFile) const
+{
+	std::error_code err;
+	std::filesystem::create_directories(cacheDirectory, err);
+	if(err)
+		return;
+
+	BrdfCacheHeader header;
+	memcpy(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+	header.version = CACHE_VERSION;
+	header.size = size;
+	header.sampleCount = sampleCount;
+
+	// write to a temporary and rename so a crash never leaves a torn entry
+	std::string temp_path = cacheFile + ".tmp";
+	{
+		std::ofstream file(temp_path, std::ios::binary | std::ios::trunc);
+		if(!file.is_open())
+			return;
+
+		file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		file.write(reinterpret_cast<const char*>(table.data()), table.size() * sizeof(float));
+		if(!file)
+			return;
+	}
+
+	std::filesystem::rename(temp_path, cacheFile, err);
+}
+
+BrdfLut::~BrdfLut()
+{
+	if(generating.valid())
+		generating.wait();
+
+	if(texture)
+		glDeleteTextures(1, &texture);
+	if(placeholder)
+		glDeleteTextures(1, &placeholder);
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <renderer/Renderer.hpp>
+
+#include <future>
+#include <string>
+#include <vector>
+
+#include "../core/startup.hpp"
+
+/*
+ * the split sum lookup table, x is n dot v and y is roughness. red scales and
+ * green biases f0, so the specular reflectance is f0 * lut.r + lut.g
+ */
+class BrdfLut
+{
+	public:
+		BrdfLut(unsigned int size = 128, unsigned int sampleCount = 256, const char* cacheDirectory = "./cache/brdf");
+		~BrdfLut();
+
+		void Init();
+
+		// reads the cache or integrates on the pool, needs no context
+		void generate(Startup& startup);
+
+		// call once per frame on the thread that owns the context
+		void update();
+
+		void bind(unsigned int slot = 1);
+
+		bool isReady() const { return ready; };
+
+		// gpu bytes of the table once uploaded, two half floats a texel
+		std::size_t getMemorySize() const { return ready ? static_cast<std::size_t>(size) * size * 4 : 0; };
+
+		// rg pairs, rows go from roughness 0 to 1
+		static std::vector<float> integrate(unsigned int size, unsigned int sampleCount, ThreadPool& pool);
+
+	private:
+		std::string cacheDirectory;
+		unsigned int size;
+		unsigned int sampleCount;
+
+		std::future<void> generating;
+		std::vector<float> table;
+
+		GLuint texture;
+		GLuint placeholder;
+		bool ready;
+
+		void prepare(ThreadPool& pool);
+		std::string cachePath() const;
+		bool readCache(const std::string& path);
+		void writeCache(const std::string& path) const;
+};
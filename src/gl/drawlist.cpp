@@ -0,0 +1,451 @@
+#include "drawlist.hpp"
+
+DrawList::DrawList()
+	: vao{ 0 }, vbo{ 0 }, ibo{ 0 }, lastRangeMergeable{ false }, vertexCount{ 0 }, indexCount{ 0 },
+	shapeType{ Renderer::DrawType::NONE }, shapeVertexCount{ 0 }, shapeIndexCount{ 0 }, shapeStart{ 0 }
+{ }
+
+void DrawList::beginShape(Renderer::DrawType type, unsigned int vertexCount, unsigned int indicesCount)
+{
+	if(shapeType != Renderer::DrawType::NONE)
+		throw Renderer::RenderingException("beginShape called before the previous shape ended!");
+	if(type == Renderer::DrawType::NONE)
+		throw Renderer::RenderingException("Cannot record a shape with DrawType::NONE!");
+	if(layout.getStride() == 0)
+		throw Renderer::RenderingException("Draw list has no vertex layout!");
+
+	shapeType = type;
+	shapeVertexCount = vertexCount;
+	shapeIndexCount = indicesCount;
+	shapeStart = vertices.size();
+}
+
+void DrawList::vertex1f(float v)
+{
+	writeConverted(&v, 1, false, &v);
+}
+
+void DrawList::vertex2f(float v0, float v1)
+{
+	float data[] = { v0, v1 };
+	writeConverted(data, 2, false, data);
+}
+
+void DrawList::vertex3f(float v0, float v1, float v2)
+{
+	float data[] = { v0, v1, v2 };
+	writeConverted(data, 3, false, data);
+}
+
+void DrawList::vertex4f(float v0, float v1, float v2, float v3)
+{
+	float data[] = { v0, v1, v2, v3 };
+	writeConverted(data, 4, false, data);
+}
+
+void DrawList::vertex1i(int v)
+{
+	float data[] = { static_cast<float>(v) };
+	writeConverted(data, 1, true, &v);
+}
+
+void DrawList::vertex2i(int v0, int v1)
+{
+	int raw[] = { v0, v1 };
+	float data[] = { static_cast<float>(v0), static_cast<float>(v1) };
+	writeConverted(data, 2, true, raw);
+}
+
+void DrawList::vertex3i(int v0, int v1, int v2)
+{
+	int raw[] = { v0, v1, v2 };
+	float data[] = { static_cast<float>(v0), static_cast<float>(v1), static_cast<float>(v2) };
+	writeConverted(data, 3, true, raw);
+}
+
+void DrawList::vertex4i(int v0, int v1, int v2, int v3)
+{
+	int raw[] = { v0, v1, v2, v3 };
+	float data[] = { static_cast<float>(v0), static_cast<float>(v1), static_cast<float>(v2), static_cast<float>(v3) };
+	writeConverted(data, 4, true, raw);
+}
+
+void DrawList::vertex2h(float v0, float v1)
+{
+	float data[] = { v0, v1 };
+	writeFormat(VertexFormat::HALF2, data, 2);
+}
+
+void DrawList::vertex3h(float v0, float v1, float v2)
+{
+	float data[] = { v0, v1, v2 };
+	writeFormat(VertexFormat::HALF3, data, 3);
+}
+
+void DrawList::vertex4h(float v0, float v1, float v2, float v3)
+{
+	float data[] = { v0, v1, v2, v3 };
+	writeFormat(VertexFormat::HALF4, data, 4);
+}
+
+void DrawList::vertex4b(int8_t v0, int8_t v1, int8_t v2, int8_t v3)
+{
+	int8_t data[] = { v0, v1, v2, v3 };
+	writeRaw(VertexFormat::BYTE4, data);
+}
+
+void DrawList::vertex4ub(uint8_t v0, uint8_t v1, uint8_t v2, uint8_t v3)
+{
+	uint8_t data[] = { v0, v1, v2, v3 };
+	writeRaw(VertexFormat::UBYTE4, data);
+}
+
+void DrawList::vertex4bn(float v0, float v1, float v2, float v3)
+{
+	float data[] = { v0, v1, v2, v3 };
+	writeFormat(VertexFormat::BYTE4_NORM, data, 4);
+}
+
+void DrawList::vertex4ubn(float v0, float v1, float v2, float v3)
+{
+	float data[] = { v0, v1, v2, v3 };
+	writeFormat(VertexFormat::UBYTE4_NORM, data, 4);
+}
+
+void DrawList::vertex2s(int16_t v0, int16_t v1)
+{
+	int16_t data[] = { v0, v1 };
+	writeRaw(VertexFormat::SHORT2, data);
+}
+
+void DrawList::vertex3s(int16_t v0, int16_t v1, int16_t v2)
+{
+	// padded to 8 bytes to keep the next attribute aligned
+	int16_t data[] = { v0, v1, v2, 0 };
+	writeRaw(VertexFormat::SHORT3, data);
+}
+
+void DrawList::vertex4s(int16_t v0, int16_t v1, int16_t v2, int16_t v3)
+{
+	int16_t data[] = { v0, v1, v2, v3 };
+	writeRaw(VertexFormat::SHORT4, data);
+}
+
+void DrawList::vertex2us(uint16_t v0, uint16_t v1)
+{
+	uint16_t data[] = { v0, v1 };
+	writeRaw(VertexFormat::USHORT2, data);
+}
+
+void DrawList::vertex4us(uint16_t v0, uint16_t v1, uint16_t v2, uint16_t v3)
+{
+	uint16_t data[] = { v0, v1, v2, v3 };
+	writeRaw(VertexFormat::USHORT4, data);
+}
+
+void DrawList::vertex2sn(float v0, float v1)
+{
+	float data[] = { v0, v1 };
+	writeFormat(VertexFormat::SHORT2_NORM, data, 2);
+}
+
+void DrawList::vertex3sn(float v0, float v1, float v2)
+{
+	float data[] = { v0, v1, v2 };
+	writeFormat(VertexFormat::SHORT3_NORM, data, 3);
+}
+
+void DrawList::vertex4sn(float v0, float v1, float v2, float v3)
+{
+	float data[] = { v0, v1, v2, v3 };
+	writeFormat(VertexFormat::SHORT4_NORM, data, 4);
+}
+
+void DrawList::vertex2usn(float v0, float v1)
+{
+	float data[] = { v0, v1 };
+	writeFormat(VertexFormat::USHORT2_NORM, data, 2);
+}
+
+void DrawList::vertex4usn(float v0, float v1, float v2, float v3)
+{
+	float data[] = { v0, v1, v2, v3 };
+	writeFormat(VertexFormat::USHORT4_NORM, data, 4);
+}
+
+void DrawList::vertex4p(float x, float y, float z, float w)
+{
+	float data[] = { x, y, z, w };
+	writeFormat(VertexFormat::INT_2_10_10_10_NORM, data, 4);
+}
+
+void DrawList::vertex4up(float x, float y, float z, float w)
+{
+	float data[] = { x, y, z, w };
+	writeFormat(VertexFormat::UINT_2_10_10_10_NORM, data, 4);
+}
+
+void DrawList::endShape(const unsigned int* shapeIndices)
+{
+	if(shapeType == Renderer::DrawType::NONE)
+		throw Renderer::RenderingException("endShape called without beginShape!");
+
+	std::size_t written = vertices.size() - shapeStart;
+	if(written != static_cast<std::size_t>(shapeVertexCount) * layout.getStride())
+		throw Renderer::RenderingException("Shape vertex data does not match its vertex count!");
+
+	if(shapeVertexCount > MAX_RANGE_VERTICES)
+		throw Renderer::RenderingException("Shape has too many vertices for 16 bit indices!");
+
+	GLenum mode = getMode(shapeType);
+	bool mergeable = isListMode(shapeType);
+
+	// list primitives keep extending the last range while its indices fit in 16 bits
+	bool extend = mergeable && lastRangeMergeable && !ranges.empty() && ranges.back().mode == mode &&
+		vertexCount + shapeVertexCount - ranges.back().baseVertex <= MAX_RANGE_VERTICES;
+	if(!extend)
+		ranges.push_back({ mode, indexCount, 0, static_cast<GLint>(vertexCount) });
+	lastRangeMergeable = mergeable;
+
+	DrawRange& range = ranges.back();
+	unsigned int first_vertex = vertexCount - range.baseVertex;
+
+	if(shapeIndices)
+	{
+		for(unsigned int i=0;i<shapeIndexCount;++i)
+		{
+			if(shapeIndices[i] >= shapeVertexCount)
+				throw Renderer::RenderingException("Shape index out of range!");
+
+			indices.push_back(static_cast<uint16_t>(first_vertex + shapeIndices[i]));
+		}
+	}
+	else if(shapeType == Renderer::DrawType::TRIANGLE)
+	{
+		// polygons are split into a fan, same as the immediate renderer
+		for(unsigned int i=1;i+1<shapeVertexCount;++i)
+		{
+			indices.push_back(static_cast<uint16_t>(first_vertex));
+			indices.push_back(static_cast<uint16_t>(first_vertex + i));
+			indices.push_back(static_cast<uint16_t>(first_vertex + i + 1));
+		}
+	}
+	else
+	{
+		for(unsigned int i=0;i<shapeVertexCount;++i)
+			indices.push_back(static_cast<uint16_t>(first_vertex + i));
+	}
+
+	vertexCount += shapeVertexCount;
+	range.indexCount += static_cast<unsigned int>(indices.size()) - indexCount;
+	indexCount = static_cast<unsigned int>(indices.size());
+
+	shapeType = Renderer::DrawType::NONE;
+}
+
+void DrawList::endShape()
+{
+	endShape(nullptr);
+}
+
+void DrawList::compile()
+{
+	if(shapeType != Renderer::DrawType::NONE)
+		throw Renderer::RenderingException("Cannot compile a draw list in the middle of a shape!");
+
+	releaseBuffers();
+
+	// keep the vertex array of the bound shader intact
+	GLint previous_vao = 0;
+	glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &previous_vao);
+
+	glGenVertexArrays(1, &vao);
+	glBindVertexArray(vao);
+
+	glGenBuffers(1, &vbo);
+	glBindBuffer(GL_ARRAY_BUFFER, vbo);
+	glBufferData(GL_ARRAY_BUFFER, vertices.size(), vertices.data(), GL_STATIC_DRAW);
+
+	glGenBuffers(1, &ibo);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(uint16_t), indices.data(), GL_STATIC_DRAW);
+
+	for(const VertexAttrib& attrib : layout.getAttribs())
+	{
+		glEnableVertexAttribArray(attrib.location);
+		const void* offset = reinterpret_cast<const void*>(static_cast<uintptr_t>(attrib.offset));
+		if(attrib.integer)
+			glVertexAttribIPointer(attrib.location, attrib.components, attrib.type, layout.getStride(), offset);
+		else
+			glVertexAttribPointer(attrib.location, attrib.components, attrib.type,
+					attrib.normalized ? GL_TRUE : GL_FALSE, layout.getStride(), offset);
+	}
+
+	glBindVertexArray(previous_vao);
+
+	// gather runs of ranges with the same primitive type into one multi draw each, a change of type
+	// starts the next one so shapes are drawn in the order they were recorded
+	batches.clear();
+	for(const DrawRange& range : ranges)
+	{
+		if(batches.empty() || batches.back().mode != range.mode)
+			batches.push_back({ range.mode, {}, {}, {} });
+
+		MultiDrawBatch& batch = batches.back();
+		batch.counts.push_back(static_cast<GLsizei>(range.indexCount));
+		batch.offsets.push_back(reinterpret_cast<const void*>(
+					static_cast<uintptr_t>(range.firstIndex) * sizeof(uint16_t)));
+		batch.baseVertices.push_back(range.baseVertex);
+	}
+
+	// the gpu owns the geometry now
+	std::vector<unsigned char>().swap(vertices);
+	std::vector<uint16_t>().swap(indices);
+}
+
+void DrawList::clear()
+{
+	releaseBuffers();
+	vertices.clear();
+	indices.clear();
+	ranges.clear();
+	batches.clear();
+	lastRangeMergeable = false;
+	vertexCount = 0;
+	indexCount = 0;
+	shapeType = Renderer::DrawType::NONE;
+}
+
+void DrawList::draw(Renderer::Render& renderer, Renderer::Shader& shader)
+{
+	if(!vao)
+		throw Renderer::RenderingException("Draw list has to be compiled before drawing!");
+
+	// flushes whatever the immediate renderer batched for another shader
+	renderer.bindShader(&shader);
+
+	// the shader only rebinds its vertex array when switching shaders, so restore it after
+	GLuint shader_vao = getShaderVertexArray(shader);
+
+	glBindVertexArray(vao);
+	for(const MultiDrawBatch& batch : batches)
+		glMultiDrawElementsBaseVertex(batch.mode, batch.counts.data(), GL_UNSIGNED_SHORT, batch.offsets.data(),
+				static_cast<GLsizei>(batch.counts.size()), batch.baseVertices.data());
+
+	glBindVertexArray(shader_vao);
+}
+
+GLuint DrawList::getShaderVertexArray(const Renderer::Shader& shader)
+{
+	for(const std::pair<const Renderer::Shader*, GLuint>& known : shaderVertexArrays)
+		if(known.first == &shader)
+			return known.second;
+
+	// the shader was just bound and every draw restores its array, so the binding is the shader's.
+	// a shader creates its array once, so this is read on the first draw with it and never again
+	GLint shader_vao = 0;
+	glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &shader_vao);
+	shaderVertexArrays.push_back({ &shader, static_cast<GLuint>(shader_vao) });
+	return static_cast<GLuint>(shader_vao);
+}
+
+void DrawList::write(const void* data, std::size_t bytes)
+{
+	if(shapeType == Renderer::DrawType::NONE)
+		throw Renderer::RenderingException("Vertex data written outside of beginShape / endShape!");
+
+	const unsigned char* bytes_ptr = static_cast<const unsigned char*>(data);
+	vertices.insert(vertices.end(), bytes_ptr, bytes_ptr + bytes);
+}
+
+void DrawList::writeConverted(const float* values, int count, bool integer, const void* raw)
+{
+	unsigned int offset = static_cast<unsigned int>((vertices.size() - shapeStart) % layout.getStride());
+	const VertexAttrib* attrib = layout.find(offset);
+
+	// plain 32 bit attributes, or data that does not line up with one, are copied as is
+	bool plain = !attrib || (integer ? attrib->type == GL_INT : attrib->type == GL_FLOAT);
+	if(plain)
+	{
+		write(raw, count * 4);
+		return;
+	}
+
+	unsigned char packed[16];
+	packVertexAttrib(*attrib, values, count, packed);
+	write(packed, attrib->bytes);
+}
+
+void DrawList::writeFormat(VertexFormat format, const float* values, int count)
+{
+	VertexAttrib attrib = describeVertexFormat(format);
+	checkAttrib(attrib, true);
+
+	unsigned char packed[16];
+	packVertexAttrib(attrib, values, count, packed);
+	write(packed, attrib.bytes);
+}
+
+void DrawList::writeRaw(VertexFormat format, const void* data)
+{
+	// the values are already in storage format, so signed, unsigned and normalized use the same writer
+	VertexAttrib attrib = describeVertexFormat(format);
+	checkAttrib(attrib, false);
+
+	write(data, attrib.bytes);
+}
+
+void DrawList::checkAttrib(const VertexAttrib& written, bool exact)
+{
+	unsigned int offset = static_cast<unsigned int>((vertices.size() - shapeStart) % layout.getStride());
+	const VertexAttrib* attrib = layout.find(offset);
+
+	if(!attrib)
+		throw Renderer::RenderingException("Vertex data written where the layout has no attribute!");
+
+	bool matches = exact ? attrib->format == written.format :
+		attrib->type == written.type && attrib->components == written.components;
+	if(!matches)
+		throw Renderer::RenderingException("Vertex data does not match the format of the attribute it is written to!");
+}
+
+void DrawList::releaseBuffers()
+{
+	if(vao)
+		glDeleteVertexArrays(1, &vao);
+	if(vbo)
+		glDeleteBuffers(1, &vbo);
+	if(ibo)
+		glDeleteBuffers(1, &ibo);
+
+	vao = 0;
+	vbo = 0;
+	ibo = 0;
+}
+
+GLenum DrawList::getMode(Renderer::DrawType type)
+{
+	switch(type)
+	{
+		case Renderer::DrawType::POINTS: return GL_POINTS;
+		case Renderer::DrawType::TRIANGLE: return GL_TRIANGLES;
+		case Renderer::DrawType::TRIANGLE_STRIP: return GL_TRIANGLE_STRIP;
+		case Renderer::DrawType::TRIANGLE_FAN: return GL_TRIANGLE_FAN;
+		case Renderer::DrawType::LINE: return GL_LINES;
+		case Renderer::DrawType::LINE_STRIP: return GL_LINE_STRIP;
+		case Renderer::DrawType::LINE_LOOP: return GL_LINE_LOOP;
+		default:
+			throw Renderer::InvalidType("Unknown draw type!");
+	}
+}
+
+bool DrawList::isListMode(Renderer::DrawType type)
+{
+	return type == Renderer::DrawType::POINTS || type == Renderer::DrawType::TRIANGLE ||
+		type == Renderer::DrawType::LINE;
+}
+
+DrawList::~DrawList()
+{
+	releaseBuffers();
+}
@@ -0,0 +1,129 @@
+#pragma once
+
+#include <renderer/Renderer.hpp>
+
+#include <utility>
+#include <vector>
+
+#include "vertexformat.hpp"
+
+// a run of 16 bit indices relative to its own base vertex
+struct DrawRange
+{
+	GLenum mode;
+	unsigned int firstIndex;
+	unsigned int indexCount;
+	GLint baseVertex;
+};
+
+// consecutive ranges of one primitive type, submitted with a single glMultiDrawElementsBaseVertex
+struct MultiDrawBatch
+{
+	GLenum mode;
+	std::vector<GLsizei> counts;
+	std::vector<const void*> offsets;
+	std::vector<GLint> baseVertices;
+};
+
+/*
+ * retained counterpart of Renderer::Render, shapes are recorded once through the
+ * same beginShape / vertex / endShape calls, compiled into gpu buffers and replayed
+ * in the order they were recorded. each run of shapes sharing a primitive type is one
+ * multi draw, so a list that alternates between types costs a draw per change
+ */
+class DrawList
+{
+	public:
+		static constexpr unsigned int MAX_RANGE_VERTICES = 65536;
+
+		DrawList();
+		~DrawList();
+
+		void setLayout(const VertexLayout& vertexLayout) { layout = vertexLayout; };
+
+		void beginShape(Renderer::DrawType type, unsigned int vertexCount, unsigned int indicesCount);
+		void nextVertex() {};
+		void vertex1f(float v);
+		void vertex2f(float v0, float v1);
+		void vertex3f(float v0, float v1, float v2);
+		void vertex4f(float v0, float v1, float v2, float v3);
+		void vertex1i(int v);
+		void vertex2i(int v0, int v1);
+		void vertex3i(int v0, int v1, int v2);
+		void vertex4i(int v0, int v1, int v2, int v3);
+
+		// compact writers, each writes one attribute in the named format
+		void vertex2h(float v0, float v1);
+		void vertex3h(float v0, float v1, float v2);
+		void vertex4h(float v0, float v1, float v2, float v3);
+		void vertex4b(int8_t v0, int8_t v1, int8_t v2, int8_t v3);
+		void vertex4ub(uint8_t v0, uint8_t v1, uint8_t v2, uint8_t v3);
+		void vertex4bn(float v0, float v1, float v2, float v3);
+		void vertex4ubn(float v0, float v1, float v2, float v3);
+		void vertex2s(int16_t v0, int16_t v1);
+		void vertex3s(int16_t v0, int16_t v1, int16_t v2);
+		void vertex4s(int16_t v0, int16_t v1, int16_t v2, int16_t v3);
+		void vertex2us(uint16_t v0, uint16_t v1);
+		void vertex4us(uint16_t v0, uint16_t v1, uint16_t v2, uint16_t v3);
+		void vertex2sn(float v0, float v1);
+		void vertex3sn(float v0, float v1, float v2);
+		void vertex4sn(float v0, float v1, float v2, float v3);
+		void vertex2usn(float v0, float v1);
+		void vertex4usn(float v0, float v1, float v2, float v3);
+		void vertex4p(float x, float y, float z, float w);
+		void vertex4up(float x, float y, float z, float w);
+
+		void endShape(const unsigned int* indices);
+		void endShape();
+
+		// uploads the recorded shapes, the cpu copies are released afterwards
+		void compile();
+		void clear();
+
+		void draw(Renderer::Render& renderer, Renderer::Shader& shader);
+
+		bool isCompiled() const { return vao != 0; };
+		unsigned int getVertexCount() const { return vertexCount; };
+		unsigned int getIndexCount() const { return indexCount; };
+		const std::vector<DrawRange>& getRanges() const { return ranges; };
+		const std::vector<MultiDrawBatch>& getBatches() const { return batches; };
+
+	private:
+		VertexLayout layout;
+
+		GLuint vao;
+		GLuint vbo;
+		GLuint ibo;
+
+		std::vector<unsigned char> vertices;
+		std::vector<uint16_t> indices;
+		std::vector<DrawRange> ranges;
+		std::vector<MultiDrawBatch> batches;
+		bool lastRangeMergeable;
+
+		// vertex arrays of the shaders the list was drawn with, rebound after each draw
+		std::vector<std::pair<const Renderer::Shader*, GLuint>> shaderVertexArrays;
+
+		unsigned int vertexCount;
+		unsigned int indexCount;
+
+		// shape being recorded
+		Renderer::DrawType shapeType;
+		unsigned int shapeVertexCount;
+		unsigned int shapeIndexCount;
+		std::size_t shapeStart;
+
+		void write(const void* data, std::size_t bytes);
+		// converts to the format of the attribute being written when it is not plain 32 bit
+		void writeConverted(const float* values, int count, bool integer, const void* raw);
+		void writeFormat(VertexFormat format, const float* values, int count);
+		// values already in the storage format of the attribute being written
+		void writeRaw(VertexFormat format, const void* data);
+		// throws unless the layout has an attribute of that format where the next write lands
+		void checkAttrib(const VertexAttrib& written, bool exact);
+		void releaseBuffers();
+		GLuint getShaderVertexArray(const Renderer::Shader& shader);
+
+		static GLenum getMode(Renderer::DrawType type);
+		static bool isListMode(Renderer::DrawType type);
+};
@@ -0,0 +1,518 @@
+#include "environmentmap.hpp"
+#include "../utils.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+	// an rgba float texel, one sse register when available
+#if defined(__SSE2__)
+	typedef __m128 Texel;
+
+	inline Texel texelZero() { return _mm_setzero_ps(); }
+	inline Texel texelLoad(const float* p) { return _mm_loadu_ps(p); }
+	inline void texelStore(float* p, Texel t) { _mm_storeu_ps(p, t); }
+	inline Texel texelScale(Texel a, float s) { return _mm_mul_ps(a, _mm_set1_ps(s)); }
+	inline Texel texelMulAdd(Texel acc, Texel a, float s) { return _mm_add_ps(acc, _mm_mul_ps(a, _mm_set1_ps(s))); }
+	inline Texel texelLerp(Texel a, Texel b, float t) { return _mm_add_ps(a, _mm_mul_ps(_mm_sub_ps(b, a), _mm_set1_ps(t))); }
+#else
+	struct Texel { float v[4]; };
+
+	inline Texel texelZero() { return { { 0.f, 0.f, 0.f, 0.f } }; }
+	inline Texel texelLoad(const float* p) { return { { p[0], p[1], p[2], p[3] } }; }
+	inline void texelStore(float* p, Texel t) { for(int i=0;i<4;++i) p[i] = t.v[i]; }
+	inline Texel texelScale(Texel a, float s) { for(int i=0;i<4;++i) a.v[i] *= s; return a; }
+	inline Texel texelMulAdd(Texel acc, Texel a, float s) { for(int i=0;i<4;++i) acc.v[i] += a.v[i] * s; return acc; }
+	inline Texel texelLerp(Texel a, Texel b, float t) { for(int i=0;i<4;++i) a.v[i] += (b.v[i] - a.v[i]) * t; return a; }
+#endif
+
+	// ggx sample directions around +z, padded to lanes of four with zero weights
+	struct Lobe
+	{
+		std::vector<float> x;
+		std::vector<float> y;
+		std::vector<float> z;
+		std::vector<float> weight;
+		std::vector<float> lod;
+		float totalWeight;
+	};
+
+	// the normal and view are both +z, so the lobe is the same for every texel of a level.
+	// each sample reads from the mip whose texels cover the solid angle it stands for
+	Lobe genLobe(float roughness, unsigned int count, float texelSolidAngle)
+	{
+		float alpha = roughness * roughness;
+		float alpha2 = alpha * alpha;
+
+		Lobe lobe;
+		lobe.totalWeight = 0.f;
+		for(unsigned int i=0;i<count;++i)
+		{
+			float hx, hy, hz;
+			sampleGgx((static_cast<float>(i) + 0.5f) / count, radicalInverse(i), alpha, hx, hy, hz);
+
+			// reflect the view about the half vector
+			float lz = 2.f * hz * hz - 1.f;
+			if(lz <= 0.f)
+				continue;
+
+			float d = (hz * hz) * (alpha2 - 1.f) + 1.f;
+			float ggx = alpha2 / (PI * d * d);
+			float pdf = ggx / 4.f;
+			float sample_solid_angle = 1.f / (count * pdf + 1e-6f);
+
+			lobe.x.push_back(2.f * hz * hx);
+			lobe.y.push_back(2.f * hz * hy);
+			lobe.z.push_back(lz);
+			lobe.weight.push_back(lz);
+			lobe.lod.push_back(std::max(0.f, 0.5f * std::log2(sample_solid_angle / texelSolidAngle) + 1.f));
+			lobe.totalWeight += lz;
+		}
+
+		while(lobe.x.size() % 4)
+		{
+			lobe.x.push_back(0.f);
+			lobe.y.push_back(0.f);
+			lobe.z.push_back(1.f);
+			lobe.weight.push_back(0.f);
+			lobe.lod.push_back(0.f);
+		}
+
+		return lobe;
+	}
+
+	// cube face texel to a direction, s and t in [-1, 1] following the gl face orientation
+	void faceDirection(int face, float s, float t, float& x, float& y, float& z)
+	{
+		switch(face)
+		{
+			case 0: x = 1.f; y = -t; z = -s; break;
+			case 1: x = -1.f; y = -t; z = s; break;
+			case 2: x = s; y = 1.f; z = t; break;
+			case 3: x = s; y = -1.f; z = -t; break;
+			case 4: x = s; y = -t; z = 1.f; break;
+			default: x = -s; y = -t; z = -1.f; break;
+		}
+
+		float inv_length = 1.f / std::sqrt(x * x + y * y + z * z);
+		x *= inv_length;
+		y *= inv_length;
+		z *= inv_length;
+	}
+
+	Texel sampleLevel(const FloatImage& level, float u, float v)
+	{
+		int w = static_cast<int>(level.width);
+		int h = static_cast<int>(level.height);
+
+		// the sky used to be sampled from a vertically flipped texture, keep its orientation
+		float x = u * w - 0.5f;
+		float y = (1.f - v) * h - 0.5f;
+		float fx = std::floor(x);
+		float fy = std::floor(y);
+
+		int x0 = ((static_cast<int>(fx) % w) + w) % w;
+		int x1 = (x0 + 1) % w;
+		int y0 = std::clamp(static_cast<int>(fy), 0, h - 1);
+		int y1 = std::clamp(static_cast<int>(fy) + 1, 0, h - 1);
+
+		const float* texels = level.texels.data();
+		Texel top = texelLerp(texelLoad(texels + (y0 * w + x0) * 4), texelLoad(texels + (y0 * w + x1) * 4), x - fx);
+		Texel bottom = texelLerp(texelLoad(texels + (y1 * w + x0) * 4), texelLoad(texels + (y1 * w + x1) * 4), x - fx);
+		return texelLerp(top, bottom, y - fy);
+	}
+
+	// the same mapping surface.frag did per pixel, now once per texel of the base cube
+	Texel sampleEquirect(const std::vector<FloatImage>& chain, float x, float y, float z, float lod)
+	{
+		float u = std::atan2(z, x) / (2.f * PI);
+		if(u < 0.f)
+			u += 1.f;
+		float v = std::acos(std::clamp(y, -1.f, 1.f)) / PI;
+
+		lod = std::clamp(lod, 0.f, static_cast<float>(chain.size() - 1));
+		std::size_t base = static_cast<std::size_t>(lod);
+		float blend = lod - base;
+
+		Texel texel = sampleLevel(chain[base], u, v);
+		if(blend <= 0.f || base + 1 >= chain.size())
+			return texel;
+		return texelLerp(texel, sampleLevel(chain[base + 1], u, v), blend);
+	}
+
+	// direction to a face and texel coordinates, the inverse of faceDirection
+	Texel sampleFace(const FloatImage& level, float s, float t)
+	{
+		int size = static_cast<int>(level.width);
+		float x = (s + 1.f) * 0.5f * size - 0.5f;
+		float y = (t + 1.f) * 0.5f * size - 0.5f;
+		float fx = std::floor(x);
+		float fy = std::floor(y);
+
+		// clamped at the face edges, the lobes are wide enough to hide the seam
+		int x0 = std::clamp(static_cast<int>(fx), 0, size - 1);
+		int x1 = std::clamp(static_cast<int>(fx) + 1, 0, size - 1);
+		int y0 = std::clamp(static_cast<int>(fy), 0, size - 1);
+		int y1 = std::clamp(static_cast<int>(fy) + 1, 0, size - 1);
+
+		const float* texels = level.texels.data();
+		Texel top = texelLerp(texelLoad(texels + (y0 * size + x0) * 4), texelLoad(texels + (y0 * size + x1) * 4), x - fx);
+		Texel bottom = texelLerp(texelLoad(texels + (y1 * size + x0) * 4), texelLoad(texels + (y1 * size + x1) * 4), x - fx);
+		return texelLerp(top, bottom, y - fy);
+	}
+
+	Texel sampleCube(const std::vector<FloatImage> (&faces)[6], float x, float y, float z, float lod)
+	{
+		float ax = std::fabs(x);
+		float ay = std::fabs(y);
+		float az = std::fabs(z);
+
+		int face;
+		float major, s, t;
+		if(ax >= ay && ax >= az)
+		{
+			face = x > 0.f ? 0 : 1;
+			major = ax;
+			s = x > 0.f ? -z : z;
+			t = -y;
+		}
+		else if(ay >= az)
+		{
+			face = y > 0.f ? 2 : 3;
+			major = ay;
+			s = x;
+			t = y > 0.f ? z : -z;
+		}
+		else
+		{
+			face = z > 0.f ? 4 : 5;
+			major = az;
+			s = z > 0.f ? x : -x;
+			t = -y;
+		}
+		s /= major;
+		t /= major;
+
+		const std::vector<FloatImage>& chain = faces[face];
+		lod = std::clamp(lod, 0.f, static_cast<float>(chain.size() - 1));
+		std::size_t base = static_cast<std::size_t>(lod);
+		float blend = lod - base;
+
+		Texel texel = sampleFace(chain[base], s, t);
+		if(blend <= 0.f || base + 1 >= chain.size())
+			return texel;
+		return texelLerp(texel, sampleFace(chain[base + 1], s, t), blend);
+	}
+
+	// rotates four lobe samples from around +z to around n
+	void rotateSamples(const Lobe& lobe, std::size_t first, const float t[3], const float b[3], const float n[3],
+			float x[4], float y[4], float z[4])
+	{
+#if defined(__SSE2__)
+		__m128 lx = _mm_loadu_ps(lobe.x.data() + first);
+		__m128 ly = _mm_loadu_ps(lobe.y.data() + first);
+		__m128 lz = _mm_loadu_ps(lobe.z.data() + first);
+
+		_mm_storeu_ps(x, _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(t[0]), lx), _mm_mul_ps(_mm_set1_ps(b[0]), ly)),
+					_mm_mul_ps(_mm_set1_ps(n[0]), lz)));
+		_mm_storeu_ps(y, _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(t[1]), lx), _mm_mul_ps(_mm_set1_ps(b[1]), ly)),
+					_mm_mul_ps(_mm_set1_ps(n[1]), lz)));
+		_mm_storeu_ps(z, _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(t[2]), lx), _mm_mul_ps(_mm_set1_ps(b[2]), ly)),
+					_mm_mul_ps(_mm_set1_ps(n[2]), lz)));
+#else
+		for(int i=0;i<4;++i)
+		{
+			float lx = lobe.x[first + i];
+			float ly = lobe.y[first + i];
+			float lz = lobe.z[first + i];
+			x[i] = t[0] * lx + b[0] * ly + n[0] * lz;
+			y[i] = t[1] * lx + b[1] * ly + n[1] * lz;
+			z[i] = t[2] * lx + b[2] * ly + n[2] * lz;
+		}
+#endif
+	}
+
+	Texel convolve(const std::vector<FloatImage> (&faces)[6], const Lobe& lobe, float minLod, float nx, float ny, float nz)
+	{
+		// any tangent frame works since the lobe is symmetric around the normal
+		float n[3] = { nx, ny, nz };
+		float t[3];
+		if(std::fabs(nz) < 0.999f)
+		{
+			t[0] = ny;
+			t[1] = -nx;
+			t[2] = 0.f;
+		}
+		else
+		{
+			t[0] = 0.f;
+			t[1] = nz;
+			t[2] = -ny;
+		}
+		float inv_length = 1.f / std::sqrt(t[0] * t[0] + t[1] * t[1] + t[2] * t[2]);
+		t[0] *= inv_length;
+		t[1] *= inv_length;
+		t[2] *= inv_length;
+		float b[3] = { n[1] * t[2] - n[2] * t[1], n[2] * t[0] - n[0] * t[2], n[0] * t[1] - n[1] * t[0] };
+
+		Texel sum = texelZero();
+		for(std::size_t i=0;i<lobe.x.size();i+=4)
+		{
+			float x[4], y[4], z[4];
+			rotateSamples(lobe, i, t, b, n, x, y, z);
+
+			for(std::size_t lane=0;lane<4;++lane)
+			{
+				float weight = lobe.weight[i + lane];
+				if(weight <= 0.f)
+					continue;
+
+				float lod = std::max(minLod, lobe.lod[i + lane]);
+				sum = texelMulAdd(sum, sampleCube(faces, x[lane], y[lane], z[lane], lod), weight);
+			}
+		}
+
+		return texelScale(sum, 1.f / lobe.totalWeight);
+	}
+}
+
+EnvironmentMap::EnvironmentMap(unsigned int faceSize, unsigned int levels, unsigned int sampleCount,
+		TextureFormat ldrFormat, TextureFormat hdrFormat, const char* cacheDirectory)
+	: faceSize{ faceSize }, levels{ std::max(1u, levels) }, sampleCount{ sampleCount }, ldrFormat{ ldrFormat },
+	hdrFormat{ hdrFormat }, format{ ldrFormat }, cache{ cacheDirectory }, texture{ 0 }, placeholder{ 0 },
+	memorySize{ 0 }, ready{ false }
+{ }
+
+void EnvironmentMap::Init()
+{
+	// let lookups filter across face edges, rough levels are only a few texels wide
+	glEnable(GL_TEXTURE_CUBE_MAP_SEAMLESS);
+
+	// a single sky coloured texel on every face until the bake is done
+	const unsigned char placeholder_pixel[4] = { 135, 204, 235, 255 };
+	glGenTextures(1, &placeholder);
+	glBindTexture(GL_TEXTURE_CUBE_MAP, placeholder);
+	for(int face=0;face<6;++face)
+		glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, 0, GL_RGBA8, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE,
+				placeholder_pixel);
+	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAX_LEVEL, 0);
+	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+}
+
+void EnvironmentMap::load(const char* imagePath, Startup& startup)
+{
+	if(baking.valid() || ready)
+		throw Renderer::TextureOperationRejected("EnvironmentMap::load is meant to only be called once!");
+
+	path = imagePath;
+	ThreadPool& pool = startup.getPool();
+	baking = startup.async("environment bake", [this, &pool]() { prepare(pool); });
+}
+
+void EnvironmentMap::update()
+{
+	if(ready || !baking.valid() || baking.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+		return;
+
+	// rethrows anything the bake ran into
+	baking.get();
+
+	upload();
+
+	// the driver has its copy, drop the mapping and anything left on the heap
+	mapped.close();
+	std::vector<std::vector<unsigned char>>().swap(encoded);
+	ready = true;
+}
+
+void EnvironmentMap::bind(unsigned int slot)
+{
+	glActiveTexture(GL_TEXTURE0 + slot);
+	glBindTexture(GL_TEXTURE_CUBE_MAP, ready ? texture : placeholder);
+	glActiveTexture(GL_TEXTURE0);
+}
+
+std::vector<CubeLevel> EnvironmentMap::bake(const FloatImage& equirect, unsigned int faceSize, unsigned int levels,
+		unsigned int sampleCount, ThreadPool& pool)
+{
+	std::vector<FloatImage> chain = buildFloatMipChain(equirect);
+
+	// resample the image into a float cube, the mip whose texels are about as wide
+	// as the cube texels is used, four faces span the width of the image
+	float footprint_lod = std::max(0.f, std::log2(static_cast<float>(equirect.width) / (4.f * faceSize)));
+
+	FloatImage base[6];
+	for(FloatImage& face : base)
+	{
+		face.width = faceSize;
+		face.height = faceSize;
+		face.texels.resize(static_cast<std::size_t>(faceSize) * faceSize * 4);
+	}
+
+	pool.parallelFor(6 * faceSize, [&](std::size_t row) {
+		int face = static_cast<int>(row / faceSize);
+		unsigned int y = static_cast<unsigned int>(row % faceSize);
+		float* out = base[face].texels.data() + static_cast<std::size_t>(y) * faceSize * 4;
+
+		for(unsigned int x=0;x<faceSize;++x)
+		{
+			float nx, ny, nz;
+			faceDirection(face, 2.f * (x + 0.5f) / faceSize - 1.f, 2.f * (y + 0.5f) / faceSize - 1.f, nx, ny, nz);
+			texelStore(out + x * 4, sampleEquirect(chain, nx, ny, nz, footprint_lod));
+		}
+	});
+
+	// the rough levels integrate over box filtered copies of the cube, no trig per sample
+	std::vector<FloatImage> faces[6];
+	pool.parallelFor(6, [&](std::size_t face) {
+		faces[face] = buildFloatMipChain(std::move(base[face]));
+	});
+
+	// solid angle of a texel of the full resolution cube
+	float texel_solid_angle = 4.f * PI / (6.f * faceSize * faceSize);
+
+	std::vector<CubeLevel> result(levels);
+	for(unsigned int level=0;level<levels;++level)
+	{
+		CubeLevel& cube_level = result[level];
+		cube_level.size = std::max(1u, faceSize >> level);
+		unsigned int size = cube_level.size;
+		for(std::vector<float>& face : cube_level.faces)
+			face.resize(static_cast<std::size_t>(size) * size * 4);
+
+		float roughness = levels > 1 ? static_cast<float>(level) / (levels - 1) : 0.f;
+		Lobe lobe = genLobe(roughness, sampleCount, texel_solid_angle);
+
+		pool.parallelFor(6 * size, [&](std::size_t row) {
+			int face = static_cast<int>(row / size);
+			unsigned int y = static_cast<unsigned int>(row % size);
+			float* out = cube_level.faces[face].data() + static_cast<std::size_t>(y) * size * 4;
+
+			for(unsigned int x=0;x<size;++x)
+			{
+				// a mirror has nothing to integrate, copy the resampled cube
+				Texel texel;
+				if(level == 0)
+				{
+					texel = texelLoad(faces[face][0].texels.data() + (static_cast<std::size_t>(y) * size + x) * 4);
+				}
+				else
+				{
+					float nx, ny, nz;
+					faceDirection(face, 2.f * (x + 0.5f) / size - 1.f, 2.f * (y + 0.5f) / size - 1.f, nx, ny, nz);
+					texel = convolve(faces, lobe, static_cast<float>(level), nx, ny, nz);
+				}
+
+				texelStore(out + x * 4, texel);
+				out[x * 4 + 3] = 1.f;
+			}
+		});
+	}
+
+	return result;
+}
+
+void EnvironmentMap::prepare(ThreadPool& pool)
+{
+	std::vector<char> source = TextureCache::readSource(path);
+	uint64_t source_hash = TextureCache::hashSource(source);
+
+	const stbi_uc* source_data = reinterpret_cast<const stbi_uc*>(source.data());
+	int source_size = static_cast<int>(source.size());
+	bool hdr = stbi_is_hdr_from_memory(source_data, source_size) != 0;
+	format = hdr ? hdrFormat : ldrFormat;
+
+	// everything that changes the baked levels goes in the tag
+	std::string tag = "environment " + std::to_string(faceSize) + " " + std::to_string(levels) + " " +
+		std::to_string(sampleCount) + " " + std::to_string(static_cast<uint32_t>(format));
+	std::string entry = cache.entryPath(path, tag);
+	if(mapped.open(entry, source_hash))
+		return;
+
+	// the flip flag is global, only override it for this thread
+	stbi_set_flip_vertically_on_load_thread(0);
+
+	// hdr texels are linear radiance, 8 bit images keep the values they were always shaded with
+	int image_width, image_height, channels;
+	FloatImage equirect;
+	if(hdr)
+	{
+		float* data = stbi_loadf_from_memory(source_data, source_size, &image_width, &image_height, &channels, 4);
+		if(!data)
+			throw Renderer::FileNotFoundException("Unable to decode environment: " + path);
+
+		equirect.texels.assign(data, data + static_cast<std::size_t>(image_width) * image_height * 4);
+		stbi_image_free(data);
+	}
+	else
+	{
+		unsigned char* data = stbi_load_from_memory(source_data, source_size, &image_width, &image_height, &channels, 4);
+		if(!data)
+			throw Renderer::FileNotFoundException("Unable to decode environment: " + path);
+
+		equirect.texels.resize(static_cast<std::size_t>(image_width) * image_height * 4);
+		for(std::size_t i=0;i<equirect.texels.size();++i)
+			equirect.texels[i] = data[i] * (1.f / 255.f);
+		stbi_image_free(data);
+	}
+	equirect.width = image_width;
+	equirect.height = image_height;
+
+	std::vector<CubeLevel> cube = bake(equirect, faceSize, levels, sampleCount, pool);
+
+	encoded.resize(static_cast<std::size_t>(levels) * 6);
+	pool.parallelFor(encoded.size(), [&](std::size_t image) {
+		const CubeLevel& level = cube[image / 6];
+		encoded[image] = encodeFloatTexture(format, level.faces[image % 6].data(), level.size, level.size);
+	});
+
+	if(cache.write(entry, source_hash, format, faceSize, faceSize, levels, 6, encoded) && mapped.open(entry, source_hash))
+		std::vector<std::vector<unsigned char>>().swap(encoded);
+}
+
+void EnvironmentMap::upload()
+{
+	glGenTextures(1, &texture);
+	glBindTexture(GL_TEXTURE_CUBE_MAP, texture);
+
+	if(mapped.isOpen())
+	{
+		format = mapped.getFormat();
+		mapped.upload(GL_TEXTURE_CUBE_MAP);
+	}
+	else
+	{
+		std::vector<const unsigned char*> images;
+		for(const std::vector<unsigned char>& image : encoded)
+			images.push_back(image.data());
+		uploadTexture(GL_TEXTURE_CUBE_MAP, format, faceSize, faceSize, levels, 6, images);
+	}
+
+	// unsupported block formats were decoded to rgba8 on the way up
+	TextureFormat stored = textureFormatSupported(format) ? format : TextureFormat::RGBA8;
+	for(unsigned int level=0;level<levels;++level)
+		memorySize += 6 * textureLevelSize(stored, std::max(1u, faceSize >> level), std::max(1u, faceSize >> level));
+
+	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+}
+
+EnvironmentMap::~EnvironmentMap()
+{
+	if(baking.valid())
+		baking.wait();
+
+	if(texture)
+		glDeleteTextures(1, &texture);
+	if(placeholder)
+		glDeleteTextures(1, &placeholder);
+}
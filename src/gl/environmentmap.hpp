@@ -0,0 +1,80 @@
+#pragma once
+
+#include <renderer/Renderer.hpp>
+
+#include <future>
+#include <string>
+#include <vector>
+
+#include "../core/startup.hpp"
+#include "texturecache.hpp"
+
+// one mip level of a cubemap as unclamped rgba floats, faces in the +x -x +y -y +z -z order gl expects
+struct CubeLevel
+{
+	unsigned int size;
+	std::vector<float> faces[6];
+};
+
+/*
+ * bakes an equirectangular image into a cubemap whose mip levels are prefiltered
+ * with a ggx lobe of increasing roughness, level n holds roughness n / (levels - 1).
+ * the bake runs on the pool and lands in the texture cache, later runs map it from disk.
+ * hdr sources keep their range through the bake and are stored in a float format
+ */
+class EnvironmentMap
+{
+	public:
+		EnvironmentMap(unsigned int faceSize = 256, unsigned int levels = 6, unsigned int sampleCount = 64,
+				TextureFormat ldrFormat = TextureFormat::BC1, TextureFormat hdrFormat = TextureFormat::RGB9E5,
+				const char* cacheDirectory = "./cache/textures");
+		~EnvironmentMap();
+
+		void Init();
+
+		// reads the cache or bakes on the pool, needs no context
+		void load(const char* path, Startup& startup);
+
+		// call once per frame on the thread that owns the context
+		void update();
+
+		void bind(unsigned int slot = 0);
+
+		bool isReady() const { return ready; };
+		GLuint getId() const { return ready ? texture : placeholder; };
+
+		// lod to sample for a roughness of 1
+		float getMaxLod() const { return static_cast<float>(levels - 1); };
+
+		// gpu bytes of every face and level once uploaded
+		std::size_t getMemorySize() const { return memorySize; };
+
+		static std::vector<CubeLevel> bake(const FloatImage& equirect, unsigned int faceSize, unsigned int levels,
+				unsigned int sampleCount, ThreadPool& pool);
+
+	private:
+		std::string path;
+		unsigned int faceSize;
+		unsigned int levels;
+		unsigned int sampleCount;
+		TextureFormat ldrFormat;
+		TextureFormat hdrFormat;
+
+		// picked by the source once it is read
+		TextureFormat format;
+
+		TextureCache cache;
+		std::future<void> baking;
+
+		// the cache entry, or the encoded levels when it could not be written
+		MappedTexture mapped;
+		std::vector<std::vector<unsigned char>> encoded;
+
+		GLuint texture;
+		GLuint placeholder;
+		std::size_t memorySize;
+		bool ready;
+
+		void prepare(ThreadPool& pool);
+		void upload();
+};
@@ -0,0 +1,51 @@
+#include "frameuniforms.hpp"
+#include "glutils.hpp"
+
+FrameUniforms::FrameUniforms()
+	: ubo{ 0 }, data{}
+{ }
+
+void FrameUniforms::Init()
+{
+	glGenBuffers(1, &ubo);
+	glBindBuffer(GL_UNIFORM_BUFFER, ubo);
+	glBufferData(GL_UNIFORM_BUFFER, sizeof(FrameData), nullptr, GL_DYNAMIC_DRAW);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+	glBindBufferBase(GL_UNIFORM_BUFFER, BINDING, ubo);
+}
+
+void FrameUniforms::attachShader(Renderer::Shader& shader)
+{
+	GLuint program = getShaderProgram(shader);
+	GLuint blockIndex = glGetUniformBlockIndex(program, "FrameData");
+	if(blockIndex == GL_INVALID_INDEX)
+		throw Renderer::ShaderOperationRejected("Shader does not declare the FrameData uniform block!");
+
+	glUniformBlockBinding(program, blockIndex, BINDING);
+}
+
+void FrameUniforms::update(const Renderer::Mat4<float>& view, const Renderer::Mat4<float>& projection,
+		const Renderer::Vec3<float>& camera, float time)
+{
+	Renderer::Mat4<float> viewProjection = projection * view;
+
+	memcpy(data.view, *view, sizeof(data.view));
+	memcpy(data.projection, *projection, sizeof(data.projection));
+	memcpy(data.viewProjection, *viewProjection, sizeof(data.viewProjection));
+	data.camera[0] = camera.x;
+	data.camera[1] = camera.y;
+	data.camera[2] = camera.z;
+	data.camera[3] = 1.f;
+	data.time = time;
+
+	glBindBuffer(GL_UNIFORM_BUFFER, ubo);
+	glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(FrameData), &data);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+FrameUniforms::~FrameUniforms()
+{
+	if(ubo)
+		glDeleteBuffers(1, &ubo);
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <renderer/Renderer.hpp>
+
+// mirrors the std140 layout of the FrameData block in the shaders
+struct FrameData
+{
+	float view[16];
+	float projection[16];
+	float viewProjection[16];
+	float camera[4];
+	float time;
+	float padding[3];
+};
+
+class FrameUniforms
+{
+	public:
+		// every program shares this binding point for the FrameData block
+		static constexpr GLuint BINDING = 0;
+
+		FrameUniforms();
+		~FrameUniforms();
+
+		void Init();
+
+		void attachShader(Renderer::Shader& shader);
+		void update(const Renderer::Mat4<float>& view, const Renderer::Mat4<float>& projection,
+				const Renderer::Vec3<float>& camera, float time);
+
+	private:
+		GLuint ubo;
+		FrameData data;
+};
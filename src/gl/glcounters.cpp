@@ -0,0 +1,333 @@
+#include "glcounters.hpp"
+#include "asyncreadback.hpp"
+
+#include <type_traits>
+
+bool GLCounters::s_installed = false;
+GLuint GLCounters::s_unpackBuffer = 0;
+GLFrameCounters GLCounters::s_frame{};
+GLFrameCounters GLCounters::s_last{};
+
+namespace
+{
+	// what the loader had before install, the wrappers forward to these
+	PFNGLDRAWARRAYSPROC originalDrawArrays = nullptr;
+	PFNGLDRAWARRAYSINSTANCEDPROC originalDrawArraysInstanced = nullptr;
+	PFNGLDRAWELEMENTSPROC originalDrawElements = nullptr;
+	PFNGLDRAWELEMENTSINSTANCEDPROC originalDrawElementsInstanced = nullptr;
+	PFNGLDRAWELEMENTSBASEVERTEXPROC originalDrawElementsBaseVertex = nullptr;
+	PFNGLDRAWRANGEELEMENTSPROC originalDrawRangeElements = nullptr;
+	PFNGLMULTIDRAWELEMENTSBASEVERTEXPROC originalMultiDrawElementsBaseVertex = nullptr;
+
+	PFNGLBUFFERDATAPROC originalBufferData = nullptr;
+	PFNGLBUFFERSUBDATAPROC originalBufferSubData = nullptr;
+	PFNGLMAPBUFFERRANGEPROC originalMapBufferRange = nullptr;
+	PFNGLBINDBUFFERPROC originalBindBuffer = nullptr;
+	PFNGLDELETEBUFFERSPROC originalDeleteBuffers = nullptr;
+
+	PFNGLTEXIMAGE2DPROC originalTexImage2D = nullptr;
+	PFNGLTEXSUBIMAGE2DPROC originalTexSubImage2D = nullptr;
+	PFNGLCOMPRESSEDTEXIMAGE2DPROC originalCompressedTexImage2D = nullptr;
+	PFNGLCOMPRESSEDTEXSUBIMAGE2DPROC originalCompressedTexSubImage2D = nullptr;
+
+	PFNGLUSEPROGRAMPROC originalUseProgram = nullptr;
+	PFNGLBINDTEXTUREPROC originalBindTexture = nullptr;
+}
+
+// the glUniform family only differs in its arguments, one wrapper per loader pointer
+template<auto& Pointer, typename Proc>
+struct UniformHook;
+
+template<auto& Pointer, typename... Args>
+struct UniformHook<Pointer, void (APIENTRYP)(Args...)>
+{
+	static void (APIENTRYP original)(Args...);
+
+	static void APIENTRY call(Args... args)
+	{
+		++GLCounters::s_frame.uniformUploads;
+		original(args...);
+	}
+
+	static void install()
+	{
+		original = Pointer;
+		Pointer = call;
+	}
+};
+
+template<auto& Pointer, typename... Args>
+void (APIENTRYP UniformHook<Pointer, void (APIENTRYP)(Args...)>::original)(Args...) = nullptr;
+
+template<auto& Pointer>
+static void installUniformHook()
+{
+	UniformHook<Pointer, std::remove_reference_t<decltype(Pointer)>>::install();
+}
+
+void GLCounters::install()
+{
+	if(s_installed)
+		return;
+
+	originalDrawArrays = glad_glDrawArrays;
+	glad_glDrawArrays = drawArrays;
+	originalDrawArraysInstanced = glad_glDrawArraysInstanced;
+	glad_glDrawArraysInstanced = drawArraysInstanced;
+	originalDrawElements = glad_glDrawElements;
+	glad_glDrawElements = drawElements;
+	originalDrawElementsInstanced = glad_glDrawElementsInstanced;
+	glad_glDrawElementsInstanced = drawElementsInstanced;
+	originalDrawElementsBaseVertex = glad_glDrawElementsBaseVertex;
+	glad_glDrawElementsBaseVertex = drawElementsBaseVertex;
+	originalDrawRangeElements = glad_glDrawRangeElements;
+	glad_glDrawRangeElements = drawRangeElements;
+	originalMultiDrawElementsBaseVertex = glad_glMultiDrawElementsBaseVertex;
+	glad_glMultiDrawElementsBaseVertex = multiDrawElementsBaseVertex;
+
+	originalBufferData = glad_glBufferData;
+	glad_glBufferData = bufferData;
+	originalBufferSubData = glad_glBufferSubData;
+	glad_glBufferSubData = bufferSubData;
+	originalMapBufferRange = glad_glMapBufferRange;
+	glad_glMapBufferRange = mapBufferRange;
+	originalBindBuffer = glad_glBindBuffer;
+	glad_glBindBuffer = bindBuffer;
+	originalDeleteBuffers = glad_glDeleteBuffers;
+	glad_glDeleteBuffers = deleteBuffers;
+
+	// the only query, from here on the hooks follow the binding
+	GLint unpack = 0;
+	glGetIntegerv(GL_PIXEL_UNPACK_BUFFER_BINDING, &unpack);
+	s_unpackBuffer = static_cast<GLuint>(unpack);
+
+	originalTexImage2D = glad_glTexImage2D;
+	glad_glTexImage2D = texImage2D;
+	originalTexSubImage2D = glad_glTexSubImage2D;
+	glad_glTexSubImage2D = texSubImage2D;
+	originalCompressedTexImage2D = glad_glCompressedTexImage2D;
+	glad_glCompressedTexImage2D = compressedTexImage2D;
+	originalCompressedTexSubImage2D = glad_glCompressedTexSubImage2D;
+	glad_glCompressedTexSubImage2D = compressedTexSubImage2D;
+
+	originalUseProgram = glad_glUseProgram;
+	glad_glUseProgram = useProgram;
+	originalBindTexture = glad_glBindTexture;
+	glad_glBindTexture = bindTexture;
+
+	installUniformHook<glad_glUniform1f>();
+	installUniformHook<glad_glUniform2f>();
+	installUniformHook<glad_glUniform3f>();
+	installUniformHook<glad_glUniform4f>();
+	installUniformHook<glad_glUniform1i>();
+	installUniformHook<glad_glUniform2i>();
+	installUniformHook<glad_glUniform3i>();
+	installUniformHook<glad_glUniform4i>();
+	installUniformHook<glad_glUniform1fv>();
+	installUniformHook<glad_glUniform2fv>();
+	installUniformHook<glad_glUniform3fv>();
+	installUniformHook<glad_glUniform4fv>();
+	installUniformHook<glad_glUniform1iv>();
+	installUniformHook<glad_glUniformMatrix2fv>();
+	installUniformHook<glad_glUniformMatrix3fv>();
+	installUniformHook<glad_glUniformMatrix4fv>();
+
+	s_installed = true;
+}
+
+GLFrameCounters GLCounters::endFrame()
+{
+	s_last = s_frame;
+	s_frame = GLFrameCounters{};
+	return s_last;
+}
+
+void GLCounters::record(FrameStats& stats, const GLFrameCounters& counters)
+{
+	stats.record(FrameCounter::DRAW_CALLS, static_cast<double>(counters.drawCalls));
+	stats.record(FrameCounter::PRIMITIVES, static_cast<double>(counters.primitives));
+	stats.record(FrameCounter::VERTICES, static_cast<double>(counters.vertices));
+	stats.record(FrameCounter::INDICES, static_cast<double>(counters.indices));
+	stats.record(FrameCounter::BUFFER_BYTES, static_cast<double>(counters.bufferBytes));
+	stats.record(FrameCounter::TEXTURE_BYTES, static_cast<double>(counters.textureBytes));
+	stats.record(FrameCounter::PROGRAM_BINDS, static_cast<double>(counters.programBinds));
+	stats.record(FrameCounter::TEXTURE_BINDS, static_cast<double>(counters.textureBinds));
+	stats.record(FrameCounter::UNIFORM_UPLOADS, static_cast<double>(counters.uniformUploads));
+	stats.record(FrameCounter::INDEXED_DRAWS, static_cast<double>(counters.indexedDraws));
+}
+
+void GLCounters::report(std::ostream& os, const GLFrameCounters& counters)
+{
+	os << "gl frame: " << counters.drawCalls << " draws, "
+		<< counters.primitives << " primitives, " << counters.vertices << " vertices, " << counters.indices << " indices, "
+		<< counters.bufferBytes / 1024 << " KiB to buffers, " << counters.textureBytes / 1024 << " KiB to textures, "
+		<< counters.programBinds << " program binds, " << counters.textureBinds << " texture binds, "
+		<< counters.uniformUploads << " uniforms, " << counters.indexedDraws << " indexed draws\n";
+}
+
+void GLCounters::countDraw(GLenum mode, uint64_t count, uint64_t instances, bool indexed)
+{
+	uint64_t primitives;
+	switch(mode)
+	{
+		case GL_TRIANGLES: primitives = count / 3; break;
+		case GL_TRIANGLE_STRIP: case GL_TRIANGLE_FAN: primitives = count > 2 ? count - 2 : 0; break;
+		case GL_LINES: primitives = count / 2; break;
+		case GL_LINE_STRIP: primitives = count > 1 ? count - 1 : 0; break;
+		case GL_LINE_LOOP: primitives = count > 1 ? count : 0; break;
+		case GL_POINTS: primitives = count; break;
+		default: primitives = 0; break;
+	}
+
+	s_frame.primitives += primitives * instances;
+	if(indexed)
+		s_frame.indices += count * instances;
+	else
+		s_frame.vertices += count * instances;
+}
+
+void GLCounters::countTexture(GLsizei width, GLsizei height, GLenum format, GLenum type, const void* pixels)
+{
+	// without pixels the upload only counts when it reads from an unpack buffer
+	if(!pixels && !s_unpackBuffer)
+		return;
+
+	// formats nothing here uploads come back as 0 and are left out rather than failing the call
+	s_frame.textureBytes += static_cast<uint64_t>(width) * height * AsyncReadback::findPixelSize(format, type);
+}
+
+void APIENTRY GLCounters::drawArrays(GLenum mode, GLint first, GLsizei count)
+{
+	++s_frame.drawCalls;
+	countDraw(mode, count, 1, false);
+	originalDrawArrays(mode, first, count);
+}
+
+void APIENTRY GLCounters::drawArraysInstanced(GLenum mode, GLint first, GLsizei count, GLsizei instances)
+{
+	++s_frame.drawCalls;
+	countDraw(mode, count, instances, false);
+	originalDrawArraysInstanced(mode, first, count, instances);
+}
+
+void APIENTRY GLCounters::drawElements(GLenum mode, GLsizei count, GLenum type, const void* indices)
+{
+	++s_frame.drawCalls;
+	++s_frame.indexedDraws;
+	countDraw(mode, count, 1, true);
+	originalDrawElements(mode, count, type, indices);
+}
+
+void APIENTRY GLCounters::drawElementsInstanced(GLenum mode, GLsizei count, GLenum type, const void* indices,
+		GLsizei instances)
+{
+	++s_frame.drawCalls;
+	++s_frame.indexedDraws;
+	countDraw(mode, count, instances, true);
+	originalDrawElementsInstanced(mode, count, type, indices, instances);
+}
+
+void APIENTRY GLCounters::drawElementsBaseVertex(GLenum mode, GLsizei count, GLenum type, const void* indices,
+		GLint baseVertex)
+{
+	++s_frame.drawCalls;
+	++s_frame.indexedDraws;
+	countDraw(mode, count, 1, true);
+	originalDrawElementsBaseVertex(mode, count, type, indices, baseVertex);
+}
+
+void APIENTRY GLCounters::drawRangeElements(GLenum mode, GLuint start, GLuint end, GLsizei count, GLenum type,
+		const void* indices)
+{
+	++s_frame.drawCalls;
+	++s_frame.indexedDraws;
+	countDraw(mode, count, 1, true);
+	originalDrawRangeElements(mode, start, end, count, type, indices);
+}
+
+void APIENTRY GLCounters::multiDrawElementsBaseVertex(GLenum mode, const GLsizei* counts, GLenum type,
+		const void* const* indices, GLsizei drawCount, const GLint* baseVertices)
+{
+	++s_frame.drawCalls;
+	++s_frame.indexedDraws;
+	for(GLsizei i=0;i<drawCount;++i)
+		countDraw(mode, counts[i], 1, true);
+	originalMultiDrawElementsBaseVertex(mode, counts, type, indices, drawCount, baseVertices);
+}
+
+void APIENTRY GLCounters::bufferData(GLenum target, GLsizeiptr size, const void* data, GLenum usage)
+{
+	// a null pointer only allocates or orphans the store
+	if(data)
+		s_frame.bufferBytes += size;
+	originalBufferData(target, size, data, usage);
+}
+
+void APIENTRY GLCounters::bufferSubData(GLenum target, GLintptr offset, GLsizeiptr size, const void* data)
+{
+	s_frame.bufferBytes += size;
+	originalBufferSubData(target, offset, size, data);
+}
+
+void* APIENTRY GLCounters::mapBufferRange(GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access)
+{
+	if(access & GL_MAP_WRITE_BIT)
+		s_frame.bufferBytes += length;
+	return originalMapBufferRange(target, offset, length, access);
+}
+
+void APIENTRY GLCounters::bindBuffer(GLenum target, GLuint buffer)
+{
+	if(target == GL_PIXEL_UNPACK_BUFFER)
+		s_unpackBuffer = buffer;
+	originalBindBuffer(target, buffer);
+}
+
+void APIENTRY GLCounters::deleteBuffers(GLsizei count, const GLuint* buffers)
+{
+	// deleting the bound buffer unbinds it
+	for(GLsizei i=0;i<count;++i)
+		if(buffers[i] == s_unpackBuffer)
+			s_unpackBuffer = 0;
+	originalDeleteBuffers(count, buffers);
+}
+
+void APIENTRY GLCounters::texImage2D(GLenum target, GLint level, GLint internalFormat, GLsizei width,
+		GLsizei height, GLint border, GLenum format, GLenum type, const void* pixels)
+{
+	countTexture(width, height, format, type, pixels);
+	originalTexImage2D(target, level, internalFormat, width, height, border, format, type, pixels);
+}
+
+void APIENTRY GLCounters::texSubImage2D(GLenum target, GLint level, GLint x, GLint y, GLsizei width,
+		GLsizei height, GLenum format, GLenum type, const void* pixels)
+{
+	countTexture(width, height, format, type, pixels);
+	originalTexSubImage2D(target, level, x, y, width, height, format, type, pixels);
+}
+
+void APIENTRY GLCounters::compressedTexImage2D(GLenum target, GLint level, GLenum internalFormat, GLsizei width,
+		GLsizei height, GLint border, GLsizei size, const void* data)
+{
+	s_frame.textureBytes += size;
+	originalCompressedTexImage2D(target, level, internalFormat, width, height, border, size, data);
+}
+
+void APIENTRY GLCounters::compressedTexSubImage2D(GLenum target, GLint level, GLint x, GLint y, GLsizei width,
+		GLsizei height, GLenum format, GLsizei size, const void* data)
+{
+	s_frame.textureBytes += size;
+	originalCompressedTexSubImage2D(target, level, x, y, width, height, format, size, data);
+}
+
+void APIENTRY GLCounters::useProgram(GLuint program)
+{
+	++s_frame.programBinds;
+	originalUseProgram(program);
+}
+
+void APIENTRY GLCounters::bindTexture(GLenum target, GLuint texture)
+{
+	++s_frame.textureBinds;
+	originalBindTexture(target, texture);
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <renderer/Renderer.hpp>
+
+#include <cstdint>
+#include <ostream>
+
+#include "../core/framestats.hpp"
+
+struct GLFrameCounters
+{
+	// api calls, a multi draw counts once
+	uint64_t drawCalls;
+	uint64_t primitives;
+	// vertices of array draws and indices of indexed draws
+	uint64_t vertices;
+	uint64_t indices;
+
+	// bytes handed to buffers through data, sub data or a mapping for writing
+	uint64_t bufferBytes;
+	// bytes handed to textures from memory or a pixel unpack buffer
+	uint64_t textureBytes;
+
+	uint64_t programBinds;
+	uint64_t textureBinds;
+	uint64_t uniformUploads;
+
+	// the indexed part of drawCalls. the library's batch flushes are among them, its flush is not hooked
+	uint64_t indexedDraws;
+};
+
+/*
+ * counts what every frame hands to gl. the renderer library is prebuilt, so install swaps the
+ * loader's function pointers for wrappers that count and forward, which covers the library's
+ * Render, Shader and Texture and this program alike. the counts live on the thread that owns
+ * the context, endFrame closes a frame there
+ */
+class GLCounters
+{
+	public:
+		// call once the loader has run, before the context moves to another thread
+		static void install();
+		static bool isInstalled() { return s_installed; };
+
+		// the counts since the previous call, which start over
+		static GLFrameCounters endFrame();
+		// the frame endFrame closed last
+		static const GLFrameCounters& getLastFrame() { return s_last; };
+
+		// one sample per counter into the stats' rings
+		static void record(FrameStats& stats, const GLFrameCounters& counters);
+		static void report(std::ostream& os, const GLFrameCounters& counters);
+
+	private:
+		static bool s_installed;
+		// the pixel unpack binding, followed through the hooks instead of asking the driver per upload
+		static GLuint s_unpackBuffer;
+		static GLFrameCounters s_frame;
+		static GLFrameCounters s_last;
+
+		template<auto& Pointer, typename Proc>
+		friend struct UniformHook;
+
+		static void countDraw(GLenum mode, uint64_t count, uint64_t instances, bool indexed);
+		static void countTexture(GLsizei width, GLsizei height, GLenum format, GLenum type, const void* pixels);
+
+		static void APIENTRY drawArrays(GLenum mode, GLint first, GLsizei count);
+		static void APIENTRY drawArraysInstanced(GLenum mode, GLint first, GLsizei count, GLsizei instances);
+		static void APIENTRY drawElements(GLenum mode, GLsizei count, GLenum type, const void* indices);
+		static void APIENTRY drawElementsInstanced(GLenum mode, GLsizei count, GLenum type, const void* indices,
+				GLsizei instances);
+		static void APIENTRY drawElementsBaseVertex(GLenum mode, GLsizei count, GLenum type, const void* indices,
+				GLint baseVertex);
+		static void APIENTRY drawRangeElements(GLenum mode, GLuint start, GLuint end, GLsizei count, GLenum type,
+				const void* indices);
+		static void APIENTRY multiDrawElementsBaseVertex(GLenum mode, const GLsizei* counts, GLenum type,
+				const void* const* indices, GLsizei drawCount, const GLint* baseVertices);
+
+		static void APIENTRY bufferData(GLenum target, GLsizeiptr size, const void* data, GLenum usage);
+		static void APIENTRY bufferSubData(GLenum target, GLintptr offset, GLsizeiptr size, const void* data);
+		static void* APIENTRY mapBufferRange(GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access);
+		static void APIENTRY bindBuffer(GLenum target, GLuint buffer);
+		static void APIENTRY deleteBuffers(GLsizei count, const GLuint* buffers);
+
+		static void APIENTRY texImage2D(GLenum target, GLint level, GLint internalFormat, GLsizei width,
+				GLsizei height, GLint border, GLenum format, GLenum type, const void* pixels);
+		static void APIENTRY texSubImage2D(GLenum target, GLint level, GLint x, GLint y, GLsizei width,
+				GLsizei height, GLenum format, GLenum type, const void* pixels);
+		static void APIENTRY compressedTexImage2D(GLenum target, GLint level, GLenum internalFormat, GLsizei width,
+				GLsizei height, GLint border, GLsizei size, const void* data);
+		static void APIENTRY compressedTexSubImage2D(GLenum target, GLint level, GLint x, GLint y, GLsizei width,
+				GLsizei height, GLenum format, GLsizei size, const void* data);
+
+		static void APIENTRY useProgram(GLuint program);
+		static void APIENTRY bindTexture(GLenum target, GLuint texture);
+};
@@ -0,0 +1,99 @@
+#include "glutils.hpp"
+
+namespace
+{
+	const char* STUB_VERTEX =
+		"#version 410 core\n"
+		"void main() { gl_Position = vec4(0.0); }\n";
+	const char* STUB_FRAGMENT =
+		"#version 410 core\n"
+		"layout (location=0) out vec4 FragColor;\n"
+		"void main() { FragColor = vec4(0.0); }\n";
+}
+
+GLuint getShaderProgram(Renderer::Shader& shader)
+{
+	shader.bind();
+	GLint program = 0;
+	glGetIntegerv(GL_CURRENT_PROGRAM, &program);
+	return static_cast<GLuint>(program);
+}
+
+void createStubProgram(Renderer::Shader& shader)
+{
+	shader.create(STUB_VERTEX, STUB_FRAGMENT);
+}
+
+bool installProgramBinary(Renderer::Shader& shader, GLenum format, const std::vector<char>& binary)
+{
+	GLuint program = getShaderProgram(shader);
+	glProgramBinary(program, format, binary.data(), static_cast<GLsizei>(binary.size()));
+
+	GLint linked = GL_FALSE;
+	glGetProgramiv(program, GL_LINK_STATUS, &linked);
+	return linked == GL_TRUE;
+}
+
+bool buildProgramBinary(const std::string& vertexSource, const std::string& fragmentSource,
+		GLenum& format, std::vector<char>& binary)
+{
+	const char* sources[2] = { vertexSource.c_str(), fragmentSource.c_str() };
+	GLenum types[2] = { GL_VERTEX_SHADER, GL_FRAGMENT_SHADER };
+	GLuint shaders[2];
+
+	GLuint program = glCreateProgram();
+	for(int i=0;i<2;++i)
+	{
+		shaders[i] = glCreateShader(types[i]);
+		glShaderSource(shaders[i], 1, &sources[i], nullptr);
+		glCompileShader(shaders[i]);
+		glAttachShader(program, shaders[i]);
+	}
+
+	// without the hint the driver may hand back no binary, or one it will not load
+	glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+	glLinkProgram(program);
+
+	GLint linked = GL_FALSE;
+	glGetProgramiv(program, GL_LINK_STATUS, &linked);
+
+	binary.clear();
+	GLint length = 0;
+	if(linked == GL_TRUE)
+		glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+	if(length > 0)
+	{
+		binary.resize(length);
+		glGetProgramBinary(program, length, &length, &format, binary.data());
+		binary.resize(length);
+	}
+
+	for(GLuint shader : shaders)
+	{
+		glDetachShader(program, shader);
+		glDeleteShader(shader);
+	}
+	glDeleteProgram(program);
+
+	return !binary.empty();
+}
+
+bool hasExtension(const char* name)
+{
+	GLint count = 0;
+	glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+	for(GLint i=0;i<count;++i)
+	{
+		const char* extension = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, i));
+		if(extension && strcmp(extension, name) == 0)
+			return true;
+	}
+
+	return false;
+}
+
+double millisecondsSince(std::chrono::steady_clock::time_point start)
+{
+	auto elapse_time = std::chrono::steady_clock::now() - start;
+	return std::chrono::duration_cast<std::chrono::duration<double, std::milli>>(elapse_time).count();
+}
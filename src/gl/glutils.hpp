@@ -0,0 +1,23 @@
+#pragma once
+
+#include <renderer/Renderer.hpp>
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+// the shader class does not expose its program, so read it back after binding
+GLuint getShaderProgram(Renderer::Shader& shader);
+
+// creates the shader from a trivial program whose executable is replaced with glProgramBinary
+void createStubProgram(Renderer::Shader& shader);
+bool installProgramBinary(Renderer::Shader& shader, GLenum format, const std::vector<char>& binary);
+
+// compiles and links the sources with a retrievable binary requested, empty when either fails
+bool buildProgramBinary(const std::string& vertexSource, const std::string& fragmentSource,
+		GLenum& format, std::vector<char>& binary);
+
+// extensions are not part of the generated loader, look them up by name
+bool hasExtension(const char* name);
+
+double millisecondsSince(std::chrono::steady_clock::time_point start);
@@ -0,0 +1,78 @@
+#include "gputrace.hpp"
+
+#include <algorithm>
+
+GpuTrace::GpuTrace(unsigned int ringSize)
+	: queries(std::max(1u, ringSize)), head{ 0 }, count{ 0 }, open{ false }, cursor{ 0.0 }, dropped{ 0 },
+	track{ nullptr }
+{
+	for(Query& query : queries)
+		query.id = 0;
+}
+
+GpuTrace::~GpuTrace()
+{
+	for(Query& query : queries)
+		if(query.id)
+			glDeleteQueries(1, &query.id);
+}
+
+void GpuTrace::Init()
+{
+	for(Query& query : queries)
+		glGenQueries(1, &query.id);
+
+	track = Trace::createTrack("gpu");
+}
+
+bool GpuTrace::begin(const char* name)
+{
+	if(!track || open)
+		return false;
+
+	if(count == queries.size())
+	{
+		++dropped;
+		return false;
+	}
+
+	Query& query = queries[(head + count) % queries.size()];
+	query.name = name;
+	query.issued = Trace::now();
+	query.generation = Trace::getGeneration();
+
+	glBeginQuery(GL_TIME_ELAPSED, query.id);
+	open = true;
+	return true;
+}
+
+void GpuTrace::end()
+{
+	glEndQuery(GL_TIME_ELAPSED);
+	open = false;
+	++count;
+}
+
+void GpuTrace::update()
+{
+	while(count > 0)
+	{
+		Query& query = queries[head];
+
+		GLint available = 0;
+		glGetQueryObjectiv(query.id, GL_QUERY_RESULT_AVAILABLE, &available);
+		if(!available)
+			break;
+
+		GLuint64 nanoseconds = 0;
+		glGetQueryObjectui64v(query.id, GL_QUERY_RESULT, &nanoseconds);
+
+		double start = std::max(query.issued, cursor);
+		double duration = nanoseconds / 1000.0;
+		cursor = start + duration;
+		Trace::record(*track, query.name, start, duration, query.generation);
+
+		head = (head + 1) % queries.size();
+		--count;
+	}
+}
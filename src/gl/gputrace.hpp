@@ -0,0 +1,86 @@
+#pragma once
+
+#include <renderer/Renderer.hpp>
+
+#include <vector>
+
+#include "../core/trace.hpp"
+
+#if TRACE_ENABLED
+// times the gl commands of the rest of the scope on the gpu, zones do not nest
+#define TRACE_GPU_SCOPE(gpuTrace, name) GpuTrace::Zone TRACE_CONCAT(trace_gpu_zone_, __LINE__){ gpuTrace, name }
+#else
+#define TRACE_GPU_SCOPE(gpuTrace, name) do { } while(false)
+#endif
+
+/*
+ * gpu zones for the trace. each zone is a GL_TIME_ELAPSED query from a small ring, update
+ * reads the finished ones a frame or two later and records them on a gpu track. the gpu has
+ * no clock the trace shares, so a zone is placed where its commands were issued, or right
+ * after the previous zone when the gpu ran behind. only one time elapsed query can be active,
+ * a zone opened inside another is skipped
+ */
+class GpuTrace
+{
+	public:
+		GpuTrace(unsigned int ringSize = 64);
+		~GpuTrace();
+
+		GpuTrace(const GpuTrace&) = delete;
+		GpuTrace& operator=(const GpuTrace&) = delete;
+
+		void Init();
+
+		bool begin(const char* name);
+		void end();
+
+		// call once per frame on the context's thread
+		void update();
+
+		uint64_t getDropped() const { return dropped; };
+
+		class Zone
+		{
+			public:
+				Zone(GpuTrace& trace, const char* name);
+				~Zone();
+
+				Zone(const Zone&) = delete;
+				Zone& operator=(const Zone&) = delete;
+
+			private:
+				GpuTrace& trace;
+				bool active;
+		};
+
+	private:
+		struct Query
+		{
+			GLuint id;
+			const char* name;
+			double issued;
+			uint64_t generation;
+		};
+
+		// a queue over the ring, head is the oldest query in flight
+		std::vector<Query> queries;
+		unsigned int head;
+		unsigned int count;
+		bool open;
+
+		// where the previous zone ended, in trace microseconds
+		double cursor;
+		uint64_t dropped;
+
+		Trace::Track* track;
+};
+
+inline GpuTrace::Zone::Zone(GpuTrace& trace, const char* name)
+	: trace{ trace }, active{ Trace::isCapturing() && trace.begin(name) }
+{ }
+
+inline GpuTrace::Zone::~Zone()
+{
+	if(active)
+		trace.end();
+}
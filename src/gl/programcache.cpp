@@ -0,0 +1,248 @@
+#include "programcache.hpp"
+#include "glutils.hpp"
+
+#include <fstream>
+#include <sstream>
+#include <cstdio>
+#include <filesystem>
+
+namespace
+{
+	// header written before the binary in every cache file
+	struct ProgramCacheHeader
+	{
+		char magic[4];
+		uint32_t version;
+		uint32_t format;
+		uint32_t length;
+		float compileTime;
+	};
+
+	const char CACHE_MAGIC[4] = { 'W', 'P', 'B', 'C' };
+	const uint32_t CACHE_VERSION = 1;
+}
+
+ProgramCache::ProgramCache(const char* directory)
+	: directory{ directory }, driverHash{ 0 }, enabled{ false }, stats{}
+{ }
+
+void ProgramCache::Init()
+{
+	// binaries are only valid for the exact driver that produced them
+	const char* driver_strings[] = {
+		reinterpret_cast<const char*>(glGetString(GL_VENDOR)),
+		reinterpret_cast<const char*>(glGetString(GL_RENDERER)),
+		reinterpret_cast<const char*>(glGetString(GL_VERSION))
+	};
+
+	driverHash = hashString("");
+	for(const char* str : driver_strings)
+		driverHash = hashString(str ? str : "", driverHash);
+
+	GLint binary_formats = 0;
+	glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &binary_formats);
+
+	std::error_code err;
+	std::filesystem::create_directories(directory, err);
+
+	enabled = binary_formats > 0 && !err;
+}
+
+void ProgramCache::createFromFile(Renderer::Shader& shader, const char* vertexPath, const char* fragmentPath,
+		const std::vector<std::string>& defines)
+{
+	create(shader, readSource(vertexPath), readSource(fragmentPath), defines);
+}
+
+void ProgramCache::create(Renderer::Shader& shader, const std::string& vertexCode, const std::string& fragmentCode,
+		const std::vector<std::string>& defines)
+{
+	std::string vertex_source = applyDefines(vertexCode, defines);
+	std::string fragment_source = applyDefines(fragmentCode, defines);
+
+	if(load(shader, vertex_source, fragment_source))
+		return;
+
+	build(shader, vertex_source, fragment_source, false);
+}
+
+bool ProgramCache::load(Renderer::Shader& shader, const std::string& vertexSource, const std::string& fragmentSource)
+{
+	auto start = std::chrono::steady_clock::now();
+
+	GLenum format;
+	std::vector<char> binary;
+	float compile_time;
+	if(!enabled || !readEntry(entryPath(vertexSource, fragmentSource), format, binary, compile_time))
+	{
+		++stats.misses;
+		return false;
+	}
+
+	// the binary goes straight into the stub, a rejected one is rebuilt into the same program
+	// and replaces the entry, since the shader can only be created once
+	createStubProgram(shader);
+	if(!installProgramBinary(shader, format, binary))
+	{
+		++stats.misses;
+		build(shader, vertexSource, fragmentSource, true);
+		return true;
+	}
+
+	double load_time = millisecondsSince(start);
+	++stats.hits;
+	stats.loadTime += load_time;
+	stats.timeSaved += compile_time - load_time;
+	return true;
+}
+
+void ProgramCache::build(Renderer::Shader& shader, const std::string& vertexSource, const std::string& fragmentSource,
+		bool stubCreated)
+{
+	// the library links without asking for a retrievable binary, so the program is built here and installed
+	auto start = std::chrono::steady_clock::now();
+	GLenum format = 0;
+	std::vector<char> binary;
+	bool built = enabled && buildProgramBinary(vertexSource, fragmentSource, format, binary);
+	if(built)
+	{
+		if(!stubCreated)
+			createStubProgram(shader);
+		built = installProgramBinary(shader, format, binary);
+	}
+
+	// a failed build goes through the library again, which throws with the compile log
+	if(!built)
+		shader.create(vertexSource.c_str(), fragmentSource.c_str(), true);
+	double build_time = millisecondsSince(start);
+
+	stats.compileTime += build_time;
+	if(built)
+		store(vertexSource, fragmentSource, format, binary, static_cast<float>(build_time));
+}
+
+void ProgramCache::store(const std::string& vertexSource, const std::string& fragmentSource,
+		GLenum format, const std::vector<char>& binary, float compileTime)
+{
+	if(!enabled || binary.empty())
+		return;
+
+	ProgramCacheHeader header;
+	memcpy(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+	header.version = CACHE_VERSION;
+	header.format = format;
+	header.length = static_cast<uint32_t>(binary.size());
+	header.compileTime = compileTime;
+
+	// write to a temporary and rename so a crash never leaves a torn entry
+	std::string path = entryPath(vertexSource, fragmentSource);
+	std::string temp_path = path + ".tmp";
+	{
+		std::ofstream file(temp_path, std::ios::binary | std::ios::trunc);
+		if(!file.is_open())
+			return;
+
+		file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		file.write(binary.data(), binary.size());
+		if(!file)
+			return;
+	}
+
+	std::error_code err;
+	std::filesystem::rename(temp_path, path, err);
+}
+
+void ProgramCache::storeAsync(ThreadPool& pool, std::string vertexSource, std::string fragmentSource,
+		GLenum format, std::vector<char> binary, float compileTime)
+{
+	// store only reads what Init set, so it is safe next to the render thread
+	writing.push_back(pool.submit([this, vertexSource = std::move(vertexSource), fragmentSource = std::move(fragmentSource),
+			format, binary = std::move(binary), compileTime]() {
+		store(vertexSource, fragmentSource, format, binary, compileTime);
+	}));
+}
+
+void ProgramCache::report(std::ostream& os) const
+{
+	os << "shader cache: " << stats.hits << " hits, " << stats.misses << " misses, "
+		<< stats.compileTime << "ms compiling, " << stats.loadTime << "ms loading, "
+		<< stats.timeSaved << "ms saved\n";
+}
+
+std::string ProgramCache::readSource(const char* path)
+{
+	std::ifstream file(path);
+	if(!file.is_open())
+		throw Renderer::FileNotFoundException(std::string("Unable to open shader file: ") + path);
+
+	std::stringstream stream;
+	stream << file.rdbuf();
+	return stream.str();
+}
+
+std::string ProgramCache::applyDefines(const std::string& source, const std::vector<std::string>& defines)
+{
+	if(defines.empty())
+		return source;
+
+	std::string define_block;
+	for(const std::string& define : defines)
+		define_block += "#define " + define + "\n";
+
+	// defines have to come after the #version directive
+	std::size_t insert_at = 0;
+	std::size_t version = source.find("#version");
+	if(version != std::string::npos)
+	{
+		std::size_t line_end = source.find('\n', version);
+		insert_at = line_end == std::string::npos ? source.size() : line_end + 1;
+	}
+
+	std::string result = source;
+	result.insert(insert_at, define_block);
+	return result;
+}
+
+std::string ProgramCache::entryPath(const std::string& vertexSource, const std::string& fragmentSource) const
+{
+	uint64_t key = hashString(vertexSource, driverHash);
+	key = hashString(fragmentSource, key);
+
+	char filename[32];
+	std::snprintf(filename, sizeof(filename), "%016llx.bin", static_cast<unsigned long long>(key));
+	return directory + "/" + filename;
+}
+
+bool ProgramCache::readEntry(const std::string& path, GLenum& format, std::vector<char>& binary, float& compileTime)
+{
+	std::ifstream file(path, std::ios::binary);
+	if(!file.is_open())
+		return false;
+
+	ProgramCacheHeader header;
+	if(!file.read(reinterpret_cast<char*>(&header), sizeof(header)))
+		return false;
+
+	if(memcmp(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) != 0 || header.version != CACHE_VERSION)
+		return false;
+
+	// a torn or corrupt entry must not size the allocation, the binary has to fill the rest of the file
+	std::error_code err;
+	uintmax_t file_size = std::filesystem::file_size(path, err);
+	if(err || file_size != sizeof(header) + static_cast<uintmax_t>(header.length))
+		return false;
+
+	binary.resize(header.length);
+	if(!file.read(binary.data(), header.length))
+		return false;
+
+	format = header.format;
+	compileTime = header.compileTime;
+	return true;
+}
+
+ProgramCache::~ProgramCache()
+{
+	for(std::future<void>& write : writing)
+		write.wait();
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <renderer/Renderer.hpp>
+
+#include <future>
+#include <string>
+#include <vector>
+#include <ostream>
+
+#include "../utils.hpp"
+#include "../core/threadpool.hpp"
+
+struct ProgramCacheStats
+{
+	unsigned int hits;
+	unsigned int misses;
+
+	// milliseconds spent compiling on a miss or loading on a hit
+	double compileTime;
+	double loadTime;
+	// compile time recorded with each hit's binary minus the time to load it
+	double timeSaved;
+};
+
+/*
+ * stores linked program binaries on disk keyed by the shader sources,
+ * defines and driver strings so later launches skip compiling and linking
+ */
+class ProgramCache
+{
+	public:
+		ProgramCache(const char* directory = "./cache/shaders");
+		~ProgramCache();
+
+		void Init();
+
+		// drop in replacement for Renderer::Shader::createFromFile
+		void createFromFile(Renderer::Shader& shader, const char* vertexPath, const char* fragmentPath,
+				const std::vector<std::string>& defines = {});
+		void create(Renderer::Shader& shader, const std::string& vertexCode, const std::string& fragmentCode,
+				const std::vector<std::string>& defines = {});
+
+		// sources are expected to already have their defines applied. false on a miss, an entry
+		// the driver rejects is rebuilt from the sources, so true means the shader is usable
+		bool load(Renderer::Shader& shader, const std::string& vertexSource, const std::string& fragmentSource);
+		void store(const std::string& vertexSource, const std::string& fragmentSource,
+				GLenum format, const std::vector<char>& binary, float compileTime);
+		// the same write on the pool, for binaries that arrive during a frame. the cache outlives the write
+		void storeAsync(ThreadPool& pool, std::string vertexSource, std::string fragmentSource,
+				GLenum format, std::vector<char> binary, float compileTime);
+
+		const ProgramCacheStats& getStats() const { return stats; };
+		void report(std::ostream& os) const;
+
+		static std::string readSource(const char* path);
+		static std::string applyDefines(const std::string& source, const std::vector<std::string>& defines);
+
+	private:
+		std::string directory;
+		uint64_t driverHash;
+		bool enabled;
+
+		ProgramCacheStats stats;
+
+		// writes handed to the pool, waited on before the cache goes
+		std::vector<std::future<void>> writing;
+
+		std::string entryPath(const std::string& vertexSource, const std::string& fragmentSource) const;
+		// compiles into the shader's stub program and refreshes the entry, throws with the compile log
+		void build(Renderer::Shader& shader, const std::string& vertexSource, const std::string& fragmentSource,
+				bool stubCreated);
+		bool readEntry(const std::string& path, GLenum& format, std::vector<char>& binary, float& compileTime);
+};
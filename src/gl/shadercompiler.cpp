@@ -0,0 +1,284 @@
+#include "shadercompiler.hpp"
+#include "glutils.hpp"
+
+#include <algorithm>
+
+// GL_KHR_parallel_shader_compile is not part of the generated loader
+#define GL_MAX_SHADER_COMPILER_THREADS_KHR 0x91B0
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+typedef void (APIENTRYP PFNGLMAXSHADERCOMPILERTHREADSKHRPROC)(GLuint count);
+
+ShaderCompiler::ShaderCompiler()
+	: window{ nullptr }, parallelCompile{ false }, binarySupported{ false }, workerContext{ nullptr },
+	stopWorker{ false }, stats{}
+{ }
+
+void ShaderCompiler::Init(Renderer::Window* windowPtr)
+{
+	window = windowPtr;
+
+	GLint binary_formats = 0;
+	glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &binary_formats);
+	binarySupported = binary_formats > 0;
+
+	if(hasExtension("GL_KHR_parallel_shader_compile"))
+	{
+		auto max_threads = reinterpret_cast<PFNGLMAXSHADERCOMPILERTHREADSKHRPROC>(
+				glfwGetProcAddress("glMaxShaderCompilerThreadsKHR"));
+		if(max_threads)
+		{
+			// let the driver pick how many threads to use
+			max_threads(0xFFFFFFFF);
+			parallelCompile = true;
+			return;
+		}
+	}
+
+	// without binaries a worker cannot hand its program back, so compile on install instead
+	if(!binarySupported)
+		return;
+
+	// hidden window whose context shares objects with the main one
+	glfwDefaultWindowHints();
+	glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 1);
+	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+	glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GLFW_TRUE);
+	workerContext = glfwCreateWindow(1, 1, "shader compiler", nullptr, window->getWindow());
+	glfwDefaultWindowHints();
+
+	if(workerContext)
+		worker = std::thread(&ShaderCompiler::workerLoop, this);
+}
+
+std::shared_ptr<AsyncProgram> ShaderCompiler::submit(const std::string& vertexSource, const std::string& fragmentSource)
+{
+	std::shared_ptr<AsyncProgram> program = std::make_shared<AsyncProgram>();
+	program->vertexSource = vertexSource;
+	program->fragmentSource = fragmentSource;
+	program->submitTime = std::chrono::steady_clock::now();
+
+	if(parallelCompile)
+		startCompile(*program);
+	else if(workerContext)
+	{
+		std::lock_guard<std::mutex> lock(queueMutex);
+		queue.push_back(program);
+		queueCondition.notify_one();
+	}
+	else
+	{
+		// nothing to compile on, the sources are compiled when the program is installed
+		program->compileLatency = 0;
+		program->status = ProgramStatus::READY;
+	}
+
+	inFlight.push_back(program);
+	return program;
+}
+
+void ShaderCompiler::poll()
+{
+	auto start = std::chrono::steady_clock::now();
+
+	for(auto it = inFlight.begin(); it != inFlight.end();)
+	{
+		AsyncProgram& program = **it;
+
+		if(parallelCompile && !program.isDone())
+		{
+			GLint completed = GL_FALSE;
+			glGetProgramiv(program.program, GL_COMPLETION_STATUS_KHR, &completed);
+			if(completed == GL_TRUE)
+				finishCompile(program);
+		}
+
+		if(!program.isDone())
+		{
+			++it;
+			continue;
+		}
+
+		if(program.status == ProgramStatus::READY)
+			++stats.compiled;
+		else
+			++stats.failed;
+		stats.maxCompileLatency = std::max(stats.maxCompileLatency, program.compileLatency);
+
+		it = inFlight.erase(it);
+	}
+
+	stats.maxMainThreadStall = std::max(stats.maxMainThreadStall, millisecondsSince(start));
+}
+
+bool ShaderCompiler::install(AsyncProgram& program, Renderer::Shader& shader)
+{
+	auto start = std::chrono::steady_clock::now();
+
+	// poll already counted a failed compile
+	if(program.status == ProgramStatus::FAILED)
+	{
+		lastError = program.errorLog;
+		return false;
+	}
+
+	bool installed = true;
+	if(program.binary.empty() || !binarySupported)
+	{
+		try
+		{
+			shader.create(program.vertexSource.c_str(), program.fragmentSource.c_str(), true);
+		}
+		catch(const Renderer::ShaderCompilationException& e)
+		{
+			lastError = e.what();
+			installed = false;
+		}
+	}
+	else
+	{
+		createStubProgram(shader);
+		if(!installProgramBinary(shader, program.format, program.binary))
+		{
+			lastError = "Driver rejected the compiled program binary!";
+			installed = false;
+		}
+	}
+
+	if(!installed)
+		++stats.rejected;
+
+	stats.maxMainThreadStall = std::max(stats.maxMainThreadStall, millisecondsSince(start));
+	return installed;
+}
+
+void ShaderCompiler::report(std::ostream& os) const
+{
+	os << "shader compiler (" << (parallelCompile ? "parallel" : (workerContext ? "worker" : "blocking")) << "): "
+		<< stats.compiled << " compiled, " << stats.failed << " failed, " << stats.rejected << " rejected, "
+		<< stats.maxCompileLatency << "ms max latency, "
+		<< stats.maxMainThreadStall << "ms max main thread stall\n";
+
+	if(!lastError.empty())
+		os << "last shader error: " << lastError << "\n";
+}
+
+void ShaderCompiler::workerLoop()
+{
+	glfwMakeContextCurrent(workerContext);
+
+	while(true)
+	{
+		std::shared_ptr<AsyncProgram> program;
+		{
+			std::unique_lock<std::mutex> lock(queueMutex);
+			queueCondition.wait(lock, [this] { return stopWorker || !queue.empty(); });
+			if(stopWorker)
+				break;
+
+			program = queue.front();
+			queue.pop_front();
+		}
+
+		compileBlocking(*program);
+	}
+
+	glfwMakeContextCurrent(nullptr);
+}
+
+void ShaderCompiler::compileBlocking(AsyncProgram& program)
+{
+	startCompile(program);
+	finishCompile(program);
+}
+
+void ShaderCompiler::startCompile(AsyncProgram& program)
+{
+	// queue up the whole build without querying anything, a status query waits for the compile
+	const char* sources[2] = { program.vertexSource.c_str(), program.fragmentSource.c_str() };
+	GLenum types[2] = { GL_VERTEX_SHADER, GL_FRAGMENT_SHADER };
+
+	program.program = glCreateProgram();
+	for(int i=0;i<2;++i)
+	{
+		program.shaders[i] = glCreateShader(types[i]);
+		glShaderSource(program.shaders[i], 1, &sources[i], nullptr);
+		glCompileShader(program.shaders[i]);
+		glAttachShader(program.program, program.shaders[i]);
+	}
+
+	glProgramParameteri(program.program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+	glLinkProgram(program.program);
+}
+
+void ShaderCompiler::finishCompile(AsyncProgram& program)
+{
+	GLint linked = GL_FALSE;
+	glGetProgramiv(program.program, GL_LINK_STATUS, &linked);
+
+	if(linked == GL_TRUE)
+		retrieveBinary(program);
+	else
+		program.errorLog = programLog(program.program, program.shaders[0], program.shaders[1]);
+
+	for(GLuint shader : program.shaders)
+	{
+		glDetachShader(program.program, shader);
+		glDeleteShader(shader);
+	}
+	glDeleteProgram(program.program);
+	program.program = 0;
+
+	program.compileLatency = millisecondsSince(program.submitTime);
+	program.status = linked == GL_TRUE ? ProgramStatus::READY : ProgramStatus::FAILED;
+}
+
+void ShaderCompiler::retrieveBinary(AsyncProgram& program)
+{
+	GLint length = 0;
+	glGetProgramiv(program.program, GL_PROGRAM_BINARY_LENGTH, &length);
+	if(length <= 0)
+		return;
+
+	program.binary.resize(length);
+	glGetProgramBinary(program.program, length, &length, &program.format, program.binary.data());
+	program.binary.resize(length);
+}
+
+std::string ShaderCompiler::programLog(GLuint program, GLuint vertex, GLuint fragment)
+{
+	std::string log;
+	char buffer[1024];
+
+	for(GLuint shader : { vertex, fragment })
+	{
+		GLint compiled = GL_FALSE;
+		glGetShaderiv(shader, GL_COMPILE_STATUS, &compiled);
+		if(compiled == GL_TRUE)
+			continue;
+
+		glGetShaderInfoLog(shader, sizeof(buffer), nullptr, buffer);
+		log += buffer;
+	}
+
+	glGetProgramInfoLog(program, sizeof(buffer), nullptr, buffer);
+	log += buffer;
+	return log;
+}
+
+ShaderCompiler::~ShaderCompiler()
+{
+	if(worker.joinable())
+	{
+		{
+			std::lock_guard<std::mutex> lock(queueMutex);
+			stopWorker = true;
+		}
+		queueCondition.notify_one();
+		worker.join();
+	}
+
+	if(workerContext)
+		glfwDestroyWindow(workerContext);
+}
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <renderer/Renderer.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+enum class ProgramStatus
+{
+	PENDING, READY, FAILED
+};
+
+// a program compiled off the main thread, handed back as a program binary
+struct AsyncProgram
+{
+	std::string vertexSource;
+	std::string fragmentSource;
+
+	std::atomic<ProgramStatus> status;
+	std::string errorLog;
+
+	GLenum format;
+	std::vector<char> binary;
+
+	// only used by the parallel shader compile path
+	GLuint program;
+	GLuint shaders[2];
+
+	std::chrono::steady_clock::time_point submitTime;
+	// milliseconds between submitting and the binary becoming available
+	double compileLatency;
+
+	AsyncProgram() : status{ ProgramStatus::PENDING }, format{ 0 }, program{ 0 }, shaders{ 0, 0 }, compileLatency{ 0 } {};
+
+	bool isDone() const { return status != ProgramStatus::PENDING; };
+};
+
+struct ShaderCompilerStats
+{
+	unsigned int compiled;
+	unsigned int failed;
+	// programs that compiled but could not be installed, a rejected binary or a failed blocking build
+	unsigned int rejected;
+
+	double maxCompileLatency;
+	// longest time poll() or install() held the main thread
+	double maxMainThreadStall;
+};
+
+/*
+ * compiles programs without blocking the frame, through GL_KHR_parallel_shader_compile
+ * when the driver has it or a worker thread on a hidden shared context otherwise
+ */
+class ShaderCompiler
+{
+	public:
+		ShaderCompiler();
+		~ShaderCompiler();
+
+		void Init(Renderer::Window* windowPtr);
+
+		std::shared_ptr<AsyncProgram> submit(const std::string& vertexSource, const std::string& fragmentSource);
+
+		// call once per frame on the main thread
+		void poll();
+
+		// loads a finished program into a shader that has not been created yet. runs during the frame,
+		// so a failure is recorded for report and false returned, the caller keeps its fallback
+		bool install(AsyncProgram& program, Renderer::Shader& shader);
+
+		bool usesParallelCompile() const { return parallelCompile; };
+		const ShaderCompilerStats& getStats() const { return stats; };
+		const std::string& getLastError() const { return lastError; };
+		void report(std::ostream& os) const;
+
+	private:
+		Renderer::Window* window;
+
+		bool parallelCompile;
+		bool binarySupported;
+
+		// submitted programs that poll() has not seen finish yet
+		std::list<std::shared_ptr<AsyncProgram>> inFlight;
+
+		// worker thread fallback
+		GLFWwindow* workerContext;
+		std::thread worker;
+		std::mutex queueMutex;
+		std::condition_variable queueCondition;
+		std::deque<std::shared_ptr<AsyncProgram>> queue;
+		bool stopWorker;
+
+		ShaderCompilerStats stats;
+		std::string lastError;
+
+		void workerLoop();
+		void compileBlocking(AsyncProgram& program);
+		void startCompile(AsyncProgram& program);
+		void finishCompile(AsyncProgram& program);
+
+		static void retrieveBinary(AsyncProgram& program);
+		static std::string programLog(GLuint program, GLuint vertex, GLuint fragment);
+};
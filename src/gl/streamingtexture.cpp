@@ -0,0 +1,285 @@
+#include "streamingtexture.hpp"
+#include "texturelevels.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+StreamingTexture::StreamingTexture(TextureFormat format, unsigned int maxResidentSize, unsigned int tileSize,
+		std::size_t uploadBudget, const char* cacheDirectory)
+	: format{ format }, maxResidentSize{ std::max(1u, maxResidentSize) }, tileSize{ std::max(4u, tileSize / 4 * 4) },
+	uploadBudget{ uploadBudget }, cache{ cacheDirectory }, pool{ nullptr }, texture{ 0 }, placeholder{ 0 },
+	ready{ false }, finestLevel{ 0 }, coarseLevel{ 0 }, residentLevel{ 0 }, streamingLevel{ -1 }, nextTile{ 0 },
+	requiredLod{ 0.f }, residentBytes{ 0 }
+{ }
+
+void StreamingTexture::Init()
+{
+	// a single sky coloured texel until the coarse levels arrive
+	const unsigned char placeholder_pixel[4] = { 135, 204, 235, 255 };
+	glGenTextures(1, &placeholder);
+	glBindTexture(GL_TEXTURE_2D, placeholder);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, placeholder_pixel);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+}
+
+void StreamingTexture::load(const char* imagePath, Startup& startup)
+{
+	if(opening.valid() || ready)
+		throw Renderer::TextureOperationRejected("StreamingTexture::load is meant to only be called once!");
+
+	path = imagePath;
+	pool = &startup.getPool();
+	opening = startup.async("streaming texture", [this]() { prepare(); });
+}
+
+void StreamingTexture::require(float lod)
+{
+	requiredLod = std::max(0.f, lod);
+}
+
+float StreamingTexture::coverageLod(unsigned int textureSize, float screenPixels)
+{
+	if(screenPixels <= 0.f)
+		return 0.f;
+	return std::max(0.f, std::log2(static_cast<float>(textureSize) / screenPixels));
+}
+
+void StreamingTexture::update()
+{
+	if(!ready)
+	{
+		if(!opening.valid() || opening.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+			return;
+
+		// rethrows anything the load ran into
+		opening.get();
+
+		// the coarse levels are a tile each, small enough to go up at once
+		glGenTextures(1, &texture);
+		for(unsigned int level=coarseLevel;level<tiles.getLevels();++level)
+		{
+			allocateLevel(level);
+			for(unsigned int tile=0;tile<tiles.getTileCount(level);++tile)
+				uploadTile(level, tile, tiles.getTile(level, tile));
+		}
+
+		glBindTexture(GL_TEXTURE_2D, texture);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, static_cast<GLint>(coarseLevel));
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, static_cast<GLint>(tiles.getLevels() - 1));
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+		residentLevel = coarseLevel;
+		ready = true;
+	}
+
+	if(reading.valid())
+	{
+		if(reading.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+			return;
+
+		for(const TileUpload& upload : reading.get())
+			uploadTile(upload.level, upload.tile, upload.bytes.data());
+
+		unsigned int level = static_cast<unsigned int>(streamingLevel);
+		if(nextTile < tiles.getTileCount(level))
+		{
+			readTiles();
+			return;
+		}
+
+		// the level is whole, let sampling reach it
+		residentLevel = level;
+		streamingLevel = -1;
+		glBindTexture(GL_TEXTURE_2D, texture);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, static_cast<GLint>(residentLevel));
+		return;
+	}
+
+	// one level at a time towards the lod asked for, dropping a level waits for half a level
+	// of margin so a camera sitting on the boundary does not reload it every other frame
+	unsigned int target = std::clamp(static_cast<unsigned int>(requiredLod), finestLevel, coarseLevel);
+	if(target < residentLevel)
+	{
+		streamingLevel = static_cast<int>(residentLevel) - 1;
+		nextTile = 0;
+		allocateLevel(streamingLevel);
+		readTiles();
+	}
+	else if(residentLevel < coarseLevel && requiredLod >= residentLevel + 1.5f)
+	{
+		glBindTexture(GL_TEXTURE_2D, texture);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, static_cast<GLint>(residentLevel + 1));
+		releaseLevel(residentLevel);
+		++residentLevel;
+	}
+}
+
+void StreamingTexture::bind(unsigned int slot)
+{
+	glActiveTexture(GL_TEXTURE0 + slot);
+	glBindTexture(GL_TEXTURE_2D, ready ? texture : placeholder);
+	glActiveTexture(GL_TEXTURE0);
+}
+
+void StreamingTexture::prepare()
+{
+	std::vector<char> source = TextureCache::readSource(path);
+	uint64_t source_hash = TextureCache::hashSource(source);
+
+	std::string entry = cache.entryPath(path, "tiles " + std::to_string(static_cast<uint32_t>(format)) + " " +
+			std::to_string(tileSize));
+	if(!tiles.open(entry, source_hash))
+	{
+		// only the first run decodes the whole image, later runs page in the tiles they read
+		bool written;
+		if(isFloatFormat(format))
+		{
+			std::vector<FloatImage> chain = decodeFloatMipChain(source, path);
+			std::vector<char>().swap(source);
+
+			written = TiledTexture::write(entry, source_hash, format, chain[0].width, chain[0].height,
+					static_cast<unsigned int>(chain.size()), tileSize,
+					[&](unsigned int level, unsigned int x, unsigned int y, unsigned int width, unsigned int height) {
+						const FloatImage& image = chain[level];
+						std::vector<float> texels(static_cast<std::size_t>(width) * height * 4);
+						for(unsigned int row=0;row<height;++row)
+							memcpy(texels.data() + static_cast<std::size_t>(row) * width * 4,
+									image.texels.data() + ((static_cast<std::size_t>(y) + row) * image.width + x) * 4,
+									static_cast<std::size_t>(width) * 4 * sizeof(float));
+						return encodeFloatTexture(format, texels.data(), width, height);
+					}, *pool);
+		}
+		else
+		{
+			std::vector<MipLevel> chain = decodeMipChain(source, path);
+			std::vector<char>().swap(source);
+
+			written = TiledTexture::write(entry, source_hash, format, chain[0].width, chain[0].height,
+					static_cast<unsigned int>(chain.size()), tileSize,
+					[&](unsigned int level, unsigned int x, unsigned int y, unsigned int width, unsigned int height) {
+						const MipLevel& image = chain[level];
+						std::vector<unsigned char> pixels(static_cast<std::size_t>(width) * height * 4);
+						for(unsigned int row=0;row<height;++row)
+							memcpy(pixels.data() + static_cast<std::size_t>(row) * width * 4,
+									image.pixels.data() + ((static_cast<std::size_t>(y) + row) * image.width + x) * 4,
+									static_cast<std::size_t>(width) * 4);
+						return encodeTexture(format, pixels.data(), width, height);
+					}, *pool);
+		}
+
+		if(!written || !tiles.open(entry, source_hash))
+			throw Renderer::TextureOperationRejected("Unable to write the tiled texture for " + path);
+	}
+
+	// levels that fit in one tile go up whole, nothing finer than the cap is ever streamed
+	unsigned int levels = tiles.getLevels();
+	coarseLevel = levels - 1;
+	while(coarseLevel > 0 && std::max(tiles.getLevelWidth(coarseLevel - 1), tiles.getLevelHeight(coarseLevel - 1)) <= tileSize)
+		--coarseLevel;
+
+	finestLevel = 0;
+	while(finestLevel < coarseLevel && std::max(tiles.getLevelWidth(finestLevel), tiles.getLevelHeight(finestLevel)) > maxResidentSize)
+		++finestLevel;
+}
+
+void StreamingTexture::allocateLevel(unsigned int level)
+{
+	unsigned int level_width = tiles.getLevelWidth(level);
+	unsigned int level_height = tiles.getLevelHeight(level);
+
+	glBindTexture(GL_TEXTURE_2D, texture);
+	if(isCompressedFormat(format) && textureFormatSupported(format))
+	{
+		glCompressedTexImage2D(GL_TEXTURE_2D, level, textureInternalFormat(format), level_width, level_height, 0,
+				static_cast<GLsizei>(textureLevelSize(format, level_width, level_height)), nullptr);
+	}
+	else
+	{
+		// block formats the context cannot sample are decoded tile by tile into rgba8
+		GLenum internal_format = textureFormatSupported(format) ? textureInternalFormat(format) : GL_RGBA8;
+		GLenum client_format, type;
+		textureClientFormat(format, client_format, type);
+		glTexImage2D(GL_TEXTURE_2D, level, internal_format, level_width, level_height, 0, client_format, type, nullptr);
+	}
+
+	residentBytes += storedLevelSize(level);
+}
+
+void StreamingTexture::releaseLevel(unsigned int level)
+{
+	// an empty image frees the storage, levels below the base do not affect completeness
+	glBindTexture(GL_TEXTURE_2D, texture);
+	glTexImage2D(GL_TEXTURE_2D, level, GL_RGBA8, 0, 0, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+
+	residentBytes -= storedLevelSize(level);
+}
+
+void StreamingTexture::uploadTile(unsigned int level, unsigned int tile, const unsigned char* data)
+{
+	unsigned int x, y, tile_width, tile_height;
+	tiles.getTileRect(level, tile, x, y, tile_width, tile_height);
+
+	glBindTexture(GL_TEXTURE_2D, texture);
+	if(isCompressedFormat(format) && textureFormatSupported(format))
+	{
+		glCompressedTexSubImage2D(GL_TEXTURE_2D, level, x, y, tile_width, tile_height, textureInternalFormat(format),
+				static_cast<GLsizei>(tiles.getTileBytes(level, tile)), data);
+	}
+	else if(isCompressedFormat(format))
+	{
+		std::vector<unsigned char> pixels = decodeTexture(format, data, tile_width, tile_height);
+		glTexSubImage2D(GL_TEXTURE_2D, level, x, y, tile_width, tile_height, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+	}
+	else
+	{
+		GLenum client_format, type;
+		textureClientFormat(format, client_format, type);
+		glTexSubImage2D(GL_TEXTURE_2D, level, x, y, tile_width, tile_height, client_format, type, data);
+	}
+}
+
+void StreamingTexture::readTiles()
+{
+	// tiles up to the budget, at least one so a tiny budget still makes progress
+	unsigned int level = static_cast<unsigned int>(streamingLevel);
+	unsigned int first = nextTile;
+	std::size_t bytes = 0;
+	while(nextTile < tiles.getTileCount(level) && (nextTile == first || bytes + tiles.getTileBytes(level, nextTile) <= uploadBudget))
+		bytes += tiles.getTileBytes(level, nextTile++);
+
+	// touching the mapping pages the tiles in from disk, which stays off the render thread
+	unsigned int last = nextTile;
+	reading = pool->submit([this, level, first, last]() {
+		std::vector<TileUpload> uploads;
+		for(unsigned int tile=first;tile<last;++tile)
+		{
+			const unsigned char* data = tiles.getTile(level, tile);
+			uploads.push_back({ level, tile, std::vector<unsigned char>(data, data + tiles.getTileBytes(level, tile)) });
+		}
+		return uploads;
+	});
+}
+
+std::size_t StreamingTexture::storedLevelSize(unsigned int level) const
+{
+	TextureFormat stored = textureFormatSupported(format) ? format : TextureFormat::RGBA8;
+	return textureLevelSize(stored, tiles.getLevelWidth(level), tiles.getLevelHeight(level));
+}
+
+StreamingTexture::~StreamingTexture()
+{
+	// the workers read from the mapping
+	if(opening.valid())
+		opening.wait();
+	if(reading.valid())
+		reading.wait();
+
+	if(texture)
+		glDeleteTextures(1, &texture);
+	if(placeholder)
+		glDeleteTextures(1, &placeholder);
+}
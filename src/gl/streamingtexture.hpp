@@ -0,0 +1,90 @@
+#pragma once
+
+#include <renderer/Renderer.hpp>
+
+#include <future>
+#include <string>
+#include <vector>
+
+#include "../core/startup.hpp"
+#include "tiledtexture.hpp"
+
+/*
+ * a texture too large to load whole. the coarse levels go up as soon as the tiled file
+ * is open, finer levels stream in a few tiles a frame while the lod asked for needs them
+ * and are released once it no longer does. the finest resident level is capped, so
+ * startup time and memory stay bounded whatever the resolution of the source
+ */
+class StreamingTexture
+{
+	public:
+		StreamingTexture(TextureFormat format = TextureFormat::RGBA8, unsigned int maxResidentSize = 4096,
+				unsigned int tileSize = 256, std::size_t uploadBudget = 4 << 20, const char* cacheDirectory = "./cache/tiles");
+		~StreamingTexture();
+
+		void Init();
+
+		// opens the tiled file, or cuts it from the source on the first run. needs no context
+		void load(const char* path, Startup& startup);
+
+		// the finest lod the coming frames sample, in levels of the full resolution image
+		void require(float lod);
+
+		// lod at which the texels of an image span as many as the screen pixels it covers
+		static float coverageLod(unsigned int textureSize, float screenPixels);
+
+		// call once per frame on the thread that owns the context
+		void update();
+
+		void bind(unsigned int slot = 0);
+
+		bool isReady() const { return ready; };
+		GLuint getId() const { return ready ? texture : placeholder; };
+		unsigned int getWidth() const { return tiles.getWidth(); };
+		unsigned int getHeight() const { return tiles.getHeight(); };
+
+		unsigned int getResidentLevel() const { return residentLevel; };
+		std::size_t getResidentBytes() const { return residentBytes; };
+
+	private:
+		struct TileUpload
+		{
+			unsigned int level;
+			unsigned int tile;
+			std::vector<unsigned char> bytes;
+		};
+
+		std::string path;
+		TextureFormat format;
+		unsigned int maxResidentSize;
+		unsigned int tileSize;
+		std::size_t uploadBudget;
+
+		TextureCache cache;
+		TiledTexture tiles;
+		ThreadPool* pool;
+		std::future<void> opening;
+
+		// the next tiles of the streaming level, copied out of the file on the pool
+		std::future<std::vector<TileUpload>> reading;
+
+		GLuint texture;
+		GLuint placeholder;
+		bool ready;
+
+		// levels from residentLevel down are whole on the gpu, coarseLevel and below never leave it
+		unsigned int finestLevel;
+		unsigned int coarseLevel;
+		unsigned int residentLevel;
+		int streamingLevel;
+		unsigned int nextTile;
+		float requiredLod;
+		std::size_t residentBytes;
+
+		void prepare();
+		void allocateLevel(unsigned int level);
+		void releaseLevel(unsigned int level);
+		void uploadTile(unsigned int level, unsigned int tile, const unsigned char* data);
+		void readTiles();
+		std::size_t storedLevelSize(unsigned int level) const;
+};
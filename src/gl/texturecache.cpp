@@ -0,0 +1,762 @@
+#include "texturecache.hpp"
+#include "glutils.hpp"
+#include "vertexformat.hpp"
+#include "../utils.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+
+#if defined(_WIN32)
+#include <cstdlib>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+	// header written before the levels in every cache file, padded to 8 bytes
+	struct TextureCacheHeader
+	{
+		char magic[4];
+		uint32_t version;
+		uint64_t sourceHash;
+		uint32_t format;
+		uint32_t width;
+		uint32_t height;
+		uint32_t levels;
+		uint32_t faces;
+		uint32_t reserved;
+	};
+
+	const char CACHE_MAGIC[4] = { 'W', 'T', 'E', 'X' };
+	const uint32_t CACHE_VERSION = 1;
+
+	unsigned int levelDimension(unsigned int size, unsigned int level)
+	{
+		return std::max(1u, size >> level);
+	}
+
+	// copies a 4x4 block, repeating the last row and column past the edge
+	void fetchBlock(const unsigned char* rgba, unsigned int width, unsigned int height,
+			unsigned int blockX, unsigned int blockY, unsigned char block[16][4])
+	{
+		for(unsigned int y=0;y<4;++y)
+		{
+			unsigned int py = std::min(blockY * 4 + y, height - 1);
+			for(unsigned int x=0;x<4;++x)
+			{
+				unsigned int px = std::min(blockX * 4 + x, width - 1);
+				memcpy(block[y * 4 + x], rgba + (static_cast<std::size_t>(py) * width + px) * 4, 4);
+			}
+		}
+	}
+
+	uint16_t packColor565(const int color[3])
+	{
+		int r = (color[0] * 31 + 127) / 255;
+		int g = (color[1] * 63 + 127) / 255;
+		int b = (color[2] * 31 + 127) / 255;
+		return static_cast<uint16_t>((r << 11) | (g << 5) | b);
+	}
+
+	void unpackColor565(uint16_t packed, int color[3])
+	{
+		int r = (packed >> 11) & 31;
+		int g = (packed >> 5) & 63;
+		int b = packed & 31;
+		color[0] = (r << 3) | (r >> 2);
+		color[1] = (g << 2) | (g >> 4);
+		color[2] = (b << 3) | (b >> 2);
+	}
+
+	// endpoints at the extremes of the block along its principal axis, then the nearest of 4 colours
+	void encodeColorBlock(const unsigned char block[16][4], unsigned char* out)
+	{
+		float mean[3] = { 0.f, 0.f, 0.f };
+		for(int i=0;i<16;++i)
+			for(int c=0;c<3;++c)
+				mean[c] += block[i][c] / 16.f;
+
+		float covariance[6] = { 0.f, 0.f, 0.f, 0.f, 0.f, 0.f };
+		for(int i=0;i<16;++i)
+		{
+			float r = block[i][0] - mean[0];
+			float g = block[i][1] - mean[1];
+			float b = block[i][2] - mean[2];
+			covariance[0] += r * r;
+			covariance[1] += r * g;
+			covariance[2] += r * b;
+			covariance[3] += g * g;
+			covariance[4] += g * b;
+			covariance[5] += b * b;
+		}
+
+		// a few rounds of power iteration find the axis well enough
+		float axis[3] = { 1.f, 1.f, 1.f };
+		for(int round=0;round<4;++round)
+		{
+			float x = covariance[0] * axis[0] + covariance[1] * axis[1] + covariance[2] * axis[2];
+			float y = covariance[1] * axis[0] + covariance[3] * axis[1] + covariance[4] * axis[2];
+			float z = covariance[2] * axis[0] + covariance[4] * axis[1] + covariance[5] * axis[2];
+			float length = std::max(std::max(std::fabs(x), std::fabs(y)), std::fabs(z));
+			if(length <= 0.f)
+				break;
+			axis[0] = x / length;
+			axis[1] = y / length;
+			axis[2] = z / length;
+		}
+
+		int low = 0;
+		int high = 0;
+		float low_dot = 1e30f;
+		float high_dot = -1e30f;
+		for(int i=0;i<16;++i)
+		{
+			float dot = block[i][0] * axis[0] + block[i][1] * axis[1] + block[i][2] * axis[2];
+			if(dot < low_dot) { low_dot = dot; low = i; }
+			if(dot > high_dot) { high_dot = dot; high = i; }
+		}
+
+		int high_color[3] = { block[high][0], block[high][1], block[high][2] };
+		int low_color[3] = { block[low][0], block[low][1], block[low][2] };
+		uint16_t color0 = packColor565(high_color);
+		uint16_t color1 = packColor565(low_color);
+
+		// color0 above color1 selects the four colour mode
+		if(color0 < color1)
+			std::swap(color0, color1);
+
+		uint32_t indices = 0;
+		if(color0 != color1)
+		{
+			int palette[4][3];
+			unpackColor565(color0, palette[0]);
+			unpackColor565(color1, palette[1]);
+			for(int c=0;c<3;++c)
+			{
+				palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+				palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+			}
+
+			for(int i=0;i<16;++i)
+			{
+				int best = 0;
+				int best_distance = 1 << 30;
+				for(int p=0;p<4;++p)
+				{
+					int dr = block[i][0] - palette[p][0];
+					int dg = block[i][1] - palette[p][1];
+					int db = block[i][2] - palette[p][2];
+					int distance = dr * dr + dg * dg + db * db;
+					if(distance < best_distance)
+					{
+						best_distance = distance;
+						best = p;
+					}
+				}
+				indices |= static_cast<uint32_t>(best) << (i * 2);
+			}
+		}
+
+		out[0] = color0 & 0xFF;
+		out[1] = color0 >> 8;
+		out[2] = color1 & 0xFF;
+		out[3] = color1 >> 8;
+		for(int i=0;i<4;++i)
+			out[4 + i] = (indices >> (i * 8)) & 0xFF;
+	}
+
+	void encodeAlphaBlock(const unsigned char block[16][4], unsigned char* out)
+	{
+		int alpha0 = 0;
+		int alpha1 = 255;
+		for(int i=0;i<16;++i)
+		{
+			alpha0 = std::max<int>(alpha0, block[i][3]);
+			alpha1 = std::min<int>(alpha1, block[i][3]);
+		}
+
+		uint64_t indices = 0;
+		if(alpha0 != alpha1)
+		{
+			// alpha0 above alpha1 selects 6 interpolated values
+			int palette[8] = { alpha0, alpha1 };
+			for(int p=1;p<7;++p)
+				palette[p + 1] = ((7 - p) * alpha0 + p * alpha1) / 7;
+
+			for(int i=0;i<16;++i)
+			{
+				int best = 0;
+				int best_distance = 256;
+				for(int p=0;p<8;++p)
+				{
+					int distance = std::abs(block[i][3] - palette[p]);
+					if(distance < best_distance)
+					{
+						best_distance = distance;
+						best = p;
+					}
+				}
+				indices |= static_cast<uint64_t>(best) << (i * 3);
+			}
+		}
+
+		out[0] = static_cast<unsigned char>(alpha0);
+		out[1] = static_cast<unsigned char>(alpha1);
+		for(int i=0;i<6;++i)
+			out[2 + i] = (indices >> (i * 8)) & 0xFF;
+	}
+
+	void decodeColorBlock(const unsigned char* in, unsigned char block[16][4])
+	{
+		uint16_t color0 = in[0] | (in[1] << 8);
+		uint16_t color1 = in[2] | (in[3] << 8);
+		uint32_t indices = in[4] | (in[5] << 8) | (in[6] << 16) | (static_cast<uint32_t>(in[7]) << 24);
+
+		int palette[4][4];
+		unpackColor565(color0, palette[0]);
+		unpackColor565(color1, palette[1]);
+		palette[0][3] = palette[1][3] = palette[2][3] = palette[3][3] = 255;
+		for(int c=0;c<3;++c)
+		{
+			if(color0 > color1)
+			{
+				palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+				palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+			}
+			else
+			{
+				palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+				palette[3][c] = 0;
+			}
+		}
+
+		for(int i=0;i<16;++i)
+			for(int c=0;c<4;++c)
+				block[i][c] = static_cast<unsigned char>(palette[(indices >> (i * 2)) & 3][c]);
+	}
+
+	void decodeAlphaBlock(const unsigned char* in, unsigned char block[16][4])
+	{
+		int alpha0 = in[0];
+		int alpha1 = in[1];
+		uint64_t indices = 0;
+		for(int i=0;i<6;++i)
+			indices |= static_cast<uint64_t>(in[2 + i]) << (i * 8);
+
+		int palette[8] = { alpha0, alpha1 };
+		for(int p=1;p<7;++p)
+		{
+			if(alpha0 > alpha1)
+				palette[p + 1] = ((7 - p) * alpha0 + p * alpha1) / 7;
+			else if(p < 5)
+				palette[p + 1] = ((5 - p) * alpha0 + p * alpha1) / 5;
+			else
+				palette[p + 1] = p == 5 ? 0 : 255;
+		}
+
+		for(int i=0;i<16;++i)
+			block[i][3] = static_cast<unsigned char>(palette[(indices >> (i * 3)) & 7]);
+	}
+
+	unsigned char toUnorm8(float value)
+	{
+		return static_cast<unsigned char>(std::clamp(value, 0.f, 1.f) * 255.f + 0.5f);
+	}
+}
+
+std::size_t textureLevelSize(TextureFormat format, unsigned int width, unsigned int height)
+{
+	std::size_t blocks = static_cast<std::size_t>((width + 3) / 4) * ((height + 3) / 4);
+	switch(format)
+	{
+		case TextureFormat::BC1: return blocks * 8;
+		case TextureFormat::BC3: return blocks * 16;
+		case TextureFormat::RGBA16F: return static_cast<std::size_t>(width) * height * 8;
+		default: return static_cast<std::size_t>(width) * height * 4;
+	}
+}
+
+unsigned int textureRowHeight(TextureFormat format)
+{
+	return isCompressedFormat(format) ? 4 : 1;
+}
+
+bool isCompressedFormat(TextureFormat format)
+{
+	return format == TextureFormat::BC1 || format == TextureFormat::BC3;
+}
+
+bool isFloatFormat(TextureFormat format)
+{
+	return format == TextureFormat::RGBA16F || format == TextureFormat::RGB9E5;
+}
+
+bool textureFormatSupported(TextureFormat format)
+{
+	// the float formats are core since gl 3.0
+	if(!isCompressedFormat(format))
+		return true;
+
+	static const bool s3tc = hasExtension("GL_EXT_texture_compression_s3tc");
+	return s3tc;
+}
+
+GLenum textureInternalFormat(TextureFormat format)
+{
+	switch(format)
+	{
+		case TextureFormat::BC1: return GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+		case TextureFormat::BC3: return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+		case TextureFormat::RGBA16F: return GL_RGBA16F;
+		case TextureFormat::RGB9E5: return GL_RGB9_E5;
+		default: return GL_RGBA8;
+	}
+}
+
+void textureClientFormat(TextureFormat format, GLenum& clientFormat, GLenum& type)
+{
+	switch(format)
+	{
+		case TextureFormat::RGBA16F:
+			clientFormat = GL_RGBA;
+			type = GL_HALF_FLOAT;
+			break;
+		case TextureFormat::RGB9E5:
+			clientFormat = GL_RGB;
+			type = GL_UNSIGNED_INT_5_9_9_9_REV;
+			break;
+		default:
+			clientFormat = GL_RGBA;
+			type = GL_UNSIGNED_BYTE;
+			break;
+	}
+}
+
+std::vector<unsigned char> encodeTexture(TextureFormat format, const unsigned char* rgba,
+		unsigned int width, unsigned int height)
+{
+	if(format == TextureFormat::RGBA8)
+		return std::vector<unsigned char>(rgba, rgba + static_cast<std::size_t>(width) * height * 4);
+
+	std::vector<unsigned char> result(textureLevelSize(format, width, height));
+	unsigned char* out = result.data();
+
+	unsigned char block[16][4];
+	for(unsigned int by=0;by<(height + 3) / 4;++by)
+	{
+		for(unsigned int bx=0;bx<(width + 3) / 4;++bx)
+		{
+			fetchBlock(rgba, width, height, bx, by, block);
+			if(format == TextureFormat::BC3)
+			{
+				encodeAlphaBlock(block, out);
+				out += 8;
+			}
+			encodeColorBlock(block, out);
+			out += 8;
+		}
+	}
+
+	return result;
+}
+
+std::vector<unsigned char> encodeFloatTexture(TextureFormat format, const float* rgba,
+		unsigned int width, unsigned int height)
+{
+	std::size_t texels = static_cast<std::size_t>(width) * height;
+	std::vector<unsigned char> result(textureLevelSize(format, width, height));
+
+	if(format == TextureFormat::RGBA16F)
+	{
+		floatToHalfArray(rgba, reinterpret_cast<uint16_t*>(result.data()), texels * 4);
+		return result;
+	}
+
+	if(format == TextureFormat::RGB9E5)
+	{
+		for(std::size_t i=0;i<texels;++i)
+		{
+			uint32_t packed = packRgb9e5(rgba[i * 4 + 0], rgba[i * 4 + 1], rgba[i * 4 + 2]);
+			memcpy(result.data() + i * 4, &packed, 4);
+		}
+		return result;
+	}
+
+	std::vector<unsigned char> pixels(texels * 4);
+	for(std::size_t i=0;i<pixels.size();++i)
+		pixels[i] = toUnorm8(rgba[i]);
+	return encodeTexture(format, pixels.data(), width, height);
+}
+
+uint32_t packRgb9e5(float r, float g, float b)
+{
+	// the largest value the format holds, (511 / 512) * 2^16
+	const float shared_max = 65408.f;
+
+	// negatives and nan clamp to zero
+	float red = r > 0.f ? std::min(r, shared_max) : 0.f;
+	float green = g > 0.f ? std::min(g, shared_max) : 0.f;
+	float blue = b > 0.f ? std::min(b, shared_max) : 0.f;
+	float largest = std::max(std::max(red, green), blue);
+
+	// the exponent that fits the largest channel, biased by 15
+	int exponent = 0;
+	if(largest > 0.f)
+	{
+		int power;
+		std::frexp(largest, &power);
+		exponent = std::max(-16, power - 1) + 1 + 15;
+	}
+
+	// rounding the largest channel up to 512 needs the next exponent
+	if(static_cast<int>(std::floor(largest / std::ldexp(1.f, exponent - 15 - 9) + 0.5f)) == 512)
+		++exponent;
+
+	float scale = 1.f / std::ldexp(1.f, exponent - 15 - 9);
+	uint32_t red_bits = static_cast<uint32_t>(std::floor(red * scale + 0.5f));
+	uint32_t green_bits = static_cast<uint32_t>(std::floor(green * scale + 0.5f));
+	uint32_t blue_bits = static_cast<uint32_t>(std::floor(blue * scale + 0.5f));
+	return red_bits | (green_bits << 9) | (blue_bits << 18) | (static_cast<uint32_t>(exponent) << 27);
+}
+
+std::vector<FloatImage> buildFloatMipChain(FloatImage base)
+{
+	std::vector<FloatImage> chain;
+	chain.push_back(std::move(base));
+
+	while(chain.back().width > 1 || chain.back().height > 1)
+	{
+		const FloatImage& src = chain.back();
+		FloatImage dst;
+		dst.width = std::max(1u, src.width / 2);
+		dst.height = std::max(1u, src.height / 2);
+		dst.texels.resize(static_cast<std::size_t>(dst.width) * dst.height * 4);
+
+		// 2x2 box filter, clamped at the edges of odd sized levels
+		const float* texels = src.texels.data();
+		for(unsigned int y=0;y<dst.height;++y)
+		{
+			unsigned int y0 = std::min(y * 2, src.height - 1);
+			unsigned int y1 = std::min(y * 2 + 1, src.height - 1);
+			for(unsigned int x=0;x<dst.width;++x)
+			{
+				unsigned int x0 = std::min(x * 2, src.width - 1);
+				unsigned int x1 = std::min(x * 2 + 1, src.width - 1);
+				float* out = dst.texels.data() + (static_cast<std::size_t>(y) * dst.width + x) * 4;
+				for(unsigned int c=0;c<4;++c)
+					out[c] = 0.25f * (texels[(y0 * src.width + x0) * 4 + c] + texels[(y0 * src.width + x1) * 4 + c] +
+							texels[(y1 * src.width + x0) * 4 + c] + texels[(y1 * src.width + x1) * 4 + c]);
+			}
+		}
+
+		chain.push_back(std::move(dst));
+	}
+
+	return chain;
+}
+
+std::vector<unsigned char> decodeTexture(TextureFormat format, const unsigned char* data,
+		unsigned int width, unsigned int height)
+{
+	if(format == TextureFormat::RGBA8)
+		return std::vector<unsigned char>(data, data + static_cast<std::size_t>(width) * height * 4);
+
+	std::vector<unsigned char> result(static_cast<std::size_t>(width) * height * 4);
+
+	unsigned char block[16][4];
+	for(unsigned int by=0;by<(height + 3) / 4;++by)
+	{
+		for(unsigned int bx=0;bx<(width + 3) / 4;++bx)
+		{
+			if(format == TextureFormat::BC3)
+			{
+				decodeColorBlock(data + 8, block);
+				decodeAlphaBlock(data, block);
+				data += 16;
+			}
+			else
+			{
+				decodeColorBlock(data, block);
+				data += 8;
+			}
+
+			for(unsigned int y=0;y<4 && by * 4 + y<height;++y)
+				for(unsigned int x=0;x<4 && bx * 4 + x<width;++x)
+					memcpy(result.data() + ((static_cast<std::size_t>(by) * 4 + y) * width + bx * 4 + x) * 4,
+							block[y * 4 + x], 4);
+		}
+	}
+
+	return result;
+}
+
+void uploadTexture(GLenum target, TextureFormat format, unsigned int width, unsigned int height,
+		unsigned int levels, unsigned int faces, const std::vector<const unsigned char*>& images)
+{
+	bool supported = textureFormatSupported(format);
+	for(unsigned int level=0;level<levels;++level)
+	{
+		unsigned int level_width = levelDimension(width, level);
+		unsigned int level_height = levelDimension(height, level);
+		for(unsigned int face=0;face<faces;++face)
+		{
+			GLenum face_target = target == GL_TEXTURE_CUBE_MAP ? GL_TEXTURE_CUBE_MAP_POSITIVE_X + face : target;
+			const unsigned char* data = images[level * faces + face];
+
+			if(!isCompressedFormat(format))
+			{
+				GLenum client_format, type;
+				textureClientFormat(format, client_format, type);
+				glTexImage2D(face_target, level, textureInternalFormat(format), level_width, level_height, 0,
+						client_format, type, data);
+			}
+			else if(supported)
+			{
+				glCompressedTexImage2D(face_target, level, textureInternalFormat(format), level_width, level_height, 0,
+						static_cast<GLsizei>(textureLevelSize(format, level_width, level_height)), data);
+			}
+			else
+			{
+				std::vector<unsigned char> pixels = decodeTexture(format, data, level_width, level_height);
+				glTexImage2D(face_target, level, GL_RGBA8, level_width, level_height, 0, GL_RGBA, GL_UNSIGNED_BYTE,
+						pixels.data());
+			}
+		}
+	}
+
+	glTexParameteri(target, GL_TEXTURE_MAX_LEVEL, static_cast<GLint>(levels - 1));
+}
+
+MappedFile::MappedFile()
+	: mapping{ nullptr }, mappingSize{ 0 }
+{ }
+
+bool MappedFile::open(const std::string& path)
+{
+	close();
+
+#if defined(_WIN32)
+	// no mapping here, read the file into memory instead
+	std::ifstream file(path, std::ios::binary);
+	if(!file.is_open())
+		return false;
+	std::vector<char> contents((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+	if(contents.empty())
+		return false;
+	mappingSize = contents.size();
+	mapping = malloc(mappingSize);
+	memcpy(mapping, contents.data(), mappingSize);
+#else
+	int fd = ::open(path.c_str(), O_RDONLY);
+	if(fd < 0)
+		return false;
+
+	struct stat info;
+	if(fstat(fd, &info) != 0 || info.st_size <= 0)
+	{
+		::close(fd);
+		return false;
+	}
+
+	// the mapping keeps the file alive, the descriptor is not needed after this
+	void* view = mmap(nullptr, static_cast<std::size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+	::close(fd);
+	if(view == MAP_FAILED)
+		return false;
+
+	mapping = view;
+	mappingSize = static_cast<std::size_t>(info.st_size);
+#endif
+
+	return true;
+}
+
+void MappedFile::close()
+{
+	if(mapping)
+	{
+#if defined(_WIN32)
+		free(mapping);
+#else
+		munmap(mapping, mappingSize);
+#endif
+	}
+
+	mapping = nullptr;
+	mappingSize = 0;
+}
+
+MappedFile::~MappedFile()
+{
+	close();
+}
+
+MappedTexture::MappedTexture()
+	: format{ TextureFormat::RGBA8 }, width{ 0 }, height{ 0 }, levels{ 0 }, faces{ 0 }
+{ }
+
+bool MappedTexture::open(const std::string& path, uint64_t sourceHash)
+{
+	close();
+	if(!file.open(path))
+		return false;
+
+	TextureCacheHeader header;
+	if(file.getSize() < sizeof(header))
+	{
+		close();
+		return false;
+	}
+	memcpy(&header, file.getData(), sizeof(header));
+
+	if(memcmp(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) != 0 || header.version != CACHE_VERSION ||
+			header.sourceHash != sourceHash || header.format > static_cast<uint32_t>(TextureFormat::RGB9E5) ||
+			header.levels == 0 || header.faces == 0)
+	{
+		close();
+		return false;
+	}
+
+	format = static_cast<TextureFormat>(header.format);
+	width = header.width;
+	height = header.height;
+	levels = header.levels;
+	faces = header.faces;
+
+	std::size_t offset = sizeof(header);
+	for(unsigned int level=0;level<levels;++level)
+	{
+		for(unsigned int face=0;face<faces;++face)
+		{
+			offsets.push_back(offset);
+			offset += getLevelSize(level);
+		}
+	}
+
+	// a torn write leaves the file short
+	if(offset > file.getSize())
+	{
+		close();
+		return false;
+	}
+
+	return true;
+}
+
+void MappedTexture::close()
+{
+	file.close();
+	offsets.clear();
+}
+
+unsigned int MappedTexture::getLevelWidth(unsigned int level) const
+{
+	return levelDimension(width, level);
+}
+
+unsigned int MappedTexture::getLevelHeight(unsigned int level) const
+{
+	return levelDimension(height, level);
+}
+
+std::size_t MappedTexture::getLevelSize(unsigned int level) const
+{
+	return textureLevelSize(format, getLevelWidth(level), getLevelHeight(level));
+}
+
+const unsigned char* MappedTexture::getLevel(unsigned int level, unsigned int face) const
+{
+	return file.getData() + offsets[level * faces + face];
+}
+
+void MappedTexture::upload(GLenum target) const
+{
+	std::vector<const unsigned char*> images;
+	for(unsigned int level=0;level<levels;++level)
+		for(unsigned int face=0;face<faces;++face)
+			images.push_back(getLevel(level, face));
+
+	uploadTexture(target, format, width, height, levels, faces, images);
+}
+
+MappedTexture::~MappedTexture()
+{
+	close();
+}
+
+TextureCache::TextureCache(const char* directory)
+	: directory{ directory }
+{ }
+
+std::string TextureCache::entryPath(const std::string& sourcePath, const std::string& tag) const
+{
+	uint64_t key = hashString(sourcePath);
+	key = hashString(tag, key);
+
+	char filename[32];
+	std::snprintf(filename, sizeof(filename), "%016llx.tex", static_cast<unsigned long long>(key));
+	return directory + "/" + filename;
+}
+
+bool TextureCache::write(const std::string& path, uint64_t sourceHash, TextureFormat format,
+		unsigned int width, unsigned int height, unsigned int levels, unsigned int faces,
+		const std::vector<std::vector<unsigned char>>& data) const
+{
+	if(data.size() != static_cast<std::size_t>(levels) * faces)
+		return false;
+
+	std::error_code err;
+	std::filesystem::create_directories(directory, err);
+	if(err)
+		return false;
+
+	TextureCacheHeader header{};
+	memcpy(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+	header.version = CACHE_VERSION;
+	header.sourceHash = sourceHash;
+	header.format = static_cast<uint32_t>(format);
+	header.width = width;
+	header.height = height;
+	header.levels = levels;
+	header.faces = faces;
+
+	// write to a temporary and rename so a crash never leaves a torn entry,
+	// an older entry for the same source is replaced
+	std::string temp_path = path + ".tmp";
+	{
+		std::ofstream file(temp_path, std::ios::binary | std::ios::trunc);
+		if(!file.is_open())
+			return false;
+
+		file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		for(const std::vector<unsigned char>& image : data)
+			file.write(reinterpret_cast<const char*>(image.data()), image.size());
+		if(!file)
+			return false;
+	}
+
+	std::filesystem::rename(temp_path, path, err);
+	return !err;
+}
+
+uint64_t TextureCache::hashSource(const std::vector<char>& contents)
+{
+	return hashBytes(contents.data(), contents.size());
+}
+
+std::vector<char> TextureCache::readSource(const std::string& path)
+{
+	std::ifstream file(path, std::ios::binary);
+	if(!file.is_open())
+		throw Renderer::FileNotFoundException("Unable to open texture: " + path);
+
+	return std::vector<char>((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+}
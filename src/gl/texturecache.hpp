@@ -0,0 +1,157 @@
+#pragma once
+
+#include <renderer/Renderer.hpp>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// GL_EXT_texture_compression_s3tc is not part of the generated loader
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+
+enum class TextureFormat : uint32_t
+{
+	RGBA8,
+
+	// 4x4 blocks, bc1 is opaque at 8 bytes a block, bc3 adds alpha at 16
+	BC1, BC3,
+
+	// unclamped formats for hdr images, half floats or three 9 bit mantissas sharing a 5 bit exponent
+	RGBA16F, RGB9E5
+};
+
+// an rgba image with float texels, rows in the order they are stored
+struct FloatImage
+{
+	unsigned int width;
+	unsigned int height;
+	std::vector<float> texels;
+};
+
+// bytes in one level, the block formats round up to whole blocks
+std::size_t textureLevelSize(TextureFormat format, unsigned int width, unsigned int height);
+
+// pixel rows stored together, 4 for the block formats
+unsigned int textureRowHeight(TextureFormat format);
+
+bool isCompressedFormat(TextureFormat format);
+bool isFloatFormat(TextureFormat format);
+
+// whether the context samples the format directly or it has to be decoded on the cpu first
+bool textureFormatSupported(TextureFormat format);
+GLenum textureInternalFormat(TextureFormat format);
+
+// client format and type of the uncompressed formats, decoded block formats arrive as rgba8
+void textureClientFormat(TextureFormat format, GLenum& clientFormat, GLenum& type);
+
+// rgba8 pixels to the format and back, edge blocks repeat the last row and column
+std::vector<unsigned char> encodeTexture(TextureFormat format, const unsigned char* rgba,
+		unsigned int width, unsigned int height);
+std::vector<unsigned char> decodeTexture(TextureFormat format, const unsigned char* data,
+		unsigned int width, unsigned int height);
+
+// float texels to the format, the 8 bit formats clamp to [0, 1] on the way
+std::vector<unsigned char> encodeFloatTexture(TextureFormat format, const float* rgba,
+		unsigned int width, unsigned int height);
+
+uint32_t packRgb9e5(float r, float g, float b);
+
+// float levels, level 0 first, each level is half the size of the previous
+std::vector<FloatImage> buildFloatMipChain(FloatImage base);
+
+// uploads levels * faces images with the faces of a level adjacent, cube maps take 6 faces
+void uploadTexture(GLenum target, TextureFormat format, unsigned int width, unsigned int height,
+		unsigned int levels, unsigned int faces, const std::vector<const unsigned char*>& images);
+
+// a file mapped read only, read into memory where mapping is not available
+class MappedFile
+{
+	public:
+		MappedFile();
+		~MappedFile();
+
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+
+		bool open(const std::string& path);
+		void close();
+
+		bool isOpen() const { return mapping != nullptr; };
+		const unsigned char* getData() const { return static_cast<const unsigned char*>(mapping); };
+		std::size_t getSize() const { return mappingSize; };
+
+	private:
+		void* mapping;
+		std::size_t mappingSize;
+};
+
+/*
+ * a cache entry mapped read only, levels point straight into the file so
+ * uploading them needs no decode and no copy on the heap
+ */
+class MappedTexture
+{
+	public:
+		MappedTexture();
+		~MappedTexture();
+
+		MappedTexture(const MappedTexture&) = delete;
+		MappedTexture& operator=(const MappedTexture&) = delete;
+
+		// fails when the entry is missing, torn or built from another version of the source
+		bool open(const std::string& path, uint64_t sourceHash);
+		void close();
+
+		bool isOpen() const { return file.isOpen(); };
+
+		TextureFormat getFormat() const { return format; };
+		unsigned int getWidth() const { return width; };
+		unsigned int getHeight() const { return height; };
+		unsigned int getLevels() const { return levels; };
+		unsigned int getFaces() const { return faces; };
+
+		unsigned int getLevelWidth(unsigned int level) const;
+		unsigned int getLevelHeight(unsigned int level) const;
+		std::size_t getLevelSize(unsigned int level) const;
+		const unsigned char* getLevel(unsigned int level, unsigned int face = 0) const;
+
+		// uploads every level and face as they are, or decoded when the format is unsupported
+		void upload(GLenum target) const;
+
+	private:
+		MappedFile file;
+
+		TextureFormat format;
+		unsigned int width;
+		unsigned int height;
+		unsigned int levels;
+		unsigned int faces;
+
+		// byte offset of every level and face, faces of a level are adjacent
+		std::vector<std::size_t> offsets;
+};
+
+/*
+ * pre decoded textures on disk with every mip level, one entry per source and tag.
+ * entries record the hash of their source, so a changed source is rebuilt over the old entry
+ */
+class TextureCache
+{
+	public:
+		TextureCache(const char* directory = "./cache/textures");
+
+		// the tag separates entries built from the same source, such as bake settings
+		std::string entryPath(const std::string& sourcePath, const std::string& tag) const;
+
+		// data holds levels * faces images already in the format, faces of a level adjacent
+		bool write(const std::string& path, uint64_t sourceHash, TextureFormat format,
+				unsigned int width, unsigned int height, unsigned int levels, unsigned int faces,
+				const std::vector<std::vector<unsigned char>>& data) const;
+
+		static uint64_t hashSource(const std::vector<char>& contents);
+		static std::vector<char> readSource(const std::string& path);
+
+	private:
+		std::string directory;
+};
@@ -0,0 +1,154 @@
+#include "texturelevels.hpp"
+
+#include <algorithm>
+
+std::vector<MipLevel> buildMipChain(unsigned int width, unsigned int height, std::vector<unsigned char> pixels)
+{
+	std::vector<MipLevel> chain;
+	chain.push_back({ width, height, std::move(pixels) });
+
+	while(chain.back().width > 1 || chain.back().height > 1)
+	{
+		const MipLevel& src = chain.back();
+		MipLevel dst;
+		dst.width = std::max(1u, src.width / 2);
+		dst.height = std::max(1u, src.height / 2);
+		dst.pixels.resize(static_cast<std::size_t>(dst.width) * dst.height * 4);
+
+		// 2x2 box filter, clamped at the edges of odd sized levels
+		for(unsigned int y=0;y<dst.height;++y)
+		{
+			unsigned int y0 = std::min(y * 2, src.height - 1);
+			unsigned int y1 = std::min(y * 2 + 1, src.height - 1);
+			for(unsigned int x=0;x<dst.width;++x)
+			{
+				unsigned int x0 = std::min(x * 2, src.width - 1);
+				unsigned int x1 = std::min(x * 2 + 1, src.width - 1);
+				for(unsigned int c=0;c<4;++c)
+				{
+					unsigned int sum =
+						src.pixels[(y0 * src.width + x0) * 4 + c] + src.pixels[(y0 * src.width + x1) * 4 + c] +
+						src.pixels[(y1 * src.width + x0) * 4 + c] + src.pixels[(y1 * src.width + x1) * 4 + c];
+					dst.pixels[(y * dst.width + x) * 4 + c] = static_cast<unsigned char>((sum + 2) / 4);
+				}
+			}
+		}
+
+		chain.push_back(std::move(dst));
+	}
+
+	return chain;
+}
+
+std::vector<MipLevel> decodeMipChain(const std::vector<char>& source, const std::string& path)
+{
+	// the flip flag in stb_image is global, so flip here rather than race the renderer's loads
+	stbi_set_flip_vertically_on_load_thread(0);
+
+	int image_width, image_height, channels;
+	unsigned char* data = stbi_load_from_memory(reinterpret_cast<const stbi_uc*>(source.data()),
+			static_cast<int>(source.size()), &image_width, &image_height, &channels, 4);
+	if(!data)
+		throw Renderer::FileNotFoundException("Unable to load texture: " + path);
+
+	Renderer::flipColorVertically(image_width, image_height, 4, data);
+
+	std::vector<unsigned char> pixels(data, data + static_cast<std::size_t>(image_width) * image_height * 4);
+	stbi_image_free(data);
+
+	return buildMipChain(image_width, image_height, std::move(pixels));
+}
+
+std::vector<FloatImage> decodeFloatMipChain(const std::vector<char>& source, const std::string& path)
+{
+	stbi_set_flip_vertically_on_load_thread(0);
+
+	int image_width, image_height, channels;
+	float* data = stbi_loadf_from_memory(reinterpret_cast<const stbi_uc*>(source.data()),
+			static_cast<int>(source.size()), &image_width, &image_height, &channels, 4);
+	if(!data)
+		throw Renderer::FileNotFoundException("Unable to load texture: " + path);
+
+	// flipped while copying
+	FloatImage image{ static_cast<unsigned int>(image_width), static_cast<unsigned int>(image_height), {} };
+	std::size_t row_floats = static_cast<std::size_t>(image_width) * 4;
+	image.texels.resize(row_floats * image_height);
+	for(int y=0;y<image_height;++y)
+		memcpy(image.texels.data() + y * row_floats, data + (image_height - 1 - y) * row_floats, row_floats * sizeof(float));
+	stbi_image_free(data);
+
+	return buildFloatMipChain(std::move(image));
+}
+
+TextureLevels::TextureLevels()
+	: format{ TextureFormat::RGBA8 }, width{ 0 }, height{ 0 }, levels{ 0 }, loaded{ false }
+{ }
+
+void TextureLevels::load(const TextureCache& cache, const std::string& path, TextureFormat textureFormat)
+{
+	release();
+	format = textureFormat;
+
+	std::vector<char> source = TextureCache::readSource(path);
+	uint64_t source_hash = TextureCache::hashSource(source);
+
+	std::string entry = cache.entryPath(path, "texture " + std::to_string(static_cast<uint32_t>(format)));
+	if(mapped.open(entry, source_hash))
+	{
+		width = mapped.getWidth();
+		height = mapped.getHeight();
+		levels = mapped.getLevels();
+		loaded = true;
+		return;
+	}
+
+	if(isFloatFormat(format))
+	{
+		std::vector<FloatImage> chain = decodeFloatMipChain(source, path);
+		width = chain[0].width;
+		height = chain[0].height;
+		for(const FloatImage& level : chain)
+			encoded.push_back(encodeFloatTexture(format, level.texels.data(), level.width, level.height));
+	}
+	else
+	{
+		std::vector<MipLevel> chain = decodeMipChain(source, path);
+		width = chain[0].width;
+		height = chain[0].height;
+		for(MipLevel& level : chain)
+		{
+			if(format == TextureFormat::RGBA8)
+				encoded.push_back(std::move(level.pixels));
+			else
+				encoded.push_back(encodeTexture(format, level.pixels.data(), level.width, level.height));
+		}
+	}
+
+	levels = static_cast<unsigned int>(encoded.size());
+	loaded = true;
+
+	if(cache.write(entry, source_hash, format, width, height, levels, 1, encoded) && mapped.open(entry, source_hash))
+		std::vector<std::vector<unsigned char>>().swap(encoded);
+}
+
+void TextureLevels::release()
+{
+	mapped.close();
+	std::vector<std::vector<unsigned char>>().swap(encoded);
+	loaded = false;
+}
+
+unsigned int TextureLevels::getLevelWidth(unsigned int level) const
+{
+	return std::max(1u, width >> level);
+}
+
+unsigned int TextureLevels::getLevelHeight(unsigned int level) const
+{
+	return std::max(1u, height >> level);
+}
+
+const unsigned char* TextureLevels::getLevel(unsigned int level) const
+{
+	return mapped.isOpen() ? mapped.getLevel(level) : encoded[level].data();
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <renderer/Renderer.hpp>
+
+#include <string>
+#include <vector>
+
+#include "texturecache.hpp"
+
+struct MipLevel
+{
+	unsigned int width;
+	unsigned int height;
+	std::vector<unsigned char> pixels;
+};
+
+// rgba8 levels, level 0 first, each level is half the size of the previous
+std::vector<MipLevel> buildMipChain(unsigned int width, unsigned int height, std::vector<unsigned char> pixels);
+
+// decodes an image file in memory into a full chain with rows from the bottom, as gl expects.
+// the float chain keeps hdr files as they are and converts 8 bit images to linear
+std::vector<MipLevel> decodeMipChain(const std::vector<char>& source, const std::string& path);
+std::vector<FloatImage> decodeFloatMipChain(const std::vector<char>& source, const std::string& path);
+
+/*
+ * every mip level of a 2d image in a texture format, ready to upload. levels are
+ * mapped from the texture cache, or held on the heap when the entry could not be written
+ */
+class TextureLevels
+{
+	public:
+		TextureLevels();
+
+		TextureLevels(const TextureLevels&) = delete;
+		TextureLevels& operator=(const TextureLevels&) = delete;
+
+		// maps the cache entry of the image, decoding and caching it on a miss. needs no context
+		void load(const TextureCache& cache, const std::string& path, TextureFormat format);
+		void release();
+
+		bool isLoaded() const { return loaded; };
+
+		TextureFormat getFormat() const { return format; };
+		unsigned int getWidth() const { return width; };
+		unsigned int getHeight() const { return height; };
+		unsigned int getLevels() const { return levels; };
+
+		unsigned int getLevelWidth(unsigned int level) const;
+		unsigned int getLevelHeight(unsigned int level) const;
+		const unsigned char* getLevel(unsigned int level) const;
+
+	private:
+		TextureFormat format;
+		unsigned int width;
+		unsigned int height;
+		unsigned int levels;
+		bool loaded;
+
+		MappedTexture mapped;
+		std::vector<std::vector<unsigned char>> encoded;
+};
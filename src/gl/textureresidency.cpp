@@ -0,0 +1,269 @@
+#include "textureresidency.hpp"
+
+#include <algorithm>
+
+TextureResidency::TextureResidency(std::size_t budget, unsigned int minimumSize, std::size_t uploadBudget,
+		const char* cacheDirectory)
+	: pool{ nullptr }, cache{ cacheDirectory }, budget{ budget }, minimumSize{ std::max(1u, minimumSize) },
+	uploadBudget{ uploadBudget }, placeholder{ 0 }, frame{ 0 }, evictions{ 0 }, downsamples{ 0 }, reloads{ 0 }
+{ }
+
+void TextureResidency::Init(ThreadPool& threadPool)
+{
+	pool = &threadPool;
+
+	// mid grey while a texture is loading or evicted
+	const unsigned char placeholder_pixel[4] = { 128, 128, 128, 255 };
+	glGenTextures(1, &placeholder);
+	glBindTexture(GL_TEXTURE_2D, placeholder);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, placeholder_pixel);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+}
+
+TextureResidency::Handle TextureResidency::load(const std::string& path, TextureFormat format)
+{
+	if(!pool)
+		throw Renderer::TextureOperationRejected("TextureResidency::Init has to be called before loading!");
+
+	for(std::size_t i=0;i<entries.size();++i)
+		if(entries[i].path == path && entries[i].format == format)
+			return static_cast<Handle>(i);
+
+	Entry entry;
+	entry.path = path;
+	entry.format = format;
+	entry.width = 0;
+	entry.height = 0;
+	entry.levels = 0;
+	entry.texture = 0;
+	entry.baseLevel = 0;
+	entry.bytes = 0;
+	entry.lastUse = frame;
+	entry.loadingLevel = 0;
+	entries.push_back(std::move(entry));
+
+	request(entries.back(), 0);
+	return static_cast<Handle>(entries.size() - 1);
+}
+
+GLuint TextureResidency::use(Handle handle)
+{
+	Entry& entry = entries.at(handle);
+	entry.lastUse = frame;
+
+	// reload evicted textures, and downsampled ones once there is room for more of the chain
+	if(!entry.loading.valid())
+	{
+		unsigned int level = fittingLevel(entry);
+		if(!entry.texture || level < entry.baseLevel)
+		{
+			request(entry, level);
+			++reloads;
+		}
+	}
+
+	return entry.texture ? entry.texture : placeholder;
+}
+
+void TextureResidency::bind(Handle handle, unsigned int slot)
+{
+	GLuint texture = use(handle);
+	glActiveTexture(GL_TEXTURE0 + slot);
+	glBindTexture(GL_TEXTURE_2D, texture);
+	glActiveTexture(GL_TEXTURE0);
+}
+
+void TextureResidency::pin(const std::string& name, std::size_t bytes)
+{
+	pinned[name] = bytes;
+}
+
+void TextureResidency::update()
+{
+	std::size_t uploaded = 0;
+	for(Entry& entry : entries)
+	{
+		// the rest land on later frames, at least one texture goes up every frame
+		if(uploaded >= uploadBudget && uploaded > 0)
+			break;
+
+		if(!entry.loading.valid() || entry.loading.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+			continue;
+
+		// rethrows anything the load ran into, the mapping is released with the last reference
+		std::shared_ptr<TextureLevels> levels = entry.loading.get();
+		uploaded += upload(entry, *levels);
+	}
+
+	enforceBudget();
+	++frame;
+}
+
+TextureUsage TextureResidency::getUsage() const
+{
+	TextureUsage usage{};
+	usage.budget = budget;
+	usage.textures = static_cast<unsigned int>(entries.size());
+	usage.evictions = evictions;
+	usage.downsamples = downsamples;
+	usage.reloads = reloads;
+
+	for(const std::pair<const std::string, std::size_t>& texture : pinned)
+		usage.pinned += texture.second;
+
+	for(const Entry& entry : entries)
+	{
+		usage.resident += entry.bytes;
+		if(entry.texture)
+			++usage.residentTextures;
+		if(entry.texture && entry.baseLevel > 0)
+			++usage.downsampledTextures;
+		if(entry.loading.valid())
+			++usage.loadingTextures;
+	}
+
+	return usage;
+}
+
+std::vector<TextureUsageEntry> TextureResidency::getEntries() const
+{
+	std::vector<TextureUsageEntry> result;
+	for(const Entry& entry : entries)
+		result.push_back({ entry.path, entry.bytes, chainSize(entry, 0), entry.baseLevel, entry.lastUse, entry.texture != 0 });
+	return result;
+}
+
+void TextureResidency::request(Entry& entry, unsigned int baseLevel)
+{
+	entry.loadingLevel = baseLevel;
+
+	// only the mapping happens again on a reload, the decode is paid once per source
+	std::string path = entry.path;
+	TextureFormat format = entry.format;
+	entry.loading = pool->submit([this, path, format]() {
+		std::shared_ptr<TextureLevels> levels = std::make_shared<TextureLevels>();
+		levels->load(cache, path, format);
+		return levels;
+	});
+}
+
+std::size_t TextureResidency::upload(Entry& entry, const TextureLevels& levels)
+{
+	entry.width = levels.getWidth();
+	entry.height = levels.getHeight();
+	entry.levels = levels.getLevels();
+
+	unsigned int base = std::min(entry.loadingLevel, entry.levels - 1);
+	std::vector<const unsigned char*> images;
+	for(unsigned int level=base;level<entry.levels;++level)
+		images.push_back(levels.getLevel(level));
+
+	// replaces the texture at the old size, which stayed bound until now
+	if(entry.texture)
+		glDeleteTextures(1, &entry.texture);
+
+	glGenTextures(1, &entry.texture);
+	glBindTexture(GL_TEXTURE_2D, entry.texture);
+	uploadTexture(GL_TEXTURE_2D, entry.format, levels.getLevelWidth(base), levels.getLevelHeight(base),
+			static_cast<unsigned int>(images.size()), 1, images);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+
+	entry.baseLevel = base;
+	entry.bytes = chainSize(entry, base);
+	return entry.bytes;
+}
+
+void TextureResidency::evict(Entry& entry)
+{
+	glDeleteTextures(1, &entry.texture);
+	entry.texture = 0;
+	entry.baseLevel = 0;
+	entry.bytes = 0;
+}
+
+std::size_t TextureResidency::projectedUsage() const
+{
+	std::size_t usage = 0;
+	for(const std::pair<const std::string, std::size_t>& texture : pinned)
+		usage += texture.second;
+
+	for(const Entry& entry : entries)
+		usage += entry.loading.valid() ? chainSize(entry, entry.loadingLevel) : entry.bytes;
+
+	return usage;
+}
+
+unsigned int TextureResidency::fittingLevel(const Entry& entry) const
+{
+	std::size_t others = projectedUsage() - entry.bytes;
+	std::size_t available = budget > others ? budget - others : 0;
+
+	unsigned int level = 0;
+	while(level + 1 < entry.levels && chainSize(entry, level) > available &&
+			std::max(entry.width >> (level + 1), entry.height >> (level + 1)) >= minimumSize)
+		++level;
+	return level;
+}
+
+void TextureResidency::enforceBudget()
+{
+	std::size_t usage = projectedUsage();
+	while(usage > budget)
+	{
+		// the least recently used texture that was not drawn this frame and has nothing in flight
+		Entry* victim = nullptr;
+		for(Entry& entry : entries)
+		{
+			if(!entry.texture || entry.loading.valid() || entry.lastUse >= frame)
+				continue;
+			if(!victim || entry.lastUse < victim->lastUse)
+				victim = &entry;
+		}
+
+		if(!victim)
+			break;
+
+		// drop the top level while it stays above the minimum size, evict after that
+		unsigned int next = victim->baseLevel + 1;
+		if(next < victim->levels && std::max(victim->width >> next, victim->height >> next) >= minimumSize)
+		{
+			usage -= victim->bytes - chainSize(*victim, next);
+			request(*victim, next);
+			++downsamples;
+		}
+		else
+		{
+			usage -= victim->bytes;
+			evict(*victim);
+			++evictions;
+		}
+	}
+}
+
+std::size_t TextureResidency::chainSize(const Entry& entry, unsigned int baseLevel)
+{
+	TextureFormat format = textureFormatSupported(entry.format) ? entry.format : TextureFormat::RGBA8;
+
+	std::size_t size = 0;
+	for(unsigned int level=baseLevel;level<entry.levels;++level)
+		size += textureLevelSize(format, std::max(1u, entry.width >> level), std::max(1u, entry.height >> level));
+	return size;
+}
+
+TextureResidency::~TextureResidency()
+{
+	// loads in flight hold a pointer to the cache
+	for(Entry& entry : entries)
+		if(entry.loading.valid())
+			entry.loading.wait();
+
+	for(Entry& entry : entries)
+		if(entry.texture)
+			glDeleteTextures(1, &entry.texture);
+	if(placeholder)
+		glDeleteTextures(1, &placeholder);
+}
@@ -0,0 +1,130 @@
+#pragma once
+
+#include <renderer/Renderer.hpp>
+
+#include <future>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "../core/threadpool.hpp"
+#include "texturelevels.hpp"
+
+// totals for dashboards, sizes are bytes on the gpu including every mip level
+struct TextureUsage
+{
+	std::size_t budget;
+	std::size_t resident;
+	std::size_t pinned;
+
+	unsigned int textures;
+	unsigned int residentTextures;
+	unsigned int downsampledTextures;
+	unsigned int loadingTextures;
+
+	uint64_t evictions;
+	uint64_t downsamples;
+	uint64_t reloads;
+};
+
+struct TextureUsageEntry
+{
+	std::string path;
+	std::size_t bytes;
+	std::size_t fullBytes;
+
+	// levels dropped from the top of the chain
+	unsigned int baseLevel;
+	uint64_t lastUse;
+	bool resident;
+};
+
+/*
+ * keeps the managed textures inside a gpu memory budget. when over it, the least
+ * recently used textures first lose their top mip levels and are then evicted,
+ * using one again reloads it from the texture cache on the pool
+ */
+class TextureResidency
+{
+	public:
+		typedef unsigned int Handle;
+
+		TextureResidency(std::size_t budget = 256 << 20, unsigned int minimumSize = 64,
+				std::size_t uploadBudget = 8 << 20, const char* cacheDirectory = "./cache/textures");
+		~TextureResidency();
+
+		TextureResidency(const TextureResidency&) = delete;
+		TextureResidency& operator=(const TextureResidency&) = delete;
+
+		void Init(ThreadPool& pool);
+
+		// starts loading on the pool, a path already managed in the format returns its handle
+		Handle load(const std::string& path, TextureFormat format = TextureFormat::RGBA8);
+
+		// marks the texture used this frame, the placeholder stands in while it is not resident
+		GLuint use(Handle handle);
+		void bind(Handle handle, unsigned int slot = 0);
+
+		// textures owned elsewhere, counted against the budget but never evicted
+		void pin(const std::string& name, std::size_t bytes);
+
+		// call once per frame on the thread that owns the context
+		void update();
+
+		void setBudget(std::size_t bytes) { budget = bytes; };
+
+		TextureUsage getUsage() const;
+		std::vector<TextureUsageEntry> getEntries() const;
+
+	private:
+		struct Entry
+		{
+			std::string path;
+			TextureFormat format;
+
+			// size of the full chain, known once the first load lands
+			unsigned int width;
+			unsigned int height;
+			unsigned int levels;
+
+			GLuint texture;
+			unsigned int baseLevel;
+			std::size_t bytes;
+			uint64_t lastUse;
+
+			// a load in flight and the base level it was asked for
+			std::future<std::shared_ptr<TextureLevels>> loading;
+			unsigned int loadingLevel;
+		};
+
+		ThreadPool* pool;
+		TextureCache cache;
+		std::vector<Entry> entries;
+		std::map<std::string, std::size_t> pinned;
+
+		std::size_t budget;
+		unsigned int minimumSize;
+		std::size_t uploadBudget;
+
+		GLuint placeholder;
+		uint64_t frame;
+
+		uint64_t evictions;
+		uint64_t downsamples;
+		uint64_t reloads;
+
+		void request(Entry& entry, unsigned int baseLevel);
+		std::size_t upload(Entry& entry, const TextureLevels& levels);
+		void evict(Entry& entry);
+
+		// bytes once the loads in flight land, so the budget is not enforced twice for them
+		std::size_t projectedUsage() const;
+
+		// the largest base level that fits next to everything else, no smaller than the minimum size
+		unsigned int fittingLevel(const Entry& entry) const;
+		void enforceBudget();
+
+		// gpu bytes of the levels from baseLevel down, decoded block formats count as rgba8
+		static std::size_t chainSize(const Entry& entry, unsigned int baseLevel);
+};
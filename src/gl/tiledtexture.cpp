@@ -0,0 +1,189 @@
+#include "tiledtexture.hpp"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+
+namespace
+{
+	// header written before the tiles, padded to 8 bytes
+	struct TiledTextureHeader
+	{
+		char magic[4];
+		uint32_t version;
+		uint64_t sourceHash;
+		uint32_t format;
+		uint32_t width;
+		uint32_t height;
+		uint32_t levels;
+		uint32_t tileSize;
+		uint32_t reserved;
+	};
+
+	const char TILED_MAGIC[4] = { 'W', 'T', 'I', 'L' };
+	const uint32_t TILED_VERSION = 1;
+
+	unsigned int tileExtent(unsigned int size, unsigned int tileSize, unsigned int tile)
+	{
+		return std::min(tileSize, size - tile * tileSize);
+	}
+}
+
+TiledTexture::TiledTexture()
+	: format{ TextureFormat::RGBA8 }, width{ 0 }, height{ 0 }, levels{ 0 }, tileSize{ 0 }
+{ }
+
+bool TiledTexture::open(const std::string& path, uint64_t sourceHash)
+{
+	close();
+	if(!file.open(path))
+		return false;
+
+	TiledTextureHeader header;
+	if(file.getSize() < sizeof(header))
+	{
+		close();
+		return false;
+	}
+	memcpy(&header, file.getData(), sizeof(header));
+
+	if(memcmp(header.magic, TILED_MAGIC, sizeof(TILED_MAGIC)) != 0 || header.version != TILED_VERSION ||
+			header.sourceHash != sourceHash || header.format > static_cast<uint32_t>(TextureFormat::RGB9E5) ||
+			header.levels == 0 || header.tileSize == 0 || header.tileSize % 4 != 0)
+	{
+		close();
+		return false;
+	}
+
+	format = static_cast<TextureFormat>(header.format);
+	width = header.width;
+	height = header.height;
+	levels = header.levels;
+	tileSize = header.tileSize;
+
+	std::size_t offset = sizeof(header);
+	for(unsigned int level=0;level<levels;++level)
+	{
+		levelTiles.push_back(offsets.size());
+		for(unsigned int tile=0;tile<getTileCount(level);++tile)
+		{
+			offsets.push_back(offset);
+			offset += getTileBytes(level, tile);
+		}
+	}
+
+	// a torn write leaves the file short
+	if(offset > file.getSize())
+	{
+		close();
+		return false;
+	}
+
+	return true;
+}
+
+void TiledTexture::close()
+{
+	file.close();
+	levelTiles.clear();
+	offsets.clear();
+}
+
+unsigned int TiledTexture::getLevelWidth(unsigned int level) const
+{
+	return std::max(1u, width >> level);
+}
+
+unsigned int TiledTexture::getLevelHeight(unsigned int level) const
+{
+	return std::max(1u, height >> level);
+}
+
+unsigned int TiledTexture::getTilesX(unsigned int level) const
+{
+	return (getLevelWidth(level) + tileSize - 1) / tileSize;
+}
+
+unsigned int TiledTexture::getTilesY(unsigned int level) const
+{
+	return (getLevelHeight(level) + tileSize - 1) / tileSize;
+}
+
+void TiledTexture::getTileRect(unsigned int level, unsigned int tile, unsigned int& x, unsigned int& y,
+		unsigned int& tileWidth, unsigned int& tileHeight) const
+{
+	unsigned int tile_x = tile % getTilesX(level);
+	unsigned int tile_y = tile / getTilesX(level);
+	x = tile_x * tileSize;
+	y = tile_y * tileSize;
+	tileWidth = tileExtent(getLevelWidth(level), tileSize, tile_x);
+	tileHeight = tileExtent(getLevelHeight(level), tileSize, tile_y);
+}
+
+const unsigned char* TiledTexture::getTile(unsigned int level, unsigned int tile) const
+{
+	return file.getData() + offsets[levelTiles[level] + tile];
+}
+
+std::size_t TiledTexture::getTileBytes(unsigned int level, unsigned int tile) const
+{
+	unsigned int x, y, tile_width, tile_height;
+	getTileRect(level, tile, x, y, tile_width, tile_height);
+	return textureLevelSize(format, tile_width, tile_height);
+}
+
+bool TiledTexture::write(const std::string& path, uint64_t sourceHash, TextureFormat format,
+		unsigned int width, unsigned int height, unsigned int levels, unsigned int tileSize,
+		const TileEncoder& encode, ThreadPool& pool)
+{
+	std::error_code err;
+	std::filesystem::create_directories(std::filesystem::path(path).parent_path(), err);
+	if(err)
+		return false;
+
+	TiledTextureHeader header{};
+	memcpy(header.magic, TILED_MAGIC, sizeof(TILED_MAGIC));
+	header.version = TILED_VERSION;
+	header.sourceHash = sourceHash;
+	header.format = static_cast<uint32_t>(format);
+	header.width = width;
+	header.height = height;
+	header.levels = levels;
+	header.tileSize = tileSize;
+
+	// write to a temporary and rename so a crash never leaves a torn file
+	std::string temp_path = path + ".tmp";
+	{
+		std::ofstream file(temp_path, std::ios::binary | std::ios::trunc);
+		if(!file.is_open())
+			return false;
+
+		file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+		// one level of encoded tiles in memory at a time
+		for(unsigned int level=0;level<levels;++level)
+		{
+			unsigned int level_width = std::max(1u, width >> level);
+			unsigned int level_height = std::max(1u, height >> level);
+			unsigned int tiles_x = (level_width + tileSize - 1) / tileSize;
+			unsigned int tiles_y = (level_height + tileSize - 1) / tileSize;
+
+			std::vector<std::vector<unsigned char>> tiles(static_cast<std::size_t>(tiles_x) * tiles_y);
+			pool.parallelFor(tiles.size(), [&](std::size_t tile) {
+				unsigned int tile_x = static_cast<unsigned int>(tile % tiles_x);
+				unsigned int tile_y = static_cast<unsigned int>(tile / tiles_x);
+				tiles[tile] = encode(level, tile_x * tileSize, tile_y * tileSize,
+						tileExtent(level_width, tileSize, tile_x), tileExtent(level_height, tileSize, tile_y));
+			});
+
+			for(const std::vector<unsigned char>& tile : tiles)
+				file.write(reinterpret_cast<const char*>(tile.data()), tile.size());
+		}
+
+		if(!file)
+			return false;
+	}
+
+	std::filesystem::rename(temp_path, path, err);
+	return !err;
+}
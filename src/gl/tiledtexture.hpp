@@ -0,0 +1,70 @@
+#pragma once
+
+#include <renderer/Renderer.hpp>
+
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "../core/threadpool.hpp"
+#include "texturecache.hpp"
+
+/*
+ * every mip level of an image cut into square tiles on disk, each tile stored whole
+ * in the texture format. the file is mapped, so only the tiles read are paged in
+ */
+class TiledTexture
+{
+	public:
+		// the pixels of a level at x, y of the given size, already in the format
+		typedef std::function<std::vector<unsigned char>(unsigned int level, unsigned int x, unsigned int y,
+				unsigned int width, unsigned int height)> TileEncoder;
+
+		TiledTexture();
+
+		TiledTexture(const TiledTexture&) = delete;
+		TiledTexture& operator=(const TiledTexture&) = delete;
+
+		// fails when the file is missing, torn or built from another version of the source
+		bool open(const std::string& path, uint64_t sourceHash);
+		void close();
+
+		bool isOpen() const { return file.isOpen(); };
+
+		TextureFormat getFormat() const { return format; };
+		unsigned int getWidth() const { return width; };
+		unsigned int getHeight() const { return height; };
+		unsigned int getLevels() const { return levels; };
+		unsigned int getTileSize() const { return tileSize; };
+
+		unsigned int getLevelWidth(unsigned int level) const;
+		unsigned int getLevelHeight(unsigned int level) const;
+
+		// tiles go row by row, the last row and column are cut short at the edges
+		unsigned int getTilesX(unsigned int level) const;
+		unsigned int getTilesY(unsigned int level) const;
+		unsigned int getTileCount(unsigned int level) const { return getTilesX(level) * getTilesY(level); };
+		void getTileRect(unsigned int level, unsigned int tile, unsigned int& x, unsigned int& y,
+				unsigned int& tileWidth, unsigned int& tileHeight) const;
+
+		const unsigned char* getTile(unsigned int level, unsigned int tile) const;
+		std::size_t getTileBytes(unsigned int level, unsigned int tile) const;
+
+		// encodes every tile on the pool and writes them out level by level, tile size a multiple of 4
+		static bool write(const std::string& path, uint64_t sourceHash, TextureFormat format,
+				unsigned int width, unsigned int height, unsigned int levels, unsigned int tileSize,
+				const TileEncoder& encode, ThreadPool& pool);
+
+	private:
+		MappedFile file;
+
+		TextureFormat format;
+		unsigned int width;
+		unsigned int height;
+		unsigned int levels;
+		unsigned int tileSize;
+
+		// where the tiles of every level start in offsets, and the byte offset of every tile
+		std::vector<std::size_t> levelTiles;
+		std::vector<std::size_t> offsets;
+};
@@ -0,0 +1,404 @@
+#include "vertexformat.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#endif
+
+VertexLayout::VertexLayout()
+	: stride{ 0 }
+{ }
+
+void VertexLayout::add(GLuint location, VertexFormat format)
+{
+	VertexAttrib attrib = describeVertexFormat(format);
+	attrib.location = location;
+	attrib.offset = stride;
+
+	attribs.push_back(attrib);
+	stride += attrib.bytes;
+}
+
+void VertexLayout::add(GLuint location, Renderer::AttribType type)
+{
+	switch(type)
+	{
+		case Renderer::AttribType::FLOAT: add(location, VertexFormat::FLOAT1); break;
+		case Renderer::AttribType::VEC2:  add(location, VertexFormat::FLOAT2); break;
+		case Renderer::AttribType::VEC3:  add(location, VertexFormat::FLOAT3); break;
+		case Renderer::AttribType::VEC4:  add(location, VertexFormat::FLOAT4); break;
+		case Renderer::AttribType::INT:   add(location, VertexFormat::INT1); break;
+		case Renderer::AttribType::IVEC2: add(location, VertexFormat::INT2); break;
+		case Renderer::AttribType::IVEC3: add(location, VertexFormat::INT3); break;
+		case Renderer::AttribType::IVEC4: add(location, VertexFormat::INT4); break;
+		default:
+			throw Renderer::InvalidType("Unknown vertex attribute type!");
+	}
+}
+
+const VertexAttrib* VertexLayout::find(unsigned int offset) const
+{
+	for(const VertexAttrib& attrib : attribs)
+		if(attrib.offset == offset)
+			return &attrib;
+
+	return nullptr;
+}
+
+VertexAttrib describeVertexFormat(VertexFormat format)
+{
+	// components, gl type, normalized, integer, bytes
+	struct FormatInfo { GLint components; GLenum type; bool normalized; bool integer; unsigned int bytes; };
+
+	FormatInfo info;
+	switch(format)
+	{
+		case VertexFormat::FLOAT1: info = { 1, GL_FLOAT, false, false, 4 }; break;
+		case VertexFormat::FLOAT2: info = { 2, GL_FLOAT, false, false, 8 }; break;
+		case VertexFormat::FLOAT3: info = { 3, GL_FLOAT, false, false, 12 }; break;
+		case VertexFormat::FLOAT4: info = { 4, GL_FLOAT, false, false, 16 }; break;
+		case VertexFormat::INT1: info = { 1, GL_INT, false, true, 4 }; break;
+		case VertexFormat::INT2: info = { 2, GL_INT, false, true, 8 }; break;
+		case VertexFormat::INT3: info = { 3, GL_INT, false, true, 12 }; break;
+		case VertexFormat::INT4: info = { 4, GL_INT, false, true, 16 }; break;
+
+		case VertexFormat::HALF2: info = { 2, GL_HALF_FLOAT, false, false, 4 }; break;
+		case VertexFormat::HALF3: info = { 3, GL_HALF_FLOAT, false, false, 8 }; break;
+		case VertexFormat::HALF4: info = { 4, GL_HALF_FLOAT, false, false, 8 }; break;
+
+		case VertexFormat::BYTE4: info = { 4, GL_BYTE, false, false, 4 }; break;
+		case VertexFormat::BYTE4_NORM: info = { 4, GL_BYTE, true, false, 4 }; break;
+		case VertexFormat::UBYTE4: info = { 4, GL_UNSIGNED_BYTE, false, false, 4 }; break;
+		case VertexFormat::UBYTE4_NORM: info = { 4, GL_UNSIGNED_BYTE, true, false, 4 }; break;
+
+		case VertexFormat::SHORT2: info = { 2, GL_SHORT, false, false, 4 }; break;
+		case VertexFormat::SHORT3: info = { 3, GL_SHORT, false, false, 8 }; break;
+		case VertexFormat::SHORT4: info = { 4, GL_SHORT, false, false, 8 }; break;
+		case VertexFormat::SHORT2_NORM: info = { 2, GL_SHORT, true, false, 4 }; break;
+		case VertexFormat::SHORT3_NORM: info = { 3, GL_SHORT, true, false, 8 }; break;
+		case VertexFormat::SHORT4_NORM: info = { 4, GL_SHORT, true, false, 8 }; break;
+		case VertexFormat::USHORT2: info = { 2, GL_UNSIGNED_SHORT, false, false, 4 }; break;
+		case VertexFormat::USHORT4: info = { 4, GL_UNSIGNED_SHORT, false, false, 8 }; break;
+		case VertexFormat::USHORT2_NORM: info = { 2, GL_UNSIGNED_SHORT, true, false, 4 }; break;
+		case VertexFormat::USHORT4_NORM: info = { 4, GL_UNSIGNED_SHORT, true, false, 8 }; break;
+
+		case VertexFormat::INT_2_10_10_10_NORM: info = { 4, GL_INT_2_10_10_10_REV, true, false, 4 }; break;
+		case VertexFormat::UINT_2_10_10_10_NORM: info = { 4, GL_UNSIGNED_INT_2_10_10_10_REV, true, false, 4 }; break;
+		default:
+			throw Renderer::InvalidType("Unknown vertex format!");
+	}
+
+	VertexAttrib attrib;
+	attrib.location = 0;
+	attrib.format = format;
+	attrib.components = info.components;
+	attrib.type = info.type;
+	attrib.normalized = info.normalized;
+	attrib.integer = info.integer;
+	attrib.offset = 0;
+	attrib.bytes = info.bytes;
+	return attrib;
+}
+
+void packVertexAttrib(const VertexAttrib& attrib, const float* values, int count, unsigned char* out)
+{
+	// components that were not given default to 0, 0, 0, 1 like glVertexAttrib
+	float v[4] = { 0.f, 0.f, 0.f, 1.f };
+	for(int i=0;i<count && i<4;++i)
+		v[i] = values[i];
+
+	memset(out, 0, attrib.bytes);
+
+	switch(attrib.type)
+	{
+		case GL_FLOAT:
+			memcpy(out, v, attrib.components * sizeof(float));
+			break;
+		case GL_INT:
+			for(int i=0;i<attrib.components;++i)
+			{
+				int32_t value = static_cast<int32_t>(v[i]);
+				memcpy(out + i * 4, &value, 4);
+			}
+			break;
+		case GL_HALF_FLOAT:
+			for(int i=0;i<attrib.components;++i)
+			{
+				uint16_t value = floatToHalf(v[i]);
+				memcpy(out + i * 2, &value, 2);
+			}
+			break;
+		case GL_BYTE:
+			for(int i=0;i<attrib.components;++i)
+				out[i] = static_cast<unsigned char>(attrib.normalized ? packSnorm8(v[i]) :
+						static_cast<int8_t>(std::clamp(std::round(v[i]), -128.f, 127.f)));
+			break;
+		case GL_UNSIGNED_BYTE:
+			for(int i=0;i<attrib.components;++i)
+				out[i] = attrib.normalized ? packUnorm8(v[i]) :
+					static_cast<uint8_t>(std::clamp(std::round(v[i]), 0.f, 255.f));
+			break;
+		case GL_SHORT:
+			for(int i=0;i<attrib.components;++i)
+			{
+				int16_t value = attrib.normalized ? packSnorm16(v[i]) :
+					static_cast<int16_t>(std::clamp(std::round(v[i]), -32768.f, 32767.f));
+				memcpy(out + i * 2, &value, 2);
+			}
+			break;
+		case GL_UNSIGNED_SHORT:
+			for(int i=0;i<attrib.components;++i)
+			{
+				uint16_t value = attrib.normalized ? packUnorm16(v[i]) :
+					static_cast<uint16_t>(std::clamp(std::round(v[i]), 0.f, 65535.f));
+				memcpy(out + i * 2, &value, 2);
+			}
+			break;
+		case GL_INT_2_10_10_10_REV:
+		{
+			uint32_t value = packSnorm2101010(v[0], v[1], v[2], v[3]);
+			memcpy(out, &value, 4);
+			break;
+		}
+		case GL_UNSIGNED_INT_2_10_10_10_REV:
+		{
+			uint32_t value = packUnorm2101010(v[0], v[1], v[2], v[3]);
+			memcpy(out, &value, 4);
+			break;
+		}
+	}
+}
+
+uint16_t floatToHalf(float value)
+{
+	uint32_t bits;
+	memcpy(&bits, &value, sizeof(bits));
+
+	uint16_t sign = static_cast<uint16_t>((bits >> 16) & 0x8000);
+	int32_t exponent = static_cast<int32_t>((bits >> 23) & 0xFF) - 127 + 15;
+	uint32_t mantissa = bits & 0x7FFFFF;
+
+	// nan and infinity, a nan is quieted and keeps the top of its payload like the f16c conversion
+	if(((bits >> 23) & 0xFF) == 0xFF)
+		return sign | 0x7C00 | (mantissa ? 0x200 | (mantissa >> 13) : 0);
+
+	// overflow rounds to infinity
+	if(exponent >= 31)
+		return sign | 0x7C00;
+
+	// subnormal or zero
+	if(exponent <= 0)
+	{
+		if(exponent < -10)
+			return sign;
+
+		mantissa |= 0x800000;
+		uint32_t shift = static_cast<uint32_t>(14 - exponent);
+		uint32_t half_mantissa = mantissa >> shift;
+		uint32_t remainder = mantissa & ((1u << shift) - 1);
+		uint32_t halfway = 1u << (shift - 1);
+		if(remainder > halfway || (remainder == halfway && (half_mantissa & 1)))
+			++half_mantissa;
+
+		return sign | static_cast<uint16_t>(half_mantissa);
+	}
+
+	// round to nearest even, a carry out of the mantissa bumps the exponent
+	uint32_t half = (static_cast<uint32_t>(exponent) << 10) | (mantissa >> 13);
+	uint32_t remainder = mantissa & 0x1FFF;
+	if(remainder > 0x1000 || (remainder == 0x1000 && (half & 1)))
+		++half;
+
+	return sign | static_cast<uint16_t>(half);
+}
+
+float halfToFloat(uint16_t value)
+{
+	uint32_t sign = static_cast<uint32_t>(value & 0x8000) << 16;
+	uint32_t exponent = (value >> 10) & 0x1F;
+	uint32_t mantissa = value & 0x3FF;
+
+	uint32_t bits;
+	if(exponent == 0x1F)
+		bits = sign | 0x7F800000 | (mantissa << 13);
+	else if(exponent != 0)
+		bits = sign | ((exponent + 127 - 15) << 23) | (mantissa << 13);
+	else if(mantissa == 0)
+		bits = sign;
+	else
+	{
+		// renormalize the subnormal
+		exponent = 127 - 15 + 1;
+		while(!(mantissa & 0x400))
+		{
+			mantissa <<= 1;
+			--exponent;
+		}
+		bits = sign | (exponent << 23) | ((mantissa & 0x3FF) << 13);
+	}
+
+	float result;
+	memcpy(&result, &bits, sizeof(result));
+	return result;
+}
+
+namespace
+{
+#if defined(__SSE2__)
+	// four floats to halves with round to nearest even, the results sit sign extended in 32 bit lanes
+	inline __m128i floatToHalfSse2(__m128 value)
+	{
+		const __m128i half_max = _mm_set1_epi32((127 + 16) << 23);
+		const __m128i min_normal = _mm_set1_epi32((127 - 14) << 23);
+		const __m128i subnormal_magic = _mm_set1_epi32(((127 - 15) + (23 - 10) + 1) << 23);
+		const __m128i normal_bias = _mm_set1_epi32(0xFFF - ((127 - 15) << 23));
+
+		__m128 sign = _mm_and_ps(value, _mm_castsi128_ps(_mm_set1_epi32(static_cast<int>(0x80000000u))));
+		__m128 absolute = _mm_xor_ps(value, sign);
+		__m128i bits = _mm_castps_si128(absolute);
+
+		// nan and infinity, anything at or past 65520 rounds to infinity
+		__m128i is_nan = _mm_castps_si128(_mm_cmpunord_ps(absolute, absolute));
+		__m128i is_regular = _mm_cmpgt_epi32(half_max, bits);
+		__m128i payload = _mm_or_si128(_mm_and_si128(_mm_srli_epi32(bits, 13), _mm_set1_epi32(0x3FF)), _mm_set1_epi32(0x200));
+		__m128i special = _mm_or_si128(_mm_and_si128(is_nan, payload), _mm_set1_epi32(0x7C00));
+
+		// subnormal results, the float adder does the rounding against a magic exponent
+		__m128i is_subnormal = _mm_cmpgt_epi32(min_normal, bits);
+		__m128i subnormal = _mm_sub_epi32(_mm_castps_si128(_mm_add_ps(absolute, _mm_castsi128_ps(subnormal_magic))),
+				subnormal_magic);
+
+		// normal results, rebias the exponent and round the dropped mantissa bits to even
+		__m128i odd = _mm_srai_epi32(_mm_slli_epi32(bits, 31 - 13), 31);
+		__m128i normal = _mm_srli_epi32(_mm_sub_epi32(_mm_add_epi32(bits, normal_bias), odd), 13);
+
+		__m128i finite = _mm_or_si128(_mm_and_si128(is_subnormal, subnormal), _mm_andnot_si128(is_subnormal, normal));
+		__m128i joined = _mm_or_si128(_mm_and_si128(is_regular, finite), _mm_andnot_si128(is_regular, special));
+		return _mm_or_si128(joined, _mm_srai_epi32(_mm_castps_si128(sign), 16));
+	}
+#endif
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+	#define HALF_F16C_KERNEL
+
+	// the hardware conversion, compiled for f16c and only called when the cpu reports it
+	__attribute__((target("f16c"))) std::size_t floatToHalfF16c(const float* values, uint16_t* halves, std::size_t count)
+	{
+		std::size_t i = 0;
+		for(;i+8<=count;i+=8)
+		{
+			__m128i low = _mm_cvtps_ph(_mm_loadu_ps(values + i), _MM_FROUND_TO_NEAREST_INT);
+			__m128i high = _mm_cvtps_ph(_mm_loadu_ps(values + i + 4), _MM_FROUND_TO_NEAREST_INT);
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(halves + i), _mm_unpacklo_epi64(low, high));
+		}
+		return i;
+	}
+
+	bool hasF16c()
+	{
+		static const bool supported = __builtin_cpu_supports("f16c");
+		return supported;
+	}
+#endif
+}
+
+bool halfKernelSupported(HalfKernel kernel)
+{
+	switch(kernel)
+	{
+		case HalfKernel::F16C:
+#if defined(HALF_F16C_KERNEL)
+			return hasF16c();
+#else
+			return false;
+#endif
+		case HalfKernel::SSE2:
+#if defined(__SSE2__)
+			return true;
+#else
+			return false;
+#endif
+		default:
+			return true;
+	}
+}
+
+void floatToHalfArray(const float* values, uint16_t* halves, std::size_t count, HalfKernel kernel)
+{
+	std::size_t i = 0;
+
+#if defined(HALF_F16C_KERNEL)
+	if(kernel == HalfKernel::F16C)
+		i = floatToHalfF16c(values, halves, count);
+#endif
+
+#if defined(__SSE2__)
+	if(kernel == HalfKernel::SSE2)
+	{
+		for(;i+8<=count;i+=8)
+		{
+			// the sign extension keeps every half inside the signed saturation range of the pack
+			__m128i low = floatToHalfSse2(_mm_loadu_ps(values + i));
+			__m128i high = floatToHalfSse2(_mm_loadu_ps(values + i + 4));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(halves + i), _mm_packs_epi32(low, high));
+		}
+	}
+#endif
+
+	for(;i<count;++i)
+		halves[i] = floatToHalf(values[i]);
+}
+
+void floatToHalfArray(const float* values, uint16_t* halves, std::size_t count)
+{
+	static const HalfKernel fastest = halfKernelSupported(HalfKernel::F16C) ? HalfKernel::F16C :
+		halfKernelSupported(HalfKernel::SSE2) ? HalfKernel::SSE2 : HalfKernel::SCALAR;
+	floatToHalfArray(values, halves, count, fastest);
+}
+
+int8_t packSnorm8(float value)
+{
+	return static_cast<int8_t>(std::round(std::clamp(value, -1.f, 1.f) * 127.f));
+}
+
+uint8_t packUnorm8(float value)
+{
+	return static_cast<uint8_t>(std::round(std::clamp(value, 0.f, 1.f) * 255.f));
+}
+
+int16_t packSnorm16(float value)
+{
+	return static_cast<int16_t>(std::round(std::clamp(value, -1.f, 1.f) * 32767.f));
+}
+
+uint16_t packUnorm16(float value)
+{
+	return static_cast<uint16_t>(std::round(std::clamp(value, 0.f, 1.f) * 65535.f));
+}
+
+uint32_t packSnorm2101010(float x, float y, float z, float w)
+{
+	auto pack = [](float v, float scale, uint32_t mask) {
+		int32_t value = static_cast<int32_t>(std::round(std::clamp(v, -1.f, 1.f) * scale));
+		return static_cast<uint32_t>(value) & mask;
+	};
+
+	return pack(x, 511.f, 0x3FF) | (pack(y, 511.f, 0x3FF) << 10) |
+		(pack(z, 511.f, 0x3FF) << 20) | (pack(w, 1.f, 0x3) << 30);
+}
+
+uint32_t packUnorm2101010(float x, float y, float z, float w)
+{
+	auto pack = [](float v, float scale) {
+		return static_cast<uint32_t>(std::round(std::clamp(v, 0.f, 1.f) * scale));
+	};
+
+	return pack(x, 1023.f) | (pack(y, 1023.f) << 10) | (pack(z, 1023.f) << 20) | (pack(w, 3.f) << 30);
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <renderer/Renderer.hpp>
+
+#include <cstdint>
+#include <vector>
+
+// storage format of one vertex attribute, 3 component 16 bit formats are padded to 8 bytes
+enum class VertexFormat
+{
+	FLOAT1, FLOAT2, FLOAT3, FLOAT4,
+	INT1, INT2, INT3, INT4,
+
+	HALF2, HALF3, HALF4,
+
+	BYTE4, BYTE4_NORM,
+	UBYTE4, UBYTE4_NORM,
+
+	SHORT2, SHORT3, SHORT4,
+	SHORT2_NORM, SHORT3_NORM, SHORT4_NORM,
+	USHORT2, USHORT4,
+	USHORT2_NORM, USHORT4_NORM,
+
+	// 10 bits for xyz and 2 for w packed in 32 bits
+	INT_2_10_10_10_NORM, UINT_2_10_10_10_NORM
+};
+
+// one vertex attribute, laid out back to back in the order added
+struct VertexAttrib
+{
+	GLuint location;
+	VertexFormat format;
+	GLint components;
+	GLenum type;
+	bool normalized;
+	bool integer;
+	unsigned int offset;
+	unsigned int bytes;
+};
+
+class VertexLayout
+{
+	public:
+		VertexLayout();
+
+		void add(GLuint location, VertexFormat format);
+		void add(GLuint location, Renderer::AttribType type);
+
+		// attribute starting at a byte offset inside the vertex, nullptr if none does
+		const VertexAttrib* find(unsigned int offset) const;
+
+		const std::vector<VertexAttrib>& getAttribs() const { return attribs; };
+		unsigned int getStride() const { return stride; };
+
+	private:
+		std::vector<VertexAttrib> attribs;
+		unsigned int stride;
+};
+
+VertexAttrib describeVertexFormat(VertexFormat format);
+
+// packs floats into the attribute's format, writes attrib.bytes bytes to out
+void packVertexAttrib(const VertexAttrib& attrib, const float* values, int count, unsigned char* out);
+
+uint16_t floatToHalf(float value);
+float halfToFloat(uint16_t value);
+
+// bulk conversion for texels, uses f16c when the cpu has it and sse2 otherwise
+void floatToHalfArray(const float* values, uint16_t* halves, std::size_t count);
+
+// the paths of the bulk conversion, every one gives the same bits as floatToHalf
+enum class HalfKernel
+{
+	SCALAR,
+	SSE2,
+	F16C
+};
+
+// false when the build or the cpu lacks the path, which must not be passed to floatToHalfArray then
+bool halfKernelSupported(HalfKernel kernel);
+void floatToHalfArray(const float* values, uint16_t* halves, std::size_t count, HalfKernel kernel);
+
+int8_t packSnorm8(float value);
+uint8_t packUnorm8(float value);
+int16_t packSnorm16(float value);
+uint16_t packUnorm16(float value);
+uint32_t packSnorm2101010(float x, float y, float z, float w);
+uint32_t packUnorm2101010(float x, float y, float z, float w);
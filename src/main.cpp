@@ -3,63 +3,159 @@
 #include "utils.hpp"
 #include "winevents.hpp"
 #include "scene/scene.hpp"
+#include "core/threadpool.hpp"
+#include "core/startup.hpp"
+#include "core/renderthread.hpp"
+#include "core/framestats.hpp"
+#include "core/trace.hpp"
+#include "gl/glcounters.hpp"
 
 #include <chrono>
+#include <fstream>
 
 int main()
 {
+	Trace::nameThread("main");
+
+	ThreadPool pool;
+	Startup startup(pool);
+
+	// declared before the scene so the scene's gl objects are released first
+	Renderer::Window window;
+	Renderer::Render renderer;
+
+	// decode and generate on the pool while the window and context come up
+	Scene scene;
+	scene.Preload(startup);
+
 	// initialize the window
-	Renderer::Window::GLFWInit();
+	startup.run("glfw init", []() { Renderer::Window::GLFWInit(); });
 
 	WinEvents* windowEvents = new WinEvents();
-	KeyHeldContainer& getKeysHeld = windowEvents->getKeysHeld();
 
-	Renderer::Window window;
-	window.addEvents(windowEvents);
-	window.init(WINDOW_WIDTH, WINDOW_HEIGHT, WINDOW_TITLE);
-	window.setVSync(true);
+	startup.run("window", [&]() {
+		window.addEvents(windowEvents);
+		window.init(WINDOW_WIDTH, WINDOW_HEIGHT, WINDOW_TITLE);
+		window.setVSync(true);
+	});
 
 	// initialize the renderer
-	Renderer::Render renderer;
-	renderer.attach(&window);
-	renderer.init();
+	startup.run("renderer", [&]() {
+		renderer.attach(&window);
+		renderer.init();
+	});
 
-	// load the texture
-	Renderer::Texture sky;
-	sky.load(&window, "skybox.jpg");
+	// counts every gl call from here on, the library's included
+	GLCounters::install();
 
 	// GL Enables
 	glEnable(GL_DEPTH_TEST);
 
 	// Create the scene
-	Scene scene;
-	scene.Init(&window, &renderer);
+	startup.run("scene init", [&]() { scene.Init(&window, &renderer, startup); });
 
 	windowEvents->trackScene(&scene);
-	scene.trackKeysHeld(&getKeysHeld);
+	scene.trackInput(&windowEvents->getInput());
+
+	FrameStats stats(FRAME_STATS_WINDOW);
+	scene.trackStats(&stats);
+	FrameStats::writeCsvHeader(std::cout);
+	// summaries sort the window, so they are written from the pool and never in the frame
+	ThreadPool::JobHandle reporting;
+	std::future<void> traceWritten;
+
+	// uploads made while loading are not part of any frame
+	GLCounters::endFrame();
+
+	// from here on the context belongs to the render thread, this one handles events and simulation
+	RenderThread renderThread(RENDER_QUEUE_DEPTH);
+	renderThread.start(window);
+
+	// the first update runs alone, after that each one overlaps the previous frame's draw
+	scene.BeginUpdate();
 
 	auto start = std::chrono::steady_clock::now();
+	auto launch = start;
+	auto lastReport = start;
 
 	while(window.isOpened())
 	{
 		auto end = std::chrono::steady_clock::now();
-		auto elapse_time = end - start;
-		double dt = std::chrono::duration_cast<std::chrono::duration<double>>(elapse_time).count();
-		std::cout << 1.0 / dt << "\n";
+		stats.record(FrameTiming::FRAME, std::chrono::duration<double, std::milli>(end - start).count());
 		start = end;
 
-		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-		
-		scene.ClearBuffers();
-		scene.Update();
-		scene.Render();
-
-		renderer.render();
-
-		getKeysHeld.update();
-		window.swapBuffers();
+		// a finished capture is written on the pool
+		if(Trace::frame())
+			traceWritten = pool.submit([]() { Trace::write(TRACE_PATH); });
+
+		if(std::chrono::duration<double>(end - lastReport).count() >= FRAME_STATS_INTERVAL && (!reporting || reporting->isDone()))
+		{
+			double seconds = std::chrono::duration<double>(end - launch).count();
+			reporting = pool.schedule([&stats, seconds]() { stats.writeCsv(std::cout, seconds); });
+			lastReport = end;
+		}
+
+		// draw the frame that was simulated while the last one was drawn, and simulate the next
+		{
+			TRACE_SCOPE("FinishUpdate");
+			scene.FinishUpdate();
+		}
+		SceneSnapshot snapshot = scene.getSnapshot();
+		scene.BeginUpdate();
+
+		// blocks once the render thread is the queue depth behind, which paces this loop
+		renderThread.submit([&, snapshot]() {
+			TRACE_SCOPE("render frame");
+
+			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+			auto renderStart = std::chrono::steady_clock::now();
+			scene.ClearBuffers();
+			scene.Render(snapshot);
+
+			{
+				TRACE_SCOPE("Render::render");
+				TRACE_GPU_SCOPE(scene.getGpuTrace(), "batch flush");
+				renderer.render();
+			}
+			auto swapStart = std::chrono::steady_clock::now();
+			{
+				TRACE_SCOPE("swapBuffers");
+				window.swapBuffers();
+			}
+			auto swapEnd = std::chrono::steady_clock::now();
+
+			stats.record(FrameTiming::RENDER, std::chrono::duration<double, std::milli>(swapStart - renderStart).count());
+			stats.record(FrameTiming::SWAP, std::chrono::duration<double, std::milli>(swapEnd - swapStart).count());
+			GLCounters::record(stats, GLCounters::endFrame());
+
+			if(!startup.isFinished())
+			{
+				startup.firstFrame();
+				startup.report(std::cout);
+			}
+		});
+
+		TRACE_SCOPE("pollEvents");
 		Renderer::Window::pollEvents();
 	}
 
+	// the scene and window release their gl objects on this thread
+	renderThread.stop();
+
+	// nothing may record or report into the stats once they go out of scope
+	scene.FinishUpdate();
+	if(reporting)
+		pool.wait(reporting);
+	if(traceWritten.valid())
+		traceWritten.wait();
+	std::ofstream statsFile(FRAME_STATS_PATH);
+	stats.writeJson(statsFile);
+
+	GLCounters::report(std::cout, GLCounters::getLastFrame());
+
+	// how much of the run each worker spent on tasks
+	pool.report(std::cout);
+
 	return 0;
 }
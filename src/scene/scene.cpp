@@ -1,18 +1,60 @@
 #include "scene.hpp"
 
+#include <chrono>
+#include <ctime>
+#include <filesystem>
+
 Scene::Scene()
-	: window{ nullptr }, renderer{ nullptr }, position{ 0, 2, 0 }, lookat{ 0, 0, -1 }, up{ 0, 1, 0 },
-	keysHeld{ nullptr }
+	: window{ nullptr }, renderer{ nullptr }, textures{ TEXTURE_BUDGET }, texturesEvicted{ 0 }, bakesPinned{ false }, skyPinned{ 0 }, pool{ nullptr }, screenshotRequested{ false }, screenshotCount{ 0 },
+	time{ 0.f }, position{ 0, 2, 0 }, lookat{ 0, 0, -1 }, up{ 0, 1, 0 }, front{ 0 }, input{ nullptr }, stats{ nullptr }
 {
-	viewMatrix = genViewMatrix(position, lookat, up);
+	snapshots[0] = { position, genViewMatrix(position, lookat, up), time };
+	snapshots[1] = snapshots[0];
+
+	// create the projection matrix
+	float fov = PI / 4.f;
+	float aspect = static_cast<float>(WINDOW_WIDTH) / static_cast<float>(WINDOW_HEIGHT);
+	float far = 5000.f;
+	float near = 1.f;
+	projectionMatrix = Renderer::Mat4<float>(
+			1.f / (aspect * std::tan(fov / 2.f)), 0.f, 0.f, 0.f,
+			0.f, 1.f / (std::tan(fov / 2.f)), 0.f, 0.f,
+			0.f, 0.f, -(far + near) / (far - near), -2.f * far * near / (far - near),
+			0.f, 0.f, -1.f, 0.f
+	);
 }
 
-void Scene::Init(Renderer::Window* windowPtr, Renderer::Render* rendererPtr)
+void Scene::Preload(Startup& startup)
+{
+	environment.load(SKYBOX_PATH, startup);
+	brdf.generate(startup);
+	water.Preload(startup, environment.getMaxLod());
+	if(SKY_BACKDROP)
+		sky.Preload(SKYBOX_PATH, startup);
+}
+
+void Scene::Init(Renderer::Window* windowPtr, Renderer::Render* rendererPtr, Startup& startup)
 {
 	window = windowPtr;
 	renderer = rendererPtr;
 
-	water.Init(window, renderer);
+	environment.Init();
+	brdf.Init();
+	textures.Init(startup.getPool());
+	readback.Init();
+	gpuTrace.Init();
+	pool = &startup.getPool();
+
+	startup.run("program cache", [this]() { programCache.Init(); });
+	startup.run("shader compiler", [this]() { shaderCompiler.Init(window); });
+	frameUniforms.Init();
+	if(SKY_BACKDROP)
+		startup.run("sky init", [this]() { sky.Init(window, renderer, frameUniforms, programCache, textures); });
+	startup.run("water init", [this, &startup]() {
+		water.Init(window, renderer, startup, frameUniforms, programCache, shaderCompiler);
+	});
+
+	programCache.report(std::cout);
 }
 
 void Scene::ClearBuffers()
@@ -20,45 +62,184 @@ void Scene::ClearBuffers()
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 }
 
-void Scene::Render()
+void Scene::Render(const SceneSnapshot& snapshot)
 {
-	water.Render(viewMatrix, position);
+	TRACE_SCOPE("Scene::Render");
+
+	// gpu zones of earlier frames
+	gpuTrace.update();
+
+	// upload the camera and time once for every program
+	frameUniforms.update(snapshot.viewMatrix, projectionMatrix, snapshot.position, snapshot.time);
+
+	// pick up shaders that finished compiling in the background
+	shaderCompiler.poll();
+
+	environment.update();
+	environment.bind(0);
+	brdf.update();
+	brdf.bind(1);
+
+	// the bakes never change size once they land, the sky only when it streams a level in or out
+	if(!bakesPinned && environment.isReady() && brdf.isReady())
+	{
+		textures.pin("environment", environment.getMemorySize());
+		textures.pin("brdf lut", brdf.getMemorySize());
+		bakesPinned = true;
+	}
+
+	if(SKY_BACKDROP)
+	{
+		TRACE_GPU_SCOPE(gpuTrace, "sky");
+		sky.Render(projectionMatrix);
+
+		std::size_t sky_bytes = sky.getMemorySize();
+		if(sky_bytes != skyPinned)
+		{
+			textures.pin("sky", sky_bytes);
+			skyPinned = sky_bytes;
+		}
+	}
+
+	{
+		TRACE_GPU_SCOPE(gpuTrace, "water");
+		water.Render();
+	}
+
+	// uploads reloaded textures and evicts past the budget, after the frame has marked what it used
+	textures.update();
+	if(stats)
+	{
+		TextureUsage usage = textures.getUsage();
+		stats->record(FrameCounter::RESIDENT_TEXTURE_BYTES, static_cast<double>(usage.resident + usage.pinned));
+		stats->record(FrameCounter::TEXTURE_EVICTIONS, static_cast<double>(usage.evictions + usage.downsamples - texturesEvicted));
+		texturesEvicted = usage.evictions + usage.downsamples;
+	}
+
+	// hands over reads from earlier frames, then queues this one if asked to
+	readback.update();
+	if(screenshotRequested)
+	{
+		GLint viewport[4];
+		glGetIntegerv(GL_VIEWPORT, viewport);
+		screenshotRequested = !readback.readFramebuffer(viewport[0], viewport[1], viewport[2], viewport[3],
+				[this](const ReadbackResult& result) { saveScreenshot(result); });
+	}
 }
 
-void Scene::Update()
+void Scene::saveScreenshot(const ReadbackResult& result)
 {
-	viewMatrix = genViewMatrix(position, lookat, up);
+	// png rows go from the top, gl read them from the bottom
+	std::size_t row_bytes = static_cast<std::size_t>(result.width) * 4;
+	std::vector<unsigned char> pixels(result.size);
+	for(unsigned int y=0;y<result.height;++y)
+		memcpy(pixels.data() + y * row_bytes, result.data + (result.height - 1 - y) * row_bytes, row_bytes);
 
-	if(!keysHeld)
+	char filename[64];
+	std::snprintf(filename, sizeof(filename), "./screenshots/%lld-%u.png",
+			static_cast<long long>(std::time(nullptr)), screenshotCount++);
+
+	// encoding takes far longer than a frame, keep it off the render thread
+	std::string path = filename;
+	unsigned int width = result.width;
+	unsigned int height = result.height;
+	pool->submit([path, width, height, pixels = std::move(pixels)]() {
+		std::error_code err;
+		std::filesystem::create_directories("./screenshots", err);
+		if(stbi_write_png(path.c_str(), width, height, 4, pixels.data(), static_cast<int>(width * 4)))
+			std::cout << "saved " << path << "\n";
+		else
+			std::cout << "unable to save " << path << "\n";
+	});
+}
+
+void Scene::BeginUpdate()
+{
+	if(updating)
+		FinishUpdate();
+
+	// events the ring could not take yet, the update collects on another thread
+	if(input)
+		input->flush();
+
+	SceneSnapshot& back = snapshots[1 - front];
+	updating = pool->schedule([this, &back]() {
+		auto start = std::chrono::steady_clock::now();
+		Update(back);
+
+		// updates never overlap, so the ring keeps a single writer even as workers change
+		if(stats)
+			stats->record(FrameTiming::UPDATE, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+	});
+}
+
+void Scene::FinishUpdate()
+{
+	if(!updating)
+		return;
+
+	// release the handle first so a throwing update is not waited on again
+	ThreadPool::JobHandle job = std::move(updating);
+	pool->wait(job);
+	front = 1 - front;
+}
+
+void Scene::Update(SceneSnapshot& snapshot)
+{
+	TRACE_SCOPE("Scene::Update");
+
+	time += 0.05f;
+
+	// the view and position handed over always come from the same step
+	snapshot.time = time;
+	snapshot.position = position;
+	snapshot.viewMatrix = genViewMatrix(position, lookat, up);
+
+	if(!input)
 		return;
 
+	InputFrame frame = input->collect();
+
 	Renderer::Vec3<float> right = lookat.cross(up);
 	Renderer::Vec3<float> forward = up.cross(right);
 
-	if(keysHeld->keyAt(GLFW_KEY_W))
-		position = position + forward * 10.f;
-	if(keysHeld->keyAt(GLFW_KEY_S))
-		position = position - forward * 10.f;
-	if(keysHeld->keyAt(GLFW_KEY_A))
-		position = position - right * 10.f;
-	if(keysHeld->keyAt(GLFW_KEY_D))
-		position = position + right * 10.f;
-	if(keysHeld->keyAt(GLFW_KEY_Q))
-		position = position - up * 10.f;
-	if(keysHeld->keyAt(GLFW_KEY_E))
-		position = position + up * 10.f;
-
-	if(keysHeld->mouseButtonAt(GLFW_MOUSE_BUTTON_LEFT) &&
-			keysHeld->keyAt(GLFW_KEY_LEFT_SHIFT))
+	// moves by how long each key was really held, so a tap shorter than a frame still moves
+	const float speed = 600.f;
+	float along_forward = static_cast<float>(frame.heldFor(GLFW_KEY_W) - frame.heldFor(GLFW_KEY_S)) * speed;
+	float along_right = static_cast<float>(frame.heldFor(GLFW_KEY_D) - frame.heldFor(GLFW_KEY_A)) * speed;
+	float along_up = static_cast<float>(frame.heldFor(GLFW_KEY_E) - frame.heldFor(GLFW_KEY_Q)) * speed;
+	position = position + forward * along_forward + right * along_right + up * along_up;
+
+	// looks around by every cursor move made while shift and the left button were both held
+	float one_over_focal_dist = 1.f / 1024.f;
+	float diffx = 0.f;
+	float diffy = 0.f;
+	InputState state = frame.getStart();
+	for(const InputEvent& event : frame.getEvents())
 	{
-		float one_over_focal_dist = 1.f / 1024.f;
-		float diffx = (keysHeld->mouseX - keysHeld->pmouseX) * one_over_focal_dist;
-		float diffy = (keysHeld->mouseY - keysHeld->pmouseY) * one_over_focal_dist;
+		if(event.type == InputType::MOUSE_MOVE &&
+				state.buttonDown(GLFW_MOUSE_BUTTON_LEFT) && state.keyDown(GLFW_KEY_LEFT_SHIFT))
+		{
+			diffx += static_cast<float>(event.x - state.mouseX) * one_over_focal_dist;
+			diffy += static_cast<float>(event.y - state.mouseY) * one_over_focal_dist;
+		}
+		state.apply(event);
+	}
 
+	if(diffx != 0.f || diffy != 0.f)
+	{
 		lookat = lookat + right * -diffx + up * diffy;
 		lookat.normalize();
 	}
 }
 
 Scene::~Scene()
-{ }
+{
+	// the update in flight writes into this scene
+	try
+	{
+		FinishUpdate();
+	}
+	catch(...)
+	{ }
+}
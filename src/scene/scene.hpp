@@ -3,7 +3,29 @@
 #include <renderer/Renderer.hpp>
 
 #include "../utils.hpp"
+#include "../gl/frameuniforms.hpp"
+#include "../gl/programcache.hpp"
+#include "../gl/shadercompiler.hpp"
+#include "../gl/environmentmap.hpp"
+#include "../gl/brdflut.hpp"
+#include "../gl/textureresidency.hpp"
+#include "../gl/asyncreadback.hpp"
+#include "../gl/gputrace.hpp"
+#include "../core/startup.hpp"
+#include "../core/inputqueue.hpp"
+#include "../core/framestats.hpp"
 #include "terrain.hpp"
+#include "sky.hpp"
+
+// what Render draws, written by one update and left alone after it is handed over
+struct SceneSnapshot
+{
+	Renderer::Vec3<float> position;
+	Renderer::Mat4<float> viewMatrix;
+
+	// drives the waves in the surface shader
+	float time;
+};
 
 class Scene
 {
@@ -11,13 +33,34 @@ class Scene
 		Scene();
 		~Scene();
 
-		void Init(Renderer::Window* windowPtr, Renderer::Render* rendererPtr);
+		// cpu only setup, safe to call before the window exists
+		void Preload(Startup& startup);
+		void Init(Renderer::Window* windowPtr, Renderer::Render* rendererPtr, Startup& startup);
 
 		void ClearBuffers();
-		void Render();
-		void Update();
+		void Render(const SceneSnapshot& snapshot);
+
+		// simulates the next frame on the pool from a copy of the input held right now,
+		// so it overlaps with drawing the current one
+		void BeginUpdate();
+		// waits for the update and makes its snapshot the one Render draws
+		void FinishUpdate();
+
+		// the state the last finished update handed over, copy it before the next BeginUpdate
+		const SceneSnapshot& getSnapshot() const { return snapshots[front]; };
+
+		void trackInput(InputQueue* inputQueue) { input = inputQueue; };
+		// times each update, and writes the texture budget's totals after every frame
+		void trackStats(FrameStats* frameStats) { stats = frameStats; };
+
+		// gpu texture memory for dashboards
+		const TextureResidency& getTextures() const { return textures; };
+
+		// saves the next frame as a png once the gpu has it, without stalling
+		void requestScreenshot() { screenshotRequested = true; };
 
-		void trackKeysHeld(const KeyHeldContainer* getKeysHeld) { keysHeld = getKeysHeld; };
+		// gpu zones for passes outside the scene, render thread only
+		GpuTrace& getGpuTrace() { return gpuTrace; };
 
 	private:
 		Renderer::Window* window;
@@ -25,13 +68,54 @@ class Scene
 
 		Water water;
 
-		// camera parameters
+		// the backdrop when SKY_BACKDROP is set, its texture is bound to slot 2
+		Sky sky;
+
+		// baked from the sky image on the pool, bound to slot 0
+		EnvironmentMap environment;
+
+		// split sum brdf table, bound to slot 1
+		BrdfLut brdf;
+
+		// keeps textures inside the memory budget, the environment and table are pinned
+		TextureResidency textures;
+		// downsamples and evictions already written to the stats
+		uint64_t texturesEvicted;
+		// what the budget was last told about the textures owned elsewhere
+		bool bakesPinned;
+		std::size_t skyPinned;
+
+		// frames read back for screenshots, encoded and written on the pool
+		AsyncReadback readback;
+		GpuTrace gpuTrace;
+		ThreadPool* pool;
+		// set from the event thread, read where the frame is drawn
+		std::atomic<bool> screenshotRequested;
+		unsigned int screenshotCount;
+
+		void saveScreenshot(const ReadbackResult& result);
+
+		// per-frame uniforms shared by every program
+		FrameUniforms frameUniforms;
+		ProgramCache programCache;
+		ShaderCompiler shaderCompiler;
+
+		// simulation state, only touched by the update in flight
+		float time;
 		Renderer::Vec3<float> position;
 		Renderer::Vec3<float> lookat;
 		Renderer::Vec3<float> up;
 
-		Renderer::Mat4<float> viewMatrix;
+		Renderer::Mat4<float> projectionMatrix;
+
+		// Render reads the front snapshot while the update writes the other one
+		SceneSnapshot snapshots[2];
+		int front;
+		ThreadPool::JobHandle updating;
+
+		// movement control, collected by the update on whichever worker runs it
+		InputQueue* input;
+		FrameStats* stats;
 
-		// movement control
-		const KeyHeldContainer* keysHeld;
+		void Update(SceneSnapshot& snapshot);
 };
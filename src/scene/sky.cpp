@@ -0,0 +1,68 @@
+#include "sky.hpp"
+#include "../core/trace.hpp"
+
+Sky::Sky()
+	: window{ nullptr }, renderer{ nullptr }, textures{ nullptr }, handle{ 0 }
+{ }
+
+void Sky::Preload(const char* imagePath, Startup& startup)
+{
+	path = imagePath;
+	if(SKY_STREAMED)
+		texture.load(imagePath, startup);
+}
+
+void Sky::Init(Renderer::Window* windowPtr, Renderer::Render* rendererPtr, FrameUniforms& frameUniforms,
+		ProgramCache& programCache, TextureResidency& textureResidency)
+{
+	window = windowPtr;
+	renderer = rendererPtr;
+	textures = &textureResidency;
+
+	if(SKY_STREAMED)
+		texture.Init();
+	else
+		handle = textures->load(path);
+
+	shader.attach(window);
+	programCache.createFromFile(shader, "./shaders/sky.vert", "./shaders/sky.frag");
+	shader.vertexAttribAdd(0, Renderer::AttribType::VEC2);
+	shader.vertexAttribsEnable();
+	frameUniforms.attachShader(shader);
+
+	shader.uniformAdd("u_sky", Renderer::UniformType::INT);
+	shader.setUniformInt("u_sky", TEXTURE_SLOT);
+
+	// clip space corners, the parts past the screen are clipped away
+	VertexLayout layout;
+	layout.add(0, VertexFormat::FLOAT2);
+	backdrop.setLayout(layout);
+	backdrop.beginShape(Renderer::DrawType::TRIANGLE, 3, 0);
+	backdrop.vertex2f(-1.f, -1.f);
+	backdrop.nextVertex();
+	backdrop.vertex2f(3.f, -1.f);
+	backdrop.nextVertex();
+	backdrop.vertex2f(-1.f, 3.f);
+	backdrop.endShape();
+	backdrop.compile();
+}
+
+void Sky::Render(const Renderer::Mat4<float>& projection)
+{
+	TRACE_SCOPE("Sky::Render");
+
+	if(SKY_STREAMED)
+	{
+		// the image wraps once around the horizon, which spans this many pixels at the centre of the screen
+		float horizon_pixels = static_cast<float>(window->getWidth()) * projection(0, 0) * static_cast<float>(PI);
+		texture.require(StreamingTexture::coverageLod(texture.getWidth(), horizon_pixels));
+		texture.update();
+		texture.bind(TEXTURE_SLOT);
+	}
+	else
+		textures->bind(handle, TEXTURE_SLOT);
+
+	glDepthMask(GL_FALSE);
+	backdrop.draw(*renderer, shader);
+	glDepthMask(GL_TRUE);
+}
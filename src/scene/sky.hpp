@@ -0,0 +1,49 @@
+#pragma once
+
+#include <renderer/Renderer.hpp>
+
+#include "../utils.hpp"
+#include "../core/startup.hpp"
+#include "../gl/frameuniforms.hpp"
+#include "../gl/programcache.hpp"
+#include "../gl/drawlist.hpp"
+#include "../gl/streamingtexture.hpp"
+#include "../gl/textureresidency.hpp"
+
+/*
+ * the sky image drawn behind the water. with SKY_STREAMED the image is streamed, so only the
+ * levels the view resolves are on the gpu, whatever the resolution of the source. otherwise
+ * the whole chain is loaded through the texture budget, which may drop its top levels
+ */
+class Sky
+{
+	public:
+		Sky();
+
+		// opens or cuts the tiled image on the pool, needs no context
+		void Preload(const char* imagePath, Startup& startup);
+
+		void Init(Renderer::Window* windowPtr, Renderer::Render* rendererPtr, FrameUniforms& frameUniforms,
+				ProgramCache& programCache, TextureResidency& textureResidency);
+
+		// draws first in the frame and leaves the depth buffer untouched
+		void Render(const Renderer::Mat4<float>& projection);
+
+		// gpu bytes of the levels streamed in, the budget counts a loaded image itself
+		std::size_t getMemorySize() const { return SKY_STREAMED ? texture.getResidentBytes() : 0; };
+
+		static constexpr unsigned int TEXTURE_SLOT = 2;
+
+	private:
+		Renderer::Window* window;
+		Renderer::Render* renderer;
+
+		std::string path;
+		StreamingTexture texture;
+		TextureResidency* textures;
+		TextureResidency::Handle handle;
+		Renderer::Shader shader;
+
+		// one triangle over the whole screen
+		DrawList backdrop;
+};
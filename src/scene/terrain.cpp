@@ -1,58 +1,109 @@
 #include "terrain.hpp"
+#include "../gl/glutils.hpp"
+#include "../core/trace.hpp"
+
+#include <iostream>
+#include <sstream>
 
 Water::Water()
-	: gridSize{ 10.f }, grids{ 300 }, window{ nullptr }, renderer{ nullptr },
-	t { 0.f }
+	: roughness{ 0.1f }, metallic{ 0.f }, gridSize{ 10.f }, grids{ 300 }, window{ nullptr }, renderer{ nullptr },
+	frameUniforms{ nullptr }, programCache{ nullptr }, shaderCompiler{ nullptr }, pool{ nullptr }, surfaceReady{ false },
+	waveBuffer{ 0 }
 {}
 
-void Water::Init(Renderer::Window* windowPtr, Renderer::Render* rendererPtr)
+void Water::Preload(Startup& startup, float environmentMaxLod)
+{
+	sourcesLoaded = startup.async("shader sources", [this, environmentMaxLod]() {
+		const std::vector<std::string> defines = {
+			"WAVE_COUNT " + std::to_string(WAVE_COUNT),
+			"ENVIRONMENT_MAX_LOD " + std::to_string(environmentMaxLod)
+		};
+		surfaceVertexSource = ProgramCache::applyDefines(ProgramCache::readSource("./shaders/surface.vert"), defines);
+		surfaceFragmentSource = ProgramCache::applyDefines(ProgramCache::readSource("./shaders/surface.frag"), defines);
+		fallbackVertexSource = ProgramCache::readSource("./shaders/flat.vert");
+		fallbackFragmentSource = ProgramCache::readSource("./shaders/flat.frag");
+	});
+
+	// the grid never changes, so record it once and replay it every frame.
+	// grid corners are multiples of the grid size, exact in half floats
+	surfaceRecorded = startup.async("surface grid", [this]() {
+		VertexLayout layout;
+		layout.add(0, VertexFormat::HALF3);
+		surfaceMesh.setLayout(layout);
+		emitSurface(surfaceMesh);
+	});
+
+	wavesGenerated = startup.async("wave table", [this]() {
+		waves = genWaves(WAVE_COUNT);
+	});
+}
+
+void Water::Init(Renderer::Window* windowPtr, Renderer::Render* rendererPtr, Startup& startup,
+		FrameUniforms& frameUniformsRef, ProgramCache& programCacheRef, ShaderCompiler& shaderCompilerRef)
 {
 	window = windowPtr;
 	renderer = rendererPtr;
+	frameUniforms = &frameUniformsRef;
+	programCache = &programCacheRef;
+	shaderCompiler = &shaderCompilerRef;
+	pool = &startup.getPool();
 
-	// setup the vertex attributes
+	startup.wait("wait shader sources", sourcesLoaded);
+
+	// the flat shader is tiny, so it is ready before the first frame
+	fallbackShader.attach(window);
+	programCache->create(fallbackShader, fallbackVertexSource, fallbackFragmentSource);
+	fallbackShader.vertexAttribAdd(0, Renderer::AttribType::VEC3);
+	fallbackShader.vertexAttribsEnable();
+	frameUniforms->attachShader(fallbackShader);
+
+	// load the surface shader from the cache or compile it in the background
 	surfaceShader.attach(window);
-	surfaceShader.createFromFile("./shaders/surface.vert", "./shaders/surface.frag", true);
-	surfaceShader.vertexAttribAdd(0, Renderer::AttribType::VEC3);
-	//surfaceShader.vertexAttribAdd(1, Renderer::AttribType::VEC3);
-	surfaceShader.vertexAttribsEnable();
+	if(programCache->load(surfaceShader, surfaceVertexSource, surfaceFragmentSource))
+		setupSurfaceShader();
+	else
+		pendingSurface = shaderCompiler->submit(surfaceVertexSource, surfaceFragmentSource);
 
-	// setup the uniform variables
-	surfaceShader.uniformAdd("u_projection", Renderer::UniformType::MAT4);
-	surfaceShader.uniformAdd("u_view", Renderer::UniformType::MAT4);
-	surfaceShader.uniformAdd("u_camera", Renderer::UniformType::VEC3);
-	surfaceShader.uniformAdd("u_skybox", Renderer::UniformType::INT);
-	surfaceShader.uniformAdd("u_time", Renderer::UniformType::FLOAT);
-	
-	// texture bound to slot 0 ... cuz there's only 1 image lul
-	surfaceShader.setUniformInt("u_skybox", 0);
-	surfaceShader.setUniformFloat("u_time", t);
-
-	// create the projection matrix
-	float fov = PI / 4.f;
-	float aspect = static_cast<float>(WINDOW_WIDTH) / static_cast<float>(WINDOW_HEIGHT);
-	std::cout << aspect << "\n";
-	float far = 5000.f;
-	float near = 1.f;
-	Renderer::Mat4<float> projection(
-			1.f / (aspect * std::tan(fov / 2.f)), 0.f, 0.f, 0.f,
-			0.f, 1.f / (std::tan(fov / 2.f)), 0.f, 0.f,
-			0.f, 0.f, -(far + near) / (far - near), -2.f * far * near / (far - near),
-			0.f, 0.f, -1.f, 0.f
-	);
-	surfaceShader.setUniformMatrix("u_projection", *projection);
+	startup.wait("wait wave table", wavesGenerated);
+	WaveData wave_data = packWaves(waves);
+	glGenBuffers(1, &waveBuffer);
+	glBindBuffer(GL_UNIFORM_BUFFER, waveBuffer);
+	glBufferData(GL_UNIFORM_BUFFER, sizeof(WaveData), &wave_data, GL_STATIC_DRAW);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+	glBindBufferBase(GL_UNIFORM_BUFFER, WAVE_BINDING, waveBuffer);
+
+	startup.wait("wait surface grid", surfaceRecorded);
+	surfaceMesh.compile();
 }
 
-void Water::Render(const Renderer::Mat4<float>& view, const Renderer::Vec3<float>& position)
+void Water::Render()
 {
-	t += 0.05;
-	// rendering stuff
-	surfaceShader.setUniformMatrix("u_view", *view);
-	surfaceShader.setUniformFloat("u_camera", *position);
-	surfaceShader.setUniformFloat("u_time", t);
+	TRACE_SCOPE("Water::Render");
 
-	renderer->bindShader(&surfaceShader);
+	if(pendingSurface && pendingSurface->isDone())
+	{
+		// a program that failed leaves the fallback drawing, the report carries its log.
+		// the binary is already in memory, only the disk and the console are left to the pool
+		if(shaderCompiler->install(*pendingSurface, surfaceShader))
+		{
+			programCache->storeAsync(*pool, surfaceVertexSource, surfaceFragmentSource, pendingSurface->format,
+					std::move(pendingSurface->binary), static_cast<float>(pendingSurface->compileLatency));
+			setupSurfaceShader();
+		}
+		pendingSurface.reset();
+
+		// formatted from the stats as they are now, the render thread keeps updating them
+		std::ostringstream report;
+		shaderCompiler->report(report);
+		pool->submit([report = report.str()]() { std::cout << report; });
+	}
+
+	surfaceMesh.draw(*renderer, surfaceReady ? surfaceShader : fallbackShader);
+}
 
+template<typename Target>
+void Water::emitSurface(Target& target)
+{
 	// offsets
 	float offset_x = -grids / 2.f * gridSize;
 	float offset_z = -100.f;
@@ -63,24 +114,117 @@ void Water::Render(const Renderer::Mat4<float>& view, const Renderer::Vec3<float
 	{
 		for(int col=0;col<grids;++col)
 		{
-			renderer->beginShape(Renderer::DrawType::TRIANGLE, 4, 0);
+			target.beginShape(Renderer::DrawType::TRIANGLE, 4, 0);
 
-			renderer->vertex3f(offset_x + col * gridSize, offset_y, offset_z + row * -gridSize);
-			renderer->nextVertex();
+			target.vertex3f(offset_x + col * gridSize, offset_y, offset_z + row * -gridSize);
+			target.nextVertex();
 
-			renderer->vertex3f(offset_x + col * gridSize, offset_y, offset_z + row * -gridSize - gridSize);
-			renderer->nextVertex();
+			target.vertex3f(offset_x + col * gridSize, offset_y, offset_z + row * -gridSize - gridSize);
+			target.nextVertex();
 
-			renderer->vertex3f(offset_x + col * gridSize + gridSize, offset_y, offset_z + row * -gridSize - gridSize);
-			renderer->nextVertex();
+			target.vertex3f(offset_x + col * gridSize + gridSize, offset_y, offset_z + row * -gridSize - gridSize);
+			target.nextVertex();
 
-			renderer->vertex3f(offset_x + col * gridSize + gridSize, offset_y, offset_z + row * -gridSize);
+			target.vertex3f(offset_x + col * gridSize + gridSize, offset_y, offset_z + row * -gridSize);
 
-			renderer->endShape();
+			target.endShape();
 		}
 	}
 }
 
+void Water::setupSurfaceShader()
+{
+	// setup the vertex attributes
+	surfaceShader.vertexAttribAdd(0, Renderer::AttribType::VEC3);
+	//surfaceShader.vertexAttribAdd(1, Renderer::AttribType::VEC3);
+	surfaceShader.vertexAttribsEnable();
+
+	// camera, projection and time come from the shared FrameData block
+	frameUniforms->attachShader(surfaceShader);
+
+	GLuint program = getShaderProgram(surfaceShader);
+	GLuint wave_block = glGetUniformBlockIndex(program, "WaveData");
+	if(wave_block == GL_INVALID_INDEX)
+		throw Renderer::ShaderOperationRejected("Surface shader does not declare the WaveData uniform block!");
+	glUniformBlockBinding(program, wave_block, WAVE_BINDING);
+
+	// setup the uniform variables
+	surfaceShader.uniformAdd("u_environment", Renderer::UniformType::INT);
+	surfaceShader.uniformAdd("u_brdf", Renderer::UniformType::INT);
+	surfaceShader.uniformAdd("u_roughness", Renderer::UniformType::FLOAT);
+	surfaceShader.uniformAdd("u_metallic", Renderer::UniformType::FLOAT);
+
+	// environment on slot 0, brdf table on slot 1
+	surfaceShader.setUniformInt("u_environment", 0);
+	surfaceShader.setUniformInt("u_brdf", 1);
+	surfaceShader.setUniformFloat("u_roughness", roughness);
+	surfaceShader.setUniformFloat("u_metallic", metallic);
+
+	surfaceReady = true;
+}
+
+std::vector<Wave> Water::genWaves(int count)
+{
+	// random directions in radians, the phase of each wave borrows a later direction
+	static const float directions[32] = {
+		1.9891f, 3.5761f, 4.6339f, 2.4745f, 0.9422f, 5.7762f, 0.8844f, 5.8013f,
+		2.4747f, 1.4858f, 5.8211f, 6.1632f, 0.5832f, 3.789f, 2.9289f, 3.5984f,
+		3.5903f, 4.4767f, 2.6153f, 0.8599f, 3.5821f, 1.4204f, 0.1132f, 1.9547f,
+		5.3155f, 1.1342f, 2.6258f, 1.6757f, 3.9294f, 2.7729f, 3.2508f, 0.1401f
+	};
+
+	float period = 1000.f;
+	float amplitude = 25.f;
+
+	std::vector<Wave> result;
+	for(int i=0;i<count;++i)
+	{
+		Wave wave;
+		wave.spikey = (1.f / 22.f) * i;
+		wave.amplitude = amplitude;
+		wave.period = period;
+		wave.dirX = std::cos(directions[i % 32]);
+		wave.dirY = std::sin(directions[i % 32]);
+		wave.phase = directions[(i + 7) % 32] / (2.f * PI) * period;
+		result.push_back(wave);
+
+		// each wave is smaller and shorter than the last
+		amplitude *= 0.85f;
+		period *= 0.76f;
+	}
+
+	return result;
+}
+
+WaveData Water::packWaves(const std::vector<Wave>& waves)
+{
+	WaveData data{};
+	for(std::size_t i=0;i<waves.size() && i<WAVE_COUNT;++i)
+	{
+		const Wave& wave = waves[i];
+		float wave_number = 2.f * PI / wave.period;
+
+		data.direction[i][0] = wave.dirX;
+		data.direction[i][1] = wave.dirY;
+		data.direction[i][2] = wave_number;
+		data.direction[i][3] = wave.phase;
+
+		data.shape[i][0] = wave.amplitude;
+		data.shape[i][1] = wave.spikey;
+		data.shape[i][2] = wave.spikey / wave_number;
+		data.shape[i][3] = wave.amplitude * wave_number;
+	}
+
+	return data;
+}
+
 Water::~Water()
 {
+	// nothing may still be writing into the members
+	for(std::future<void>* stage : { &sourcesLoaded, &surfaceRecorded, &wavesGenerated })
+		if(stage->valid())
+			stage->wait();
+
+	if(waveBuffer)
+		glDeleteBuffers(1, &waveBuffer);
 }
@@ -2,9 +2,17 @@
 
 #include <renderer/Renderer.hpp>
 #include <cmath>
+#include <future>
+#include <vector>
 
 #include "../utils.hpp"
-#include "terrain.hpp"
+#include "../core/startup.hpp"
+#include "../gl/frameuniforms.hpp"
+#include "../gl/programcache.hpp"
+#include "../gl/shadercompiler.hpp"
+#include "../gl/drawlist.hpp"
+
+#define WAVE_COUNT 10
 
 struct Wave
 {
@@ -14,6 +22,18 @@ struct Wave
 	
 	float dirX;
 	float dirY;
+
+	// distance along the direction the wave starts at
+	float phase;
+};
+
+// std140 layout of the WaveData block in surface.vert
+struct WaveData
+{
+	// xy direction, z wave number, w phase
+	float direction[WAVE_COUNT][4];
+	// x amplitude, y steepness, z horizontal displacement, w slope
+	float shape[WAVE_COUNT][4];
 };
 
 class Water
@@ -22,20 +42,64 @@ class Water
 		Water();
 		~Water();
 
-		void Init(Renderer::Window* windowPtr, Renderer::Render* rendererPtr);
+		// starts the cpu side setup on the pool, before there is a context
+		void Preload(Startup& startup, float environmentMaxLod);
+
+		void Init(Renderer::Window* windowPtr, Renderer::Render* rendererPtr, Startup& startup,
+				FrameUniforms& frameUniformsRef, ProgramCache& programCacheRef, ShaderCompiler& shaderCompilerRef);
+
+		void Render();
 
-		void Render(const Renderer::Mat4<float>& view, const Renderer::Vec3<float>& position);
+		static std::vector<Wave> genWaves(int count);
+		static WaveData packWaves(const std::vector<Wave>& waves);
+
+		static constexpr GLuint WAVE_BINDING = 1;
 	private:
 		// the renderer and window
 		Renderer::Window* window;
 		Renderer::Render* renderer;
 
-		// the shader
+		// shared shader services owned by the scene
+		FrameUniforms* frameUniforms;
+		ProgramCache* programCache;
+		ShaderCompiler* shaderCompiler;
+		// writes the cache entry and prints the compile report once the surface shader lands
+		ThreadPool* pool;
+
+		// the shader, the fallback renders until the surface shader finishes compiling
 		Renderer::Shader surfaceShader;
+		Renderer::Shader fallbackShader;
+		std::shared_ptr<AsyncProgram> pendingSurface;
+		std::string surfaceVertexSource;
+		std::string surfaceFragmentSource;
+		std::string fallbackVertexSource;
+		std::string fallbackFragmentSource;
+		bool surfaceReady;
+
+		// the wave table, generated once and read by the surface shader
+		std::vector<Wave> waves;
+		GLuint waveBuffer;
+
+		// preload stages, Init waits on them before touching the context
+		std::future<void> sourcesLoaded;
+		std::future<void> surfaceRecorded;
+		std::future<void> wavesGenerated;
+
+		// the water grid, recorded once
+		DrawList surfaceMesh;
+
+		// picks the environment mip reflected by the surface
+		float roughness;
+		// 0 for a dielectric like water, blends f0 towards the water colour
+		float metallic;
 
 		// position for the camera
 		float gridSize;
 		int32_t grids;
 
-		float t;
+		void setupSurfaceShader();
+
+		// emits the grid through any beginShape / vertex / endShape target
+		template<typename Target>
+		void emitSurface(Target& target);
 };
@@ -31,15 +31,42 @@ Renderer::Mat4<float> genViewMatrix(
 	);
 }
 
-KeyHeldContainer::KeyHeldContainer()
-	: mouseX{ 0 }, mouseY{ 0 }, pmouseX{ 0 }, pmouseY{ 0 }
+uint64_t hashBytes(const void* data, std::size_t size, uint64_t seed)
 {
-	mouseHeld.fill(false);
-	keysHeld.fill(false);
+	const unsigned char* bytes = static_cast<const unsigned char*>(data);
+	uint64_t hash = seed;
+	for(std::size_t i=0;i<size;++i)
+	{
+		hash ^= bytes[i];
+		hash *= 1099511628211ull;
+	}
+
+	return hash;
+}
+
+uint64_t hashString(const std::string& str, uint64_t seed)
+{
+	// hash the terminator too so "ab" + "c" differs from "a" + "bc"
+	return hashBytes(str.c_str(), str.size() + 1, seed);
 }
 
-void KeyHeldContainer::update()
+float radicalInverse(uint32_t bits)
 {
-	pmouseX = mouseX;
-	pmouseY = mouseY;
+	bits = (bits << 16u) | (bits >> 16u);
+	bits = ((bits & 0x55555555u) << 1u) | ((bits & 0xAAAAAAAAu) >> 1u);
+	bits = ((bits & 0x33333333u) << 2u) | ((bits & 0xCCCCCCCCu) >> 2u);
+	bits = ((bits & 0x0F0F0F0Fu) << 4u) | ((bits & 0xF0F0F0F0u) >> 4u);
+	bits = ((bits & 0x00FF00FFu) << 8u) | ((bits & 0xFF00FF00u) >> 8u);
+	return static_cast<float>(bits) * 2.3283064365386963e-10f;
+}
+
+void sampleGgx(float u, float v, float alpha, float& x, float& y, float& z)
+{
+	float phi = 2.f * PI * u;
+	float cos_theta = std::sqrt((1.f - v) / (1.f + (alpha * alpha - 1.f) * v));
+	float sin_theta = std::sqrt(1.f - cos_theta * cos_theta);
+
+	x = sin_theta * std::cos(phi);
+	y = sin_theta * std::sin(phi);
+	z = cos_theta;
 }
@@ -1,7 +1,8 @@
 #pragma once
 
 #include <random>
-#include <array>
+#include <string>
+#include <cstdint>
 
 #include <renderer/Renderer.hpp>
 
@@ -13,6 +14,28 @@
 #define WINDOW_HEIGHT 768
 #define WINDOW_TITLE "Water Rendering"
 
+// frames the main thread may queue ahead of the render thread, 1 for the least input latency
+#define RENDER_QUEUE_DEPTH 2
+
+// frame timings: samples kept per timing, seconds between csv rows on stdout and the summary written on exit
+#define FRAME_STATS_WINDOW 600
+#define FRAME_STATS_INTERVAL 5.0
+#define FRAME_STATS_PATH "frame_stats.json"
+
+// F11 captures this many frames of cpu and gpu zones as a chrome trace
+#define TRACE_CAPTURE_FRAMES 120
+#define TRACE_PATH "trace.json"
+
+#define SKYBOX_PATH "skybox.jpg"
+
+// draws the sky image behind the water, streamed in tiles from a copy cut on the first run
+#define SKY_BACKDROP 1
+// 0 loads the whole sky chain through the texture budget instead, which downsamples and evicts it when over
+#define SKY_STREAMED 1
+
+// gpu bytes the managed textures may take, pinned ones included
+#define TEXTURE_BUDGET (256 << 20)
+
 // randoms
 class Random
 {
@@ -30,24 +53,12 @@ Renderer::Mat4<float> genViewMatrix(
 		Renderer::Vec3<float> lookat,
 		Renderer::Vec3<float> up);
 
-// key held container
-class KeyHeldContainer
-{
-	public:
-		int32_t mouseX, mouseY;
-		int32_t pmouseX, pmouseY;
-
-		KeyHeldContainer();
-
-		bool keyAt(std::size_t key) const { return keysHeld[key]; };
-		bool mouseButtonAt(std::size_t button) const { return mouseHeld[button]; };
+// 64 bit FNV-1a, chain calls by passing the previous hash as the seed
+uint64_t hashBytes(const void* data, std::size_t size, uint64_t seed = 14695981039346656037ull);
+uint64_t hashString(const std::string& str, uint64_t seed = 14695981039346656037ull);
 
-		void setKey(std::size_t key, bool value) { keysHeld[key] = value; };
-		void setMouseButton(std::size_t button, bool value) { mouseHeld[button] = value; };
+// second coordinate of the hammersley set, i / count is the first
+float radicalInverse(uint32_t bits);
 
-		void update();
-
-	private:
-		std::array<bool, GLFW_MOUSE_BUTTON_LAST> mouseHeld;
-		std::array<bool, GLFW_KEY_LAST> keysHeld;
-};
+// ggx distributed half vector around +z for u, v in [0, 1), alpha is roughness squared
+void sampleGgx(float u, float v, float alpha, float& x, float& y, float& z);
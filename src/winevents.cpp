@@ -6,26 +6,31 @@ WinEvents::WinEvents()
 
 void WinEvents::KeyPressed(int _key, int _scancode, int _mods)
 {
-	keysHeld.setKey(_key, true);
+	input.push(InputType::KEY_DOWN, _key);
+
+	if(_key == GLFW_KEY_F12 && scene)
+		scene->requestScreenshot();
+
+	if(_key == GLFW_KEY_F11)
+		Trace::requestCapture(TRACE_CAPTURE_FRAMES);
 }
 
 void WinEvents::KeyReleased(int _key, int _scancode, int _mods)
 {
-	keysHeld.setKey(_key, false);
+	input.push(InputType::KEY_UP, _key);
 }
 
 void WinEvents::MousePressed(int _button, int _mods)
 {
-	keysHeld.setMouseButton(_button, true);
+	input.push(InputType::BUTTON_DOWN, _button);
 }
 
 void WinEvents::MouseReleased(int _button, int _mods)
 {
-	keysHeld.setMouseButton(_button, false);
+	input.push(InputType::BUTTON_UP, _button);
 }
 
 void WinEvents::MouseMove(double _x, double _y)
 {
-	keysHeld.mouseX = _x;
-	keysHeld.mouseY = _y;
+	input.push(InputType::MOUSE_MOVE, -1, _x, _y);
 }
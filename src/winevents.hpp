@@ -4,6 +4,8 @@
 
 #include "utils.hpp"
 #include "scene/scene.hpp"
+#include "core/inputqueue.hpp"
+#include "core/trace.hpp"
 
 class WinEvents : public Renderer::WindowEvents
 {
@@ -19,9 +21,9 @@ class WinEvents : public Renderer::WindowEvents
 		void MouseReleased(int _button, int _mods) override;
 		void MouseMove(double _x, double _y) override;
 
-		KeyHeldContainer& getKeysHeld() { return keysHeld; };
+		InputQueue& getInput() { return input; };
 
 	private:
 		Scene* scene;
-		KeyHeldContainer keysHeld;
+		InputQueue input;
 };